@@ -37,6 +37,8 @@
 #include <xtensor/xstrided_view.hpp>
 #include <xtensor/xnoalias.hpp>
 #include <xvigra/tiny_vector.hpp>
+#include <xvigra/array_nd.hpp>
+#include <xvigra/transpose.hpp>
 
 #ifdef XVIGRA_USE_SIMD
 #  include <xsimd/xsimd.hpp>
@@ -247,4 +249,141 @@ namespace xvigra
 //     BENCHMARK(copy_simd_aligned);
 // #endif
 
+    // 256 MB of float, much larger than the last-level cache
+    shape_t<3> large_array_shape{256, 512, 512};
+
+    // THREADS == 0 selects the ordinary assignment path without streaming stores
+    template <int THREADS>
+    struct streaming_store_guard
+    {
+        streaming_store_options saved;
+
+        streaming_store_guard()
+        : saved(default_streaming_store_options())
+        {
+            default_streaming_store_options().enabled = THREADS > 0;
+            default_streaming_store_options().thread_count = std::max(THREADS, 1);
+        }
+
+        ~streaming_store_guard()
+        {
+            default_streaming_store_options() = saved;
+        }
+    };
+
+    template <class V, int THREADS>
+    void assign_fill(benchmark::State& state)
+    {
+        streaming_store_guard<THREADS> guard;
+        array_nd<V, 3> data(large_array_shape);
+
+        for (auto _ : state)
+        {
+            data = V(1);
+            benchmark::DoNotOptimize(data.data());
+        }
+        state.SetBytesProcessed(state.iterations() * data.size() * sizeof(V));
+    }
+
+    BENCHMARK_TEMPLATE(assign_fill, float, 0);
+    BENCHMARK_TEMPLATE(assign_fill, float, 1);
+    BENCHMARK_TEMPLATE(assign_fill, float, 4);
+
+    template <class V, int THREADS>
+    void assign_copy(benchmark::State& state)
+    {
+        streaming_store_guard<THREADS> guard;
+        array_nd<V, 3> data(large_array_shape, V(1)),
+                       result(large_array_shape);
+
+        for (auto _ : state)
+        {
+            result = data;
+            benchmark::DoNotOptimize(result.data());
+        }
+        state.SetBytesProcessed(state.iterations() * data.size() * sizeof(V));
+    }
+
+    BENCHMARK_TEMPLATE(assign_copy, float, 0);
+    BENCHMARK_TEMPLATE(assign_copy, float, 1);
+    BENCHMARK_TEMPLATE(assign_copy, float, 4);
+
+    template <class V, int THREADS>
+    void assign_where(benchmark::State& state)
+    {
+        streaming_store_guard<THREADS> guard;
+        array_nd<V, 3> data(large_array_shape, V(0)),
+                       result(large_array_shape);
+        data(128, 256, 256) = V(1);
+
+        for (auto _ : state)
+        {
+            // as in distance_transform_squared()
+            result = xt::where(xt::equal(data, V(0)), V(1e6), V(0));
+            benchmark::DoNotOptimize(result.data());
+        }
+        state.SetBytesProcessed(state.iterations() * data.size() * sizeof(V));
+    }
+
+    BENCHMARK_TEMPLATE(assign_where, float, 0);
+    BENCHMARK_TEMPLATE(assign_where, float, 1);
+    BENCHMARK_TEMPLATE(assign_where, float, 4);
+
+    // THREADS == 0 selects the expression-based assignment of the transposed view
+    template <class V, int THREADS>
+    void transpose_2d(benchmark::State& state)
+    {
+        shape_t<2> shape{8192, 8192};
+        array_nd<V, 2> data(shape, V(1)),
+                       result(shape);
+
+        for (auto _ : state)
+        {
+            if(THREADS == 0)
+            {
+                result = data.transpose();
+            }
+            else
+            {
+                transpose_copy(data.transpose(), result, transpose_options().threads(THREADS));
+            }
+            benchmark::DoNotOptimize(result.data());
+        }
+        state.SetBytesProcessed(state.iterations() * data.size() * sizeof(V));
+    }
+
+    BENCHMARK_TEMPLATE(transpose_2d, float, 0);
+    BENCHMARK_TEMPLATE(transpose_2d, float, 1);
+    BENCHMARK_TEMPLATE(transpose_2d, float, 4);
+    BENCHMARK_TEMPLATE(transpose_2d, double, 1);
+    BENCHMARK_TEMPLATE(transpose_2d, double, 4);
+
+    // channel-last to channel-first conversion
+    template <class V, int THREADS>
+    void transpose_channels(benchmark::State& state)
+    {
+        shape_t<3> shape{4096, 4096, 3};
+        array_nd<V, 3> data(shape, V(1));
+        array_nd<V, 3> result(shape_t<3>{3, 4096, 4096});
+
+        for (auto _ : state)
+        {
+            if(THREADS == 0)
+            {
+                result = data.transpose(shape_t<3>{2, 0, 1});
+            }
+            else
+            {
+                transpose_copy(data.transpose(shape_t<3>{2, 0, 1}), result,
+                               transpose_options().threads(THREADS));
+            }
+            benchmark::DoNotOptimize(result.data());
+        }
+        state.SetBytesProcessed(state.iterations() * data.size() * sizeof(V));
+    }
+
+    BENCHMARK_TEMPLATE(transpose_channels, float, 0);
+    BENCHMARK_TEMPLATE(transpose_channels, float, 1);
+    BENCHMARK_TEMPLATE(transpose_channels, float, 4);
+
 } // namespace xvigra
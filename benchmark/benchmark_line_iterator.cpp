@@ -0,0 +1,131 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <xvigra/line_iterator.hpp>
+#include <xvigra/distance_transform.hpp>
+
+namespace xvigra
+{
+    // 3D arrays with a short axis, e.g. color channels or thin volumes
+    shape_t<3> line_iterator_shape(index_t axis)
+    {
+        shape_t<3> shape{256, 256, 256};
+        shape[axis] = 3;
+        return shape;
+    }
+
+    template <class LINE>
+    inline void cumulative_sum_line(LINE && line)
+    {
+        for(index_t k=1; k<line.shape(0); ++k)
+        {
+            line(k) += line(k-1);
+        }
+    }
+
+    template <class V, int AXIS>
+    void lines_slicer(benchmark::State& state)
+    {
+        array_nd<V, 3> data(line_iterator_shape(AXIS), V(1));
+
+        for (auto _ : state)
+        {
+            slicer nav(data.shape());
+            nav.set_free_axes(AXIS);
+            for(; nav.has_more(); ++nav)
+            {
+                cumulative_sum_line(data.view(*nav));
+            }
+            benchmark::DoNotOptimize(data.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(lines_slicer, float, 0);
+    BENCHMARK_TEMPLATE(lines_slicer, float, 2);
+
+    template <class V, int AXIS>
+    void lines_line_iterator(benchmark::State& state)
+    {
+        array_nd<V, 3> data(line_iterator_shape(AXIS), V(1));
+
+        for (auto _ : state)
+        {
+            for(auto line = make_line_iterator(data, AXIS); line.has_more(); ++line)
+            {
+                cumulative_sum_line(*line);
+            }
+            benchmark::DoNotOptimize(data.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(lines_line_iterator, float, 0);
+    BENCHMARK_TEMPLATE(lines_line_iterator, float, 2);
+
+    template <class V, int AXIS>
+    void lines_raw_pointer(benchmark::State& state)
+    {
+        array_nd<V, 3> data(line_iterator_shape(AXIS), V(1));
+
+        for (auto _ : state)
+        {
+            for(auto line = make_line_iterator(data, AXIS); line.has_more(); ++line)
+            {
+                V * p = line.data();
+                index_t stride = line.stride();
+                for(index_t k=1; k<line.size(); ++k, p += stride)
+                {
+                    p[stride] += p[0];
+                }
+            }
+            benchmark::DoNotOptimize(data.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(lines_raw_pointer, float, 0);
+    BENCHMARK_TEMPLATE(lines_raw_pointer, float, 2);
+
+    template <class V>
+    void distance_transform_short_axis(benchmark::State& state)
+    {
+        array_nd<V, 3> data(shape_t<3>{256, 256, 4}, V(0)),
+                       result(data.shape());
+        data(128, 128, 2) = V(1);
+
+        for (auto _ : state)
+        {
+            distance_transform_squared(data, result);
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(distance_transform_short_axis, float);
+
+} // namespace xvigra
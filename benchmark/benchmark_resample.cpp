@@ -0,0 +1,111 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <xvigra/resample.hpp>
+#include <xvigra/spline_view.hpp>
+
+namespace xvigra
+{
+    template <class V>
+    void resample_2d_naive(benchmark::State& state)
+    {
+        array_nd<V, 2> data(shape_t<2>{1000,1500}),
+                       result(shape_t<2>{1500,2250});
+        data = 1;
+
+        for (auto _ : state)
+        {
+            // per-pixel evaluation of the spline at the corresponding input coordinate
+            spline_view_nd<3, V, 2> spline(data);
+            double sy = (data.shape(0) - 1.0) / (result.shape(0) - 1.0),
+                   sx = (data.shape(1) - 1.0) / (result.shape(1) - 1.0);
+            for(index_t y=0; y<result.shape(0); ++y)
+            {
+                for(index_t x=0; x<result.shape(1); ++x)
+                {
+                    result(y, x) = spline({y*sy, x*sx});
+                }
+            }
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(resample_2d_naive, float);
+
+    template <class V>
+    void resample_2d_no_simd(benchmark::State& state)
+    {
+        array_nd<V, 2> data(shape_t<2>{1000,1500}),
+                       result(shape_t<2>{1500,2250});
+        data = 1;
+
+        for (auto _ : state)
+        {
+            resample(data, result, b_spline<3, double>(), resample_options().use_simd(false));
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(resample_2d_no_simd, float);
+
+    template <class V>
+    void resample_2d_simd(benchmark::State& state)
+    {
+        array_nd<V, 2> data(shape_t<2>{1000,1500}),
+                       result(shape_t<2>{1500,2250});
+        data = 1;
+
+        for (auto _ : state)
+        {
+            resample(data, result, b_spline<3, double>(), resample_options().use_simd(true));
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(resample_2d_simd, float);
+
+    template <class V>
+    void downsample_3d_simd(benchmark::State& state)
+    {
+        array_nd<V, 3> data(shape_t<3>{100,200,300}),
+                       result(shape_t<3>{40,80,120});
+        data = 1;
+
+        for (auto _ : state)
+        {
+            resample(data, result, b_spline<3, double>());
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(downsample_3d_simd, float);
+
+} // namespace xvigra
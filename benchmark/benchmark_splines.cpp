@@ -0,0 +1,105 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <benchmark/benchmark.h>
+#include <xvigra/splines.hpp>
+
+namespace xvigra
+{
+    index_t spline_offset_count = 1000000;
+
+    template <class V, int ORDER>
+    array_nd<V, 1> spline_offsets()
+    {
+        array_nd<V, 1> offsets(shape_t<1>{spline_offset_count});
+        V lower = (ORDER % 2 == 1) ? V(0) : V(-0.5);
+        for(index_t j=0; j<spline_offset_count; ++j)
+        {
+            offsets(j) = lower + V(j % 1000) / V(1000);
+        }
+        return offsets;
+    }
+
+    template <class V, int ORDER>
+    void b_spline_weights_scalar(benchmark::State& state)
+    {
+        array_nd<V, 1> offsets = spline_offsets<V, ORDER>();
+        array_nd<V, 2> weights(shape_t<2>{ORDER+1, spline_offset_count});
+        b_spline<ORDER, V> spline;
+
+        for (auto _ : state)
+        {
+            for(index_t j=0; j<spline_offset_count; ++j)
+            {
+                for(int k=0; k<=ORDER; ++k)
+                {
+                    weights(k, j) = spline(offsets(j) + ORDER/2 - k);
+                }
+            }
+            benchmark::DoNotOptimize(weights.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(b_spline_weights_scalar, float, 3);
+    BENCHMARK_TEMPLATE(b_spline_weights_scalar, float, 5);
+
+    template <class V, int ORDER>
+    void b_spline_weights_batch_no_simd(benchmark::State& state)
+    {
+        array_nd<V, 1> offsets = spline_offsets<V, ORDER>();
+        array_nd<V, 2> weights(shape_t<2>{ORDER+1, spline_offset_count});
+
+        for (auto _ : state)
+        {
+            b_spline_weights<ORDER>(offsets, weights, 0, false);
+            benchmark::DoNotOptimize(weights.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(b_spline_weights_batch_no_simd, float, 3);
+    BENCHMARK_TEMPLATE(b_spline_weights_batch_no_simd, float, 5);
+
+    template <class V, int ORDER>
+    void b_spline_weights_batch_simd(benchmark::State& state)
+    {
+        array_nd<V, 1> offsets = spline_offsets<V, ORDER>();
+        array_nd<V, 2> weights(shape_t<2>{ORDER+1, spline_offset_count});
+
+        for (auto _ : state)
+        {
+            b_spline_weights<ORDER>(offsets, weights, 0, true);
+            benchmark::DoNotOptimize(weights.data());
+        }
+    }
+
+    BENCHMARK_TEMPLATE(b_spline_weights_batch_simd, float, 3);
+    BENCHMARK_TEMPLATE(b_spline_weights_batch_simd, float, 5);
+
+} // namespace xvigra
@@ -28,6 +28,7 @@
 /*                                                                      */
 /************************************************************************/
 
+#include <vector>
 #include <benchmark/benchmark.h>
 #include <xvigra/tiny_vector.hpp>
 
@@ -69,5 +70,87 @@ namespace xvigra
 
     BENCHMARK_TEMPLATE(bm_tiny_vector_loop, tiny_vector<index_t, 4>);
     BENCHMARK_TEMPLATE(bm_tiny_vector_plus, tiny_vector<index_t, 4>);
+    BENCHMARK_TEMPLATE(bm_tiny_vector_loop, tiny_vector<float, 4>);
+    BENCHMARK_TEMPLATE(bm_tiny_vector_plus, tiny_vector<float, 4>);
+    BENCHMARK_TEMPLATE(bm_tiny_vector_loop, tiny_vector<double, 4>);
+    BENCHMARK_TEMPLATE(bm_tiny_vector_plus, tiny_vector<double, 4>);
+
+    // pixel-wise color math on an image of 1024x1024 pixels:
+    // alpha blending followed by a color transform and the luminance
+    template <class V>
+    std::vector<V> make_pixels(typename V::value_type offset)
+    {
+        std::vector<V> res(1 << 20);
+        for(std::size_t k=0; k<res.size(); ++k)
+        {
+            for(index_t c=0; c<res[k].size(); ++c)
+            {
+                res[k][c] = typename V::value_type((k + c) % 256) + offset;
+            }
+        }
+        return res;
+    }
+
+    template <class V>
+    void bm_color_math_loop(benchmark::State& state)
+    {
+        using T = typename V::value_type;
+        std::vector<V> a = make_pixels<V>(T(0)),
+                       b = make_pixels<V>(T(1)),
+                       result(a.size());
+        V gain(V::static_size, T(0.5)),
+          luminance_weights(V::static_size, T(0.25));
+        T alpha = T(0.3);
+
+        for (auto _ : state)
+        {
+            T luminance = T();
+            for(std::size_t k=0; k<a.size(); ++k)
+            {
+                for(index_t c=0; c<V::static_size; ++c)
+                {
+                    result[k][c] = (alpha*a[k][c] + (T(1)-alpha)*b[k][c]) * gain[c];
+                    luminance += result[k][c] * luminance_weights[c];
+                }
+            }
+            benchmark::DoNotOptimize(result.data());
+            benchmark::DoNotOptimize(luminance);
+        }
+        state.SetItemsProcessed(state.iterations() * a.size());
+    }
+
+    template <class V>
+    void bm_color_math_vector(benchmark::State& state)
+    {
+        using T = typename V::value_type;
+        std::vector<V> a = make_pixels<V>(T(0)),
+                       b = make_pixels<V>(T(1)),
+                       result(a.size());
+        V gain(V::static_size, T(0.5)),
+          luminance_weights(V::static_size, T(0.25));
+        T alpha = T(0.3);
+
+        for (auto _ : state)
+        {
+            T luminance = T();
+            for(std::size_t k=0; k<a.size(); ++k)
+            {
+                result[k] = (alpha*a[k] + (T(1)-alpha)*b[k]) * gain;
+                luminance += dot(result[k], luminance_weights);
+            }
+            benchmark::DoNotOptimize(result.data());
+            benchmark::DoNotOptimize(luminance);
+        }
+        state.SetItemsProcessed(state.iterations() * a.size());
+    }
+
+    BENCHMARK_TEMPLATE(bm_color_math_loop, tiny_vector<float, 3>);
+    BENCHMARK_TEMPLATE(bm_color_math_vector, tiny_vector<float, 3>);
+    BENCHMARK_TEMPLATE(bm_color_math_loop, tiny_vector<float, 4>);
+    BENCHMARK_TEMPLATE(bm_color_math_vector, tiny_vector<float, 4>);
+    BENCHMARK_TEMPLATE(bm_color_math_loop, tiny_vector<double, 4>);
+    BENCHMARK_TEMPLATE(bm_color_math_vector, tiny_vector<double, 4>);
+    BENCHMARK_TEMPLATE(bm_color_math_loop, tiny_vector<float, 8>);
+    BENCHMARK_TEMPLATE(bm_color_math_vector, tiny_vector<float, 8>);
 
 } // namespace xvigra
@@ -0,0 +1,239 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_ALLOCATION_COUNTER_HPP
+#define XVIGRA_ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+#include <memory>
+#include <tuple>
+#include "global.hpp"
+
+    // Set to 1 to instrument tiny_vector and array_nd for allocation_counter.
+    // The setting must be identical in all translation units of a program.
+#ifndef XVIGRA_COUNT_ALLOCATIONS
+#  define XVIGRA_COUNT_ALLOCATIONS 0
+#endif
+
+namespace xvigra
+{
+    /*************************/
+    /* allocation_statistics */
+    /*************************/
+
+        /** \brief Number of heap allocations and allocated bytes of
+            <tt>tiny_vector</tt> and <tt>array_nd</tt>.
+        */
+    struct allocation_statistics
+    {
+        index_t tiny_vector_allocations = 0;
+        index_t tiny_vector_bytes = 0;
+        index_t array_nd_allocations = 0;
+        index_t array_nd_bytes = 0;
+
+        index_t allocations() const
+        {
+            return tiny_vector_allocations + array_nd_allocations;
+        }
+
+        index_t bytes() const
+        {
+            return tiny_vector_bytes + array_nd_bytes;
+        }
+
+        allocation_statistics & operator-=(allocation_statistics const & other)
+        {
+            tiny_vector_allocations -= other.tiny_vector_allocations;
+            tiny_vector_bytes       -= other.tiny_vector_bytes;
+            array_nd_allocations    -= other.array_nd_allocations;
+            array_nd_bytes          -= other.array_nd_bytes;
+            return *this;
+        }
+    };
+
+    inline allocation_statistics
+    operator-(allocation_statistics a, allocation_statistics const & b)
+    {
+        return a -= b;
+    }
+
+    namespace detail
+    {
+        struct allocation_totals
+        {
+            std::atomic<index_t> tiny_vector_allocations{0};
+            std::atomic<index_t> tiny_vector_bytes{0};
+            std::atomic<index_t> array_nd_allocations{0};
+            std::atomic<index_t> array_nd_bytes{0};
+        };
+
+        inline allocation_totals & global_allocation_totals()
+        {
+            static allocation_totals totals;
+            return totals;
+        }
+
+        inline void count_tiny_vector_allocation(index_t bytes)
+        {
+        #if XVIGRA_COUNT_ALLOCATIONS
+            auto & totals = global_allocation_totals();
+            totals.tiny_vector_allocations.fetch_add(1, std::memory_order_relaxed);
+            totals.tiny_vector_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        #else
+            std::ignore = bytes;
+        #endif
+        }
+
+        inline void count_array_nd_allocation(index_t bytes)
+        {
+        #if XVIGRA_COUNT_ALLOCATIONS
+            auto & totals = global_allocation_totals();
+            totals.array_nd_allocations.fetch_add(1, std::memory_order_relaxed);
+            totals.array_nd_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        #else
+            std::ignore = bytes;
+        #endif
+        }
+
+            // Allocator adaptor that reports the allocations of 'array_nd' buffers.
+            // It derives from the user's allocator, so that array_nd::get_allocator()
+            // can still return the original type.
+        template <class A>
+        struct counting_allocator
+        : public A
+        {
+            using base_traits = std::allocator_traits<A>;
+            using value_type = typename base_traits::value_type;
+            using pointer = typename base_traits::pointer;
+            using size_type = typename base_traits::size_type;
+
+            template <class U>
+            struct rebind
+            {
+                using other = counting_allocator<typename base_traits::template rebind_alloc<U>>;
+            };
+
+            counting_allocator() = default;
+
+            counting_allocator(A const & a)
+            : A(a)
+            {}
+
+            template <class B>
+            counting_allocator(counting_allocator<B> const & other)
+            : A(static_cast<B const &>(other))
+            {}
+
+            pointer allocate(size_type n)
+            {
+                count_array_nd_allocation((index_t)(n * sizeof(value_type)));
+                return base_traits::allocate(*this, n);
+            }
+
+            void deallocate(pointer p, size_type n)
+            {
+                base_traits::deallocate(*this, p, n);
+            }
+        };
+
+        template <class A, class B>
+        inline bool
+        operator==(counting_allocator<A> const & a, counting_allocator<B> const & b)
+        {
+            return static_cast<A const &>(a) == static_cast<B const &>(b);
+        }
+
+        template <class A, class B>
+        inline bool
+        operator!=(counting_allocator<A> const & a, counting_allocator<B> const & b)
+        {
+            return !(a == b);
+        }
+    } // namespace detail
+
+        /** \brief Total allocations of <tt>tiny_vector</tt> and <tt>array_nd</tt>
+            since program start (in all threads).
+        */
+    inline allocation_statistics current_allocation_statistics()
+    {
+        auto & totals = detail::global_allocation_totals();
+        allocation_statistics res;
+        res.tiny_vector_allocations = totals.tiny_vector_allocations.load(std::memory_order_relaxed);
+        res.tiny_vector_bytes       = totals.tiny_vector_bytes.load(std::memory_order_relaxed);
+        res.array_nd_allocations    = totals.array_nd_allocations.load(std::memory_order_relaxed);
+        res.array_nd_bytes          = totals.array_nd_bytes.load(std::memory_order_relaxed);
+        return res;
+    }
+
+    /**********************/
+    /* allocation_counter */
+    /**********************/
+
+        /** \brief Count the heap allocations of <tt>tiny_vector</tt> and <tt>array_nd</tt>
+            during an operation.
+
+            Only memory that doesn't fit into the inline buffer of a <tt>tiny_vector</tt>
+            (see <tt>XVIGRA_SHAPE_BUFFER_SIZE</tt>) is counted. Allocations of all threads
+            are included. Counting is only active when <tt>XVIGRA_COUNT_ALLOCATIONS</tt>
+            is defined as 1, otherwise all counts remain zero.
+
+            <b>Usage:</b>
+            \code
+            view_nd<float> v = ...;
+            allocation_counter counter;
+            auto line = v.bind(0, 1);
+            assert(counter.count().allocations() == 0);
+            \endcode
+        */
+    class allocation_counter
+    {
+      public:
+        allocation_counter()
+        : start_(current_allocation_statistics())
+        {}
+
+            // allocations since construction or the last call to reset()
+        allocation_statistics count() const
+        {
+            return current_allocation_statistics() - start_;
+        }
+
+        void reset()
+        {
+            start_ = current_allocation_statistics();
+        }
+
+      private:
+        allocation_statistics start_;
+    };
+
+} // namespace xvigra
+
+#endif // XVIGRA_ALLOCATION_COUNTER_HPP
@@ -46,7 +46,10 @@
 #include "error.hpp"
 #include "math.hpp"
 #include "tiny_vector.hpp"
+#include "allocation_counter.hpp"
+#include "pool_allocator.hpp"
 #include "slice.hpp"
+#include "streaming_store.hpp"
 
 // Bounds checking Macro used if VIGRA_CHECK_BOUNDS is defined.
 #ifdef XVIGRA_CHECK_BOUNDS
@@ -462,8 +465,13 @@ namespace xvigra
             {
                 // memory overlaps => we need a temporary
                 semantic_base::assign(xt::xarray<value_type>(rhs));
+                return;
             }
-            else
+            // large contiguous destinations are written with non-temporal stores
+            bool streamed = detail::is_same_shape(shape_, rhs.shape()) &&
+                            detail::is_c_order_contiguous(shape_, strides_) &&
+                            detail::try_streaming_assign(std::is_arithmetic<value_type>(), data_, size(), rhs);
+            if(!streamed)
             {
                 semantic_base::assign(rhs);
             }
@@ -599,7 +607,10 @@ namespace xvigra
                 "vigra_nd::operator=(): cannot assign a value to an empty array.");
             if(is_contiguous())
             {
-                std::fill(data_, data_+size(), v);
+                if(!detail::try_streaming_fill(std::is_arithmetic<value_type>(), data_, size(), v))
+                {
+                    std::fill(data_, data_+size(), v);
+                }
             }
             else
             {
@@ -1650,6 +1661,74 @@ namespace xvigra
         return view_nd<T, (index_t)N>(e);
     }
 
+    namespace detail
+    {
+        template <class T1, index_t N1, class T2, index_t N2, class F>
+        inline void
+        dispatch_static_dimension_impl(std::false_type, view_nd<T1, N1> & in, view_nd<T2, N2> & out, F && f)
+        {
+            f(in, out);
+        }
+
+        template <class T1, index_t N1, class T2, index_t N2, class F>
+        inline void
+        dispatch_static_dimension_impl(std::true_type, view_nd<T1, N1> & in, view_nd<T2, N2> & out, F && f)
+        {
+            if(in.dimension() != out.dimension())
+            {
+                f(in, out);
+                return;
+            }
+            switch(in.dimension())
+            {
+                case 2:
+                {
+                    auto in2  = in.template view<2>();
+                    auto out2 = out.template view<2>();
+                    f(in2, out2);
+                    break;
+                }
+                case 3:
+                {
+                    auto in3  = in.template view<3>();
+                    auto out3 = out.template view<3>();
+                    f(in3, out3);
+                    break;
+                }
+                default:
+                {
+                    f(in, out);
+                }
+            }
+        }
+    } // namespace detail
+
+        /** \brief Call <tt>f(in, out)</tt> with views of static dimension if possible.
+
+            When both views have <tt>runtime_size</tt> dimension and their actual
+            dimension is 2 or 3, they are converted into <tt>view_nd<T, 2></tt> resp.
+            <tt>view_nd<T, 3></tt> before calling 'f', so that slicing, binding and
+            line iteration inside 'f' keep the static dimension. Otherwise, 'f' is
+            called with the original views. 'f' is usually a generic lambda.
+
+            <b>Usage:</b>
+            \code
+            dispatch_static_dimension(in, out, [&](auto & sin, auto & sout)
+            {
+                for(auto line = make_line_iterator(sout, 0); line.has_more(); ++line)
+                    ...
+            });
+            \endcode
+        */
+    template <class T1, index_t N1, class T2, index_t N2, class F>
+    inline void
+    dispatch_static_dimension(view_nd<T1, N1> in, view_nd<T2, N2> out, F && f)
+    {
+        detail::dispatch_static_dimension_impl(
+            std::integral_constant<bool, N1 == runtime_size && N2 == runtime_size>(),
+            in, out, std::forward<F>(f));
+    }
+
     template <class E,
               VIGRA_REQUIRE<has_raw_data_api<E>::value>>
     inline decltype(auto)
@@ -1691,7 +1770,11 @@ namespace xvigra
 
         using raw_value_type = std::decay_t<value_type>;
         using allocator_type = ALLOC;
+    #if XVIGRA_COUNT_ALLOCATIONS
+        using buffer_type = std::vector<raw_value_type, detail::counting_allocator<allocator_type>>;
+    #else
         using buffer_type = std::vector<raw_value_type, allocator_type>;
+    #endif
 
         using self_type = array_nd<T, N, ALLOC>;
         using semantic_base = typename view_type::semantic_base;
@@ -37,6 +37,7 @@
 #include "concepts.hpp"
 #include "math.hpp"
 #include "slice.hpp"
+#include "line_iterator.hpp"
 #include "functor_base.hpp"
 
 namespace xvigra
@@ -78,7 +79,7 @@ namespace xvigra
             }
             double sigma22 = 2.0 * sigma2;
 
-            using influence = distance_parabola_stack_entry<T1>;
+            using influence = distance_parabola_stack_entry<std::remove_const_t<T1>>;
 
             std::vector<influence> _stack;
             _stack.push_back(influence(in(0), 0.0, 0.0, w));
@@ -136,34 +137,43 @@ namespace xvigra
         /***************************/
 
         template <class T1, index_t N1, class T2, index_t N2, class SigmaArray>
-        void distance_transform_impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
-                                     SigmaArray const & sigmas, bool invert = false)
+        void distance_transform_lines(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                                      SigmaArray const & sigmas, bool invert)
         {
             // Sigma is the spread of the parabolas. It determines the structuring element size
             // for ND morphology. When calculating the distance transforms, sigma is usually set to 1,
             // unless one wants to account for anisotropic pixel pitch.
             index_t N = in.dimension();
 
-            slicer nav(in.shape());
-
             // operate on last dimension first
-            nav.set_free_axes(N-1);
-            for(; nav.has_more(); ++nav)
+            auto in_line  = make_line_iterator(in, N-1);
+            auto out_line = make_line_iterator(out, N-1);
+            for(; in_line.has_more(); ++in_line, ++out_line)
             {
-                distance_parabola(in.view(*nav), out.view(*nav), sigmas[N-1], invert);
+                distance_parabola(*in_line, *out_line, sigmas[N-1], invert);
             }
 
             // operate on further dimensions
             for( index_t d = N-2; d >= 0; --d )
             {
-                nav.set_free_axes(d);
-                for(; nav.has_more(); ++nav)
+                for(auto line = make_line_iterator(out, d); line.has_more(); ++line)
                 {
-                    distance_parabola(out.view(*nav), out.view(*nav), sigmas[d], invert);
+                    distance_parabola(*line, *line, sigmas[d], invert);
                 }
             }
         }
 
+        template <class T1, index_t N1, class T2, index_t N2, class SigmaArray>
+        void distance_transform_impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                                     SigmaArray const & sigmas, bool invert = false)
+        {
+            // use static dimension for 2D and 3D data
+            dispatch_static_dimension(in, out, [&](auto & sin, auto & sout)
+            {
+                distance_transform_lines(sin, sout, sigmas, invert);
+            });
+        }
+
      } // namespace detail
 
     struct distance_transform_squared_functor
@@ -193,7 +203,7 @@ namespace xvigra
             if(std::is_integral<T2>::value && (pitch_is_real || inf > (double)highest))
             {
                 // work on a real-valued temporary array
-                array_nd<real_promote_type_t<T2>, N2> tmp(out.shape());
+                temporary_array_nd<real_promote_type_t<T2>, N2> tmp(out.shape());
                 if(background)
                 {
                     tmp = where(equal(in, 0), inf, 0.0);
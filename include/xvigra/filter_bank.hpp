@@ -0,0 +1,544 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_FILTER_BANK_HPP
+#define XVIGRA_FILTER_BANK_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "global.hpp"
+#include "array_nd.hpp"
+#include "math.hpp"
+#include "kernel.hpp"
+#include "kernel_cache.hpp"
+#include "separable_convolution.hpp"
+#include "tensor_features.hpp"
+
+namespace xvigra
+{
+    /***************/
+    /* filter_bank */
+    /***************/
+
+    enum filter_bank_feature
+    {
+        gaussian_smoothing_feature,
+        gaussian_gradient_magnitude_feature,
+        laplacian_of_gaussian_feature,
+        structure_tensor_eigenvalues_feature,
+        hessian_eigenvalues_feature
+    };
+
+    struct filter_bank_statistics
+    {
+        double flops_independent = 0.0;  // convolution FLOPs when every request starts from the input
+        double flops_scheduled = 0.0;    // convolution FLOPs of the cascaded schedule
+        index_t intermediates = 0;       // number of smoothed intermediates computed
+        index_t peak_intermediates = 0;  // maximum number of intermediates alive at the same time
+        std::size_t peak_bytes = 0;      // memory of these intermediates
+
+        double flops_saved() const
+        {
+            return flops_independent - flops_scheduled;
+        }
+    };
+
+        /** \brief Compute a stack of Gaussian features at several scales with shared smoothing.
+
+            Requests are (feature, scale) pairs. Gaussian smoothing cascades, i.e.
+            smoothing at <tt>s1</tt> followed by smoothing at <tt>sqrt(s2*s2 - s1*s1)</tt>
+            equals smoothing at <tt>s2</tt>. The filter bank therefore computes one smoothed
+            intermediate per distinct scale, each from the largest smaller scale, and
+            derives every feature from the largest intermediate below its scale, using
+            only the residual scale for the derivative kernels. Residual scales
+            below <tt>minimum_residual_scale</tt> are avoided because such small Gaussians
+            are poorly sampled.
+
+            Requests are executed in order of their base intermediate, and each intermediate
+            is released as soon as its last consumer is done, so that typically only two
+            intermediates are alive at the same time. <tt>statistics()</tt> reports the
+            convolution FLOPs of the schedule compared to independent evaluation, and the
+            peak memory of the intermediates.
+
+            The output has one more dimension than the input, holding the feature
+            channels in the order the requests were added (see <tt>channel_offset()</tt>).
+            Structure tensor and Hessian eigenvalues occupy N channels in descending order.
+
+            <b>Usage:</b>
+            \code
+            filter_bank<float> bank;
+            for(double s: {0.7, 1.0, 1.6, 3.5, 5.0, 10.0})
+            {
+                bank.add(gaussian_smoothing_feature, s);
+                bank.add(gaussian_gradient_magnitude_feature, s);
+            }
+            array_nd<float, 2> image(...);
+            array_nd<float, 3> features(image.shape().push_back(bank.channel_count(2)));
+            bank.apply(image, features);
+            std::cout << bank.statistics().flops_saved() << " FLOPs saved\n";
+            \endcode
+        */
+    template <class T = float>
+    class filter_bank
+    {
+      public:
+
+        explicit
+        filter_bank(double minimum_residual_scale = 0.5,
+                    convolution_options const & options = convolution_options())
+        : minimum_residual_scale_(minimum_residual_scale)
+        , options_(options)
+        {}
+
+            /** Add a request and return its index. <tt>outer_scale</tt> is only used
+                by <tt>structure_tensor_eigenvalues_feature</tt>, where zero selects
+                <tt>scale / 2</tt>.
+            */
+        index_t add(filter_bank_feature feature, double scale, double outer_scale = 0.0)
+        {
+            vigra_precondition(scale > 0.0,
+                "filter_bank::add(): scale must be positive.");
+            if(outer_scale <= 0.0)
+            {
+                outer_scale = 0.5 * scale;
+            }
+            requests_.push_back(request{feature, scale, outer_scale});
+            return (index_t)requests_.size() - 1;
+        }
+
+        index_t size() const
+        {
+            return (index_t)requests_.size();
+        }
+
+            /** Number of output channels for data of dimension <tt>ndim</tt>.
+            */
+        index_t channel_count(index_t ndim) const
+        {
+            return channel_offset(size(), ndim);
+        }
+
+            /** First output channel of request <tt>k</tt> for data of dimension <tt>ndim</tt>.
+            */
+        index_t channel_offset(index_t k, index_t ndim) const
+        {
+            index_t res = 0;
+            for(index_t j=0; j<k; ++j)
+            {
+                res += channels(requests_[j].feature, ndim);
+            }
+            return res;
+        }
+
+            /** Statistics of the schedule for data of the given shape, without
+                computing anything.
+            */
+        filter_bank_statistics plan_statistics(shape_t<> const & shape) const
+        {
+            return make_statistics(make_schedule(), shape);
+        }
+
+            /** Statistics of the last call to <tt>apply()</tt>.
+            */
+        filter_bank_statistics const & statistics() const
+        {
+            return statistics_;
+        }
+
+        template <class E1, class E2>
+        void apply(E1 && e1, E2 && e2)
+        {
+            auto && a1 = eval_expr(std::forward<E1>(e1));
+            auto && a2 = eval_expr(std::forward<E2>(e2));
+            apply_impl(make_view(a1), make_view(a2));
+        }
+
+      private:
+
+            // intermediates and per-feature temporaries use the temporary memory pool
+        using buffer_type = std::vector<T, XVIGRA_TEMPORARY_ALLOCATOR(T)>;
+
+        struct request
+        {
+            filter_bank_feature feature;
+            double scale, outer_scale;
+        };
+
+        struct schedule
+        {
+            std::vector<double> levels;          // scales of the intermediates, ascending
+            std::vector<index_t> level_base;     // intermediate each level is computed from (-1: input)
+            std::vector<index_t> request_base;   // intermediate each request is computed from
+            std::vector<index_t> last_use;       // step after which a level can be released
+        };
+
+        static index_t channels(filter_bank_feature feature, index_t ndim)
+        {
+            return (feature == structure_tensor_eigenvalues_feature ||
+                    feature == hessian_eigenvalues_feature)
+                       ? ndim
+                       : 1;
+        }
+
+        static double residual_scale(double scale, double base_scale)
+        {
+            return std::sqrt(std::max(scale*scale - base_scale*base_scale, 0.0));
+        }
+
+            // largest level whose residual to 'scale' is at least the minimum residual scale
+        index_t find_base(std::vector<double> const & levels, index_t end, double scale) const
+        {
+            for(index_t j=end-1; j>=0; --j)
+            {
+                if(residual_scale(scale, levels[j]) >= minimum_residual_scale_)
+                {
+                    return j;
+                }
+            }
+            return -1;
+        }
+
+        schedule make_schedule() const
+        {
+            std::vector<double> candidates;
+            for(auto const & r: requests_)
+            {
+                candidates.push_back(r.scale);
+            }
+            std::sort(candidates.begin(), candidates.end());
+            candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+            index_t count = (index_t)candidates.size();
+            std::vector<index_t> base(count), request_base(requests_.size());
+            for(index_t k=0; k<count; ++k)
+            {
+                base[k] = find_base(candidates, k, candidates[k]);
+            }
+            std::vector<bool> needed(count, false);
+            for(std::size_t k=0; k<requests_.size(); ++k)
+            {
+                index_t level = std::lower_bound(candidates.begin(), candidates.end(), requests_[k].scale) - candidates.begin();
+                request_base[k] = (requests_[k].feature == gaussian_smoothing_feature)
+                                      ? level
+                                      : find_base(candidates, level, requests_[k].scale);
+                if(request_base[k] >= 0)
+                {
+                    needed[request_base[k]] = true;
+                }
+            }
+            for(index_t k=count-1; k>=0; --k)
+            {
+                if(needed[k] && base[k] >= 0)
+                {
+                    needed[base[k]] = true;
+                }
+            }
+
+            // keep the needed levels only and renumber
+            schedule res;
+            std::vector<index_t> new_index(count, -1);
+            for(index_t k=0; k<count; ++k)
+            {
+                if(needed[k])
+                {
+                    new_index[k] = (index_t)res.levels.size();
+                    res.levels.push_back(candidates[k]);
+                    res.level_base.push_back(base[k] < 0 ? -1 : new_index[base[k]]);
+                    res.last_use.push_back(new_index[k]);
+                }
+            }
+            for(auto b: request_base)
+            {
+                res.request_base.push_back(b < 0 ? -1 : new_index[b]);
+            }
+            for(std::size_t k=0; k<res.levels.size(); ++k)
+            {
+                if(res.level_base[k] >= 0)
+                {
+                    res.last_use[res.level_base[k]] = std::max(res.last_use[res.level_base[k]], (index_t)k);
+                }
+            }
+            return res;
+        }
+
+        static double convolution_flops(double scale, shape_t<> const & orders)
+        {
+            double res = 0.0;
+            for(auto order: orders)
+            {
+                res += 2.0 * (2 * (index_t)((3.0 + 0.5*order) * scale + 0.5) + 1);
+            }
+            return res;
+        }
+
+            // convolution FLOPs per pixel of request 'r' when it starts at the given residual scale
+        double request_flops(request const & r, double scale, index_t ndim) const
+        {
+            double res = 0.0;
+            switch(r.feature)
+            {
+                case gaussian_smoothing_feature:
+                {
+                    if(scale > 0.0)
+                    {
+                        res += convolution_flops(scale, shape_t<>(ndim, 0));
+                    }
+                    break;
+                }
+                case gaussian_gradient_magnitude_feature:
+                case laplacian_of_gaussian_feature:
+                {
+                    for(index_t d=0; d<ndim; ++d)
+                    {
+                        shape_t<> orders(ndim, 0);
+                        orders[d] = (r.feature == laplacian_of_gaussian_feature) ? 2 : 1;
+                        res += convolution_flops(scale, orders);
+                    }
+                    break;
+                }
+                case structure_tensor_eigenvalues_feature:
+                {
+                    for(index_t d=0; d<ndim; ++d)
+                    {
+                        shape_t<> orders(ndim, 0);
+                        orders[d] = 1;
+                        res += convolution_flops(scale, orders);
+                    }
+                    res += ndim*(ndim+1)/2 * convolution_flops(r.outer_scale, shape_t<>(ndim, 0));
+                    break;
+                }
+                case hessian_eigenvalues_feature:
+                {
+                    for(index_t i=0; i<ndim; ++i)
+                    {
+                        for(index_t j=i; j<ndim; ++j)
+                        {
+                            shape_t<> orders(ndim, 0);
+                            orders[i] += 1;
+                            orders[j] += 1;
+                            res += convolution_flops(scale, orders);
+                        }
+                    }
+                    break;
+                }
+            }
+            return res;
+        }
+
+        filter_bank_statistics make_statistics(schedule const & s, shape_t<> const & shape) const
+        {
+            index_t ndim = shape.size();
+            double pixels = (double)prod(shape);
+            filter_bank_statistics res;
+            for(std::size_t k=0; k<requests_.size(); ++k)
+            {
+                request const & r = requests_[k];
+                index_t b = s.request_base[k];
+                res.flops_independent += pixels * request_flops(r, r.scale, ndim);
+                res.flops_scheduled += pixels * request_flops(r, residual_scale(r.scale, b < 0 ? 0.0 : s.levels[b]), ndim);
+            }
+            index_t alive = 0;
+            for(std::size_t k=0; k<s.levels.size(); ++k)
+            {
+                index_t b = s.level_base[k];
+                res.flops_scheduled += pixels * convolution_flops(residual_scale(s.levels[k], b < 0 ? 0.0 : s.levels[b]),
+                                                                  shape_t<>(ndim, 0));
+                ++alive;
+                res.peak_intermediates = std::max(res.peak_intermediates, alive);
+                alive -= std::count(s.last_use.begin(), s.last_use.end(), (index_t)k);
+            }
+            res.intermediates = (index_t)s.levels.size();
+            res.peak_bytes = (std::size_t)res.peak_intermediates * (std::size_t)prod(shape) * sizeof(T);
+            return res;
+        }
+
+        template <class T1, index_t N1, class T2, index_t N2>
+        void apply_impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out)
+        {
+            index_t ndim = in.dimension(), size = in.size();
+            shape_t<> shape(in.shape());
+            vigra_precondition(shape_t<>(out.shape()) == shape.push_back(channel_count(ndim)),
+                "filter_bank::apply(): output shape must equal input shape plus channel axis.");
+
+            schedule s = make_schedule();
+            statistics_ = make_statistics(s, shape);
+
+            std::vector<buffer_type> levels(s.levels.size());
+            for(index_t step=-1; step<(index_t)s.levels.size(); ++step)
+            {
+                if(step >= 0)
+                {
+                    index_t b = s.level_base[step];
+                    double residual = residual_scale(s.levels[step], b < 0 ? 0.0 : s.levels[b]);
+                    levels[step].resize(size);
+                    view_nd<T> dest(shape, levels[step].data());
+                    if(b < 0)
+                    {
+                        separable_convolution(in, dest, *cached_gaussian_kernel_1d<T>(residual), options_);
+                    }
+                    else
+                    {
+                        separable_convolution(view_nd<T>(shape, levels[b].data()), dest,
+                                              *cached_gaussian_kernel_1d<T>(residual), options_);
+                    }
+                }
+                for(std::size_t k=0; k<requests_.size(); ++k)
+                {
+                    if(s.request_base[k] != step)
+                    {
+                        continue;
+                    }
+                    request const & r = requests_[k];
+                    index_t channel = channel_offset(k, ndim);
+                    if(step < 0)
+                    {
+                        compute_feature(in, r, r.scale, out, channel);
+                    }
+                    else
+                    {
+                        compute_feature(view_nd<T>(shape, levels[step].data()), r,
+                                        residual_scale(r.scale, s.levels[step]), out, channel);
+                    }
+                }
+                // release the intermediates that are no longer needed
+                for(std::size_t k=0; k<s.levels.size(); ++k)
+                {
+                    if(s.last_use[k] == step)
+                    {
+                        buffer_type().swap(levels[k]);
+                    }
+                }
+            }
+        }
+
+        template <class S, index_t NS, class T2, index_t N2>
+        void compute_feature(view_nd<S, NS> const & src, request const & r, double scale,
+                             view_nd<T2, N2> & out, index_t channel) const
+        {
+            index_t ndim = src.dimension(), size = src.size();
+            shape_t<> shape(src.shape());
+            switch(r.feature)
+            {
+                case gaussian_smoothing_feature:
+                {
+                    if(scale > 0.0)
+                    {
+                        buffer_type res(size);
+                        separable_convolution(src, view_nd<T>(shape, res.data()),
+                                              *cached_gaussian_kernel_1d<T>(scale), options_);
+                        out.bind(ndim, channel) = view_nd<T>(shape, res.data());
+                    }
+                    else
+                    {
+                        out.bind(ndim, channel) = src;
+                    }
+                    break;
+                }
+                case gaussian_gradient_magnitude_feature:
+                {
+                    buffer_type gradient(ndim*size);
+                    detail::gaussian_gradient_components(src, gradient.data(), scale, options_);
+                    for(index_t k=0; k<size; ++k)
+                    {
+                        T sum = T();
+                        for(index_t d=0; d<ndim; ++d)
+                        {
+                            sum += sq(gradient[d*size+k]);
+                        }
+                        gradient[k] = std::sqrt(sum);
+                    }
+                    out.bind(ndim, channel) = view_nd<T>(shape, gradient.data());
+                    break;
+                }
+                case laplacian_of_gaussian_feature:
+                {
+                    buffer_type res(size), tmp(size);
+                    for(index_t d=0; d<ndim; ++d)
+                    {
+                        shape_t<> orders(ndim, 0);
+                        orders[d] = 2;
+                        separable_convolution(src, view_nd<T>(shape, tmp.data()),
+                                              detail::gaussian_derivative_kernels<T>(scale, orders), options_);
+                        for(index_t k=0; k<size; ++k)
+                        {
+                            res[k] += tmp[k];
+                        }
+                    }
+                    out.bind(ndim, channel) = view_nd<T>(shape, res.data());
+                    break;
+                }
+                case structure_tensor_eigenvalues_feature:
+                case hessian_eigenvalues_feature:
+                {
+                    vigra_precondition(ndim == 2 || ndim == 3,
+                        "filter_bank::apply(): eigenvalue features are only implemented for 2D and 3D data.");
+                    index_t m = ndim*(ndim+1)/2;
+                    buffer_type tensor(m*size), ev(ndim*size);
+                    if(r.feature == structure_tensor_eigenvalues_feature)
+                    {
+                        detail::gaussian_gradient_components(src, ev.data(), scale, options_);
+                        detail::smoothed_outer_product(ev.data(), shape, r.outer_scale, options_,
+                                                       tensor.data(), size,
+                                                       [](index_t, T const *) {});
+                    }
+                    else
+                    {
+                        detail::hessian_components(src, scale, options_, tensor.data(), size,
+                                                   [](index_t, T const *) {});
+                    }
+                    T const * components[6];
+                    T * evs[3];
+                    for(index_t c=0; c<m; ++c)
+                    {
+                        components[c] = tensor.data() + c*size;
+                    }
+                    for(index_t c=0; c<ndim; ++c)
+                    {
+                        evs[c] = ev.data() + c*size;
+                    }
+                    detail::symmetric_eigenvalues_soa(components, ndim, size, evs);
+                    for(index_t c=0; c<ndim; ++c)
+                    {
+                        out.bind(ndim, channel+c) = view_nd<T>(shape, evs[c]);
+                    }
+                    break;
+                }
+            }
+        }
+
+        double minimum_residual_scale_;
+        convolution_options options_;
+        std::vector<request> requests_;
+        filter_bank_statistics statistics_;
+    };
+} // namespace xvigra
+
+#endif // XVIGRA_FILTER_BANK_HPP
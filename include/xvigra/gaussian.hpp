@@ -33,8 +33,14 @@
 #ifndef XVIGRA_GAUSSIAN_HPP
 #define XVIGRA_GAUSSIAN_HPP
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
+
+#ifdef XVIGRA_USE_SIMD
+#  include <xsimd/xsimd.hpp>
+#endif
+
 #include "global.hpp"
 #include "error.hpp"
 #include "math.hpp"
@@ -100,6 +106,21 @@ namespace xvigra
             */
         result_type operator()(argument_type x) const;
 
+            /** Evaluate the function for all elements of \a x (an xtensor expression
+                or view_nd) and write the results into \a res, which must have the same
+                shape. The derivative order is dispatched once for the entire array,
+                and <tt>exp()</tt> uses SIMD when <tt>XVIGRA_USE_SIMD</tt> is defined.
+                The data are processed in small chunks, so no temporary arrays are
+                created and \a x and \a res may refer to the same memory.
+            */
+        template <class E, class R>
+        void evaluate(E const & x, R && res) const;
+
+            /** Evaluate the function for <tt>x[0...size-1]</tt>, writing the
+                results into <tt>res[0...size-1]</tt>.
+            */
+        void evaluate(T const * x, index_t size, T * res) const;
+
             /** Get the standard deviation of the gaussian.
             */
         value_type sigma() const
@@ -129,6 +150,9 @@ namespace xvigra
         void calculate_hermite_polynomial();
         T horner(T x) const;
 
+        template <class F>
+        void evaluate_impl(T const * x, index_t size, T * res, F const & f) const;
+
         T sigma_, sigma2_, norm_;
         unsigned int order_;
         std::vector<T> hermite_polynomial_;
@@ -159,6 +183,150 @@ namespace xvigra
         }
     }
 
+    namespace detail
+    {
+        template <class T>
+        struct gaussian_use_simd
+#ifdef XVIGRA_USE_SIMD
+        : public std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value>
+#else
+        : public std::false_type
+#endif
+        {};
+
+        // Evaluate f(x, x*x, norm*exp(x*x*sigma2)) for as many elements as fit into
+        // complete SIMD batches and return the number of processed elements.
+        template <class T, class F>
+        inline index_t gaussian_simd_loop(T const * x, index_t size, T * res, T norm, T sigma2, F const & f,
+                                          std::true_type)
+        {
+#ifdef XVIGRA_USE_SIMD
+            using batch_type = decltype(xsimd::set_simd(T()));
+            constexpr index_t simd_size = xsimd::simd_batch_traits<batch_type>::size;
+
+            batch_type bnorm(norm), bsigma2(sigma2);
+            index_t simd_end = size - size % simd_size;
+            for(index_t j=0; j<simd_end; j += simd_size)
+            {
+                batch_type bx  = xsimd::load_unaligned(x + j),
+                           bx2 = bx * bx;
+                f(bx, bx2, bnorm * xsimd::exp(bx2 * bsigma2)).store_unaligned(res + j);
+            }
+            return simd_end;
+#else
+            return 0;
+#endif
+        }
+
+        template <class T, class F>
+        inline index_t gaussian_simd_loop(T const *, index_t, T *, T, T, F const &, std::false_type)
+        {
+            return 0;
+        }
+    } // namespace detail
+
+    template <class T>
+    template <class F>
+    void
+    gaussian<T>::evaluate_impl(T const * x, index_t size, T * res, F const & f) const
+    {
+        for(index_t j = detail::gaussian_simd_loop(x, size, res, norm_, sigma2_, f, detail::gaussian_use_simd<T>());
+            j < size; ++j)
+        {
+            T x2 = x[j] * x[j];
+            res[j] = f(x[j], x2, norm_ * std::exp(x2 * sigma2_));
+        }
+    }
+
+    template <class T>
+    void
+    gaussian<T>::evaluate(T const * x, index_t size, T * res) const
+    {
+        T s2 = T(1.0 / sq(sigma_));
+        switch(order_)
+        {
+            case 0:
+                evaluate_impl(x, size, res,
+                    [](auto const &, auto const &, auto const & g)
+                    {
+                        return g;
+                    });
+                break;
+            case 1:
+                evaluate_impl(x, size, res,
+                    [](auto const & v, auto const &, auto const & g)
+                    {
+                        return v * g;
+                    });
+                break;
+            case 2:
+                evaluate_impl(x, size, res,
+                    [s2](auto const &, auto const & v2, auto const & g)
+                    {
+                        using V = std::decay_t<decltype(g)>;
+                        return (V(T(1)) - v2 * V(s2)) * g;
+                    });
+                break;
+            case 3:
+                evaluate_impl(x, size, res,
+                    [s2](auto const & v, auto const & v2, auto const & g)
+                    {
+                        using V = std::decay_t<decltype(g)>;
+                        return (V(T(3)) - v2 * V(s2)) * v * g;
+                    });
+                break;
+            default:
+            {
+                T const * h = hermite_polynomial_.data();
+                int degree = order_ / 2;
+                bool odd = order_ % 2 == 1;
+                evaluate_impl(x, size, res,
+                    [h, degree, odd](auto const & v, auto const & v2, auto const & g)
+                    {
+                        using V = std::decay_t<decltype(g)>;
+                        V p(h[degree]);
+                        for(int i = degree-1; i >= 0; --i)
+                        {
+                            p = v2 * p + V(h[i]);
+                        }
+                        return odd
+                                  ? V(v * g * p)
+                                  : V(g * p);
+                    });
+            }
+        }
+    }
+
+    template <class T>
+    template <class E, class R>
+    void
+    gaussian<T>::evaluate(E const & x, R && res) const
+    {
+        vigra_precondition(x.dimension() == res.dimension() &&
+                           std::equal(x.shape().begin(), x.shape().end(), res.shape().begin()),
+            "gaussian::evaluate(): shape mismatch between input and output.");
+
+        static const index_t chunk_size = 256;
+        T xbuf[chunk_size], rbuf[chunk_size];
+
+        auto src = x.begin();
+        auto dest = res.begin();
+        index_t size = (index_t)x.size();
+        for(index_t j0 = 0; j0 < size; j0 += chunk_size)
+        {
+            index_t n = std::min(chunk_size, size - j0);
+            for(index_t j = 0; j < n; ++j, ++src)
+            {
+                xbuf[j] = static_cast<T>(*src);
+            }
+            evaluate(xbuf, n, rbuf);
+            for(index_t j = 0; j < n; ++j, ++dest)
+            {
+                *dest = rbuf[j];
+            }
+        }
+    }
+
     template <class T>
     T gaussian<T>::horner(T x) const
     {
@@ -47,6 +47,20 @@
 #    define XVIGRA_DEFAULT_ALLOCATOR(T) \
        std::allocator<T>
 #  endif
+#endif
+
+    // Allocator of the library's internal temporary arrays
+    // (see pool_allocator.hpp).
+#ifndef XVIGRA_TEMPORARY_ALLOCATOR
+#  define XVIGRA_TEMPORARY_ALLOCATOR(T) \
+     pool_allocator<T>
+#endif
+
+    // Number of elements that a 'tiny_vector<T, runtime_size>' (e.g. 'shape_t<>')
+    // stores inline before it allocates heap memory. The default covers
+    // 5-dimensional data (t, z, y, x, c) plus one inserted axis.
+#ifndef XVIGRA_SHAPE_BUFFER_SIZE
+#  define XVIGRA_SHAPE_BUFFER_SIZE 6
 #endif
 
 namespace xvigra
@@ -69,9 +83,16 @@ namespace xvigra
     template <class T, index_t N=runtime_size>
     class view_nd;
 
+    template <class T>
+    class pool_allocator;
+
     template <class T, index_t N=runtime_size, class A=XVIGRA_DEFAULT_ALLOCATOR(std::decay_t<T>)>
     class array_nd;
 
+        // array type for temporaries inside algorithms
+    template <class T, index_t N=runtime_size>
+    using temporary_array_nd = array_nd<T, N, XVIGRA_TEMPORARY_ALLOCATOR(std::decay_t<T>)>;
+
     /***********/
     /* shape_t */
     /***********/
@@ -208,6 +229,31 @@ namespace xvigra
         using type = array_nd<NT, N>;
     };
 
+    /********************/
+    /* rebind_temporary */
+    /********************/
+
+        // like rebind_container, but arrays use the allocator for temporaries
+    template <class C, class T>
+    struct rebind_temporary
+    : public rebind_container<C, T>
+    {};
+
+    template <class C, class T>
+    using rebind_temporary_t = typename rebind_temporary<std::decay_t<C>, T>::type;
+
+    template <class T, index_t N, class NT>
+    struct rebind_temporary<view_nd<T, N>, NT>
+    {
+        using type = temporary_array_nd<NT, N>;
+    };
+
+    template <class T, index_t N, class A, class NT>
+    struct rebind_temporary<array_nd<T, N, A>, NT>
+    {
+        using type = temporary_array_nd<NT, N>;
+    };
+
     /********************/
     /* conditional cast */
     /********************/
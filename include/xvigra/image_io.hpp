@@ -31,13 +31,33 @@
 #ifndef XVIGRA_IMAGE_IO_HPP
 #define XVIGRA_IMAGE_IO_HPP
 
+#include <array>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include <OpenImageIO/imageio.h>
 #include <xtensor/xmath.hpp>
 #include <xtensor/xeval.hpp>
+#include <xtensor/xview.hpp>
 #include "array_nd.hpp"
+#include "reduction.hpp"
 
 namespace xvigra
 {
+    namespace detail
+    {
+        struct close_image_input
+        {
+            void operator()(OIIO::ImageInput * file) const
+            {
+                file->close();
+                OIIO::ImageInput::destroy(file);
+            }
+        };
+    }
+
     /**
      * Load an image from file at filename.
      * Storage format is deduced from file ending.
@@ -51,13 +71,7 @@ namespace xvigra
     template <class T = float>
     array_nd<T> read_image(std::string filename)
     {
-        auto close_file  =  [](OIIO::ImageInput * file)
-                            {
-                                file->close();
-                                OIIO::ImageInput::destroy(file);
-                            };
-
-        std::unique_ptr<OIIO::ImageInput, decltype(close_file)> in(OIIO::ImageInput::open(filename), close_file);
+        std::unique_ptr<OIIO::ImageInput, detail::close_image_input> in(OIIO::ImageInput::open(filename));
         vigra_precondition(!!in,
             "read_image(): Error reading image '" + filename + "'.");
 
@@ -76,6 +90,458 @@ namespace xvigra
         return image;
     }
 
+    /**
+     * Load an image from file at filename into an existing array.
+     *
+     * The image is read directly into the memory of ``image``, without
+     * an intermediate buffer. Type conversion to ``T`` is done by OpenImageIO.
+     * ``image`` may be strided, but the channels of a pixel must be
+     * consecutive in memory (i.e. the channel stride must be 1).
+     *
+     * @param filename The path of the file to load
+     * @param image Destination with shape ``HEIGHT x WIDTH`` or
+     *        ``HEIGHT x WIDTH x CHANNELS``, which must match the file.
+     */
+    template <class T, index_t N>
+    void read_image(std::string filename, view_nd<T, N> image)
+    {
+        static_assert(!std::is_const<T>::value,
+            "read_image(): destination must not have a const value_type.");
+        vigra_precondition(image.has_data(),
+            "read_image(): destination must not be empty.");
+
+        std::unique_ptr<OIIO::ImageInput, detail::close_image_input> in(OIIO::ImageInput::open(filename));
+        vigra_precondition(!!in,
+            "read_image(): Error reading image '" + filename + "'.");
+
+        const OIIO::ImageSpec& spec = in->spec();
+
+        index_t ndim = image.dimension();
+        vigra_precondition(ndim == 2 || ndim == 3,
+            "read_image(): destination must have 2 or 3 dimensions (channels must be last).");
+        index_t nchannels = (ndim == 2)
+                               ? 1
+                               : image.shape(2);
+        vigra_precondition(image.shape(0) == spec.height && image.shape(1) == spec.width &&
+                           nchannels == spec.nchannels,
+            "read_image(): shape of destination doesn't match image '" + filename + "'.");
+        vigra_precondition(nchannels == 1 || image.strides(2) == 1,
+            "read_image(): channels of destination must be consecutive in memory.");
+
+        OIIO::stride_t xstride = image.strides(1) * sizeof(T),
+                       ystride = image.strides(0) * sizeof(T);
+        if(image.shape(1) == 1)
+        {
+            xstride = nchannels * sizeof(T); // singleton axes have zero stride
+        }
+        if(image.shape(0) == 1)
+        {
+            ystride = image.shape(1) * xstride;
+        }
+
+        in->read_image(OIIO::BaseTypeFromC<T>::value, image.raw_data(), xstride, ystride);
+    }
+
+    /**********************/
+    /* image_block_reader */
+    /**********************/
+
+        /** \brief Read an image piecewise in blocks of bounded size.
+
+            The image is traversed in row-major order of blocks with the given
+            \a block_shape (the last row and column of blocks may be smaller).
+            Each block is enlarged by \a overlap pixels on all sides where
+            possible, so that neighborhood operations (convolution, morphology)
+            produce correct results in the block's core region
+            <tt>[core_begin(), core_end())</tt>.
+
+            Tiled files are read tile by tile using <tt>ImageInput::read_tiles()</tt>,
+            so memory consumption is proportional to the block size. Scanline files are
+            read in bands of full image width using <tt>ImageInput::read_scanlines()</tt>,
+            and all blocks of a band are views into the same band buffer.
+            The buffer is reused for all blocks, i.e. the view returned by
+            <tt>operator*</tt> is only valid until the next call to <tt>operator++</tt>.
+
+            If \a prefetch is true, a background thread reads the next tile region or band
+            into a second buffer while the caller processes the current one, so that
+            I/O overlaps with computation. The two buffers are swapped when the
+            iteration reaches the prefetched region.
+
+            Blocks have shape <tt>HEIGHT x WIDTH</tt> or <tt>HEIGHT x WIDTH x CHANNELS</tt>,
+            as returned by <tt>read_image()</tt>.
+
+            <b>Usage:</b>
+            \code
+            image_block_reader<float> reader("huge.tif", {1024, 1024}, 8, true);
+            for(; reader.has_more(); ++reader)
+            {
+                array_nd<float> smoothed(reader->shape());
+                separable_convolution(2_d, *reader, smoothed, gaussian_kernel_1d<float>(2.0));
+                // smoothed is valid in the region
+                //     [reader.core_begin() - reader.block_begin(), reader.core_end() - reader.block_begin())
+            }
+            \endcode
+        */
+    template <class T = float>
+    class image_block_reader
+    {
+      public:
+
+        using value_type = T;
+        using view_type = view_nd<T>;
+
+        image_block_reader(std::string filename,
+                           shape_t<2> const & block_shape,
+                           index_t overlap = 0,
+                           bool prefetch = false)
+        : in_(OIIO::ImageInput::open(filename))
+        , filename_(filename)
+        , block_shape_(block_shape)
+        , overlap_(overlap)
+        , prefetch_state_(prefetch_idle)
+        , stop_(false)
+        {
+            vigra_precondition(!!in_,
+                "image_block_reader(): Error reading image '" + filename + "'.");
+            vigra_precondition(all_greater(block_shape, 0) && overlap >= 0,
+                "image_block_reader(): block_shape must be positive and overlap non-negative.");
+
+            spec_ = in_->spec();
+            image_shape_ = shape_t<2>{spec_.height, spec_.width};
+            shape_ = shape_t<>{spec_.height, spec_.width};
+            if(spec_.nchannels > 1)
+            {
+                shape_ = shape_.push_back(spec_.nchannels);
+            }
+
+            core_begin_ = shape_t<2>{0, 0};
+            core_end_ = min(block_shape_, image_shape_);
+            if(has_more())
+            {
+                read_block();
+            }
+            if(prefetch && has_more())
+            {
+                    // start the thread only after the first read, which may throw
+                prefetch_thread_ = std::thread([this]() { prefetch_loop(); });
+                schedule_prefetch();
+            }
+        }
+
+        ~image_block_reader()
+        {
+            if(prefetch_thread_.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    stop_ = true;
+                }
+                prefetch_changed_.notify_all();
+                prefetch_thread_.join();
+            }
+        }
+
+        image_block_reader(image_block_reader const &) = delete;
+        image_block_reader & operator=(image_block_reader const &) = delete;
+
+            /** shape of the entire image
+            */
+        shape_t<> const & shape() const
+        {
+            return shape_;
+        }
+
+        shape_t<2> const & block_shape() const
+        {
+            return block_shape_;
+        }
+
+        index_t overlap() const
+        {
+            return overlap_;
+        }
+
+        OIIO::ImageSpec const & spec() const
+        {
+            return spec_;
+        }
+
+        bool has_more() const
+        {
+            return core_begin_[0] < image_shape_[0] && core_begin_[1] < image_shape_[1];
+        }
+
+            /** true if the next region is read in the background
+            */
+        bool prefetching() const
+        {
+            return prefetch_thread_.joinable();
+        }
+
+            /** the current block including overlap
+            */
+        view_type const & operator*() const
+        {
+            return block_;
+        }
+
+        view_type const * operator->() const
+        {
+            return &block_;
+        }
+
+        image_block_reader & operator++()
+        {
+            core_begin_ = next_core(core_begin_);
+            core_end_ = min(core_begin_ + block_shape_, image_shape_);
+            if(has_more())
+            {
+                read_block();
+            }
+            return *this;
+        }
+
+            /** image coordinates of the current block's upper left corner (including overlap)
+            */
+        shape_t<2> const & block_begin() const
+        {
+            return block_begin_;
+        }
+
+            /** image coordinates of the current block's end (including overlap)
+            */
+        shape_t<2> const & block_end() const
+        {
+            return block_end_;
+        }
+
+            /** image coordinates of the current block's upper left corner (excluding overlap)
+            */
+        shape_t<2> const & core_begin() const
+        {
+            return core_begin_;
+        }
+
+            /** image coordinates of the current block's end (excluding overlap)
+            */
+        shape_t<2> const & core_end() const
+        {
+            return core_end_;
+        }
+
+      private:
+
+        enum prefetch_state { prefetch_idle, prefetch_requested, prefetch_ready };
+
+        shape_t<2> next_core(shape_t<2> core) const
+        {
+            core[1] += block_shape_[1];
+            if(core[1] >= image_shape_[1])
+            {
+                core[1] = 0;
+                core[0] += block_shape_[0];
+            }
+            return core;
+        }
+
+        bool buffer_contains(shape_t<2> const & b, shape_t<2> const & e) const
+        {
+            return all_less_equal(buffer_begin_, b) && all_less_equal(e, buffer_end_);
+        }
+
+        void read_block()
+        {
+            block_begin_ = max(core_begin_ - overlap_, 0);
+            block_end_ = min(core_end_ + overlap_, image_shape_);
+
+            if(!buffer_contains(block_begin_, block_end_))
+            {
+                load_region(block_begin_, block_end_);
+            }
+
+            index_t nchannels = spec_.nchannels;
+            shape_t<2> offset = block_begin_ - buffer_begin_,
+                       extent = block_end_ - block_begin_;
+            index_t row_stride = (buffer_end_[1] - buffer_begin_[1]) * nchannels;
+            T * p = buffer_.data() + offset[0]*row_stride + offset[1]*nchannels;
+            if(nchannels == 1)
+            {
+                view_type(shape_t<>{extent[0], extent[1]},
+                          shape_t<>{row_stride, 1},
+                          axis_tags<>(2, tags::axis_unknown),
+                          p).swap(block_);
+            }
+            else
+            {
+                view_type(shape_t<>{extent[0], extent[1], nchannels},
+                          shape_t<>{row_stride, nchannels, 1},
+                          axis_tags<>(3, tags::axis_unknown),
+                          p).swap(block_);
+            }
+        }
+
+        bool is_tiled() const
+        {
+            return spec_.tile_width > 0 && spec_.tile_height > 0;
+        }
+
+            // enlarge [b, e) to the region that is actually read from the file
+        void align_region(shape_t<2> & b, shape_t<2> & e) const
+        {
+            if(is_tiled())
+            {
+                    // read_tiles() requires tile-aligned bounds
+                shape_t<2> tile{spec_.tile_height, spec_.tile_width};
+                b = b / tile * tile;
+                e = min((e + tile - 1) / tile * tile, image_shape_);
+            }
+            else
+            {
+                    // scanline files are read in bands of full width
+                b[1] = 0;
+                e[1] = image_shape_[1];
+            }
+        }
+
+            // must not be called concurrently: ImageInput is not thread-safe
+        bool read_region(shape_t<2> const & b, shape_t<2> const & e, std::vector<T> & buffer)
+        {
+            buffer.resize(prod(e - b) * spec_.nchannels);
+            if(is_tiled())
+            {
+                return in_->read_tiles(spec_.x + (int)b[1], spec_.x + (int)e[1],
+                                       spec_.y + (int)b[0], spec_.y + (int)e[0],
+                                       spec_.z, spec_.z + 1,
+                                       OIIO::BaseTypeFromC<T>::value, buffer.data());
+            }
+            else
+            {
+                return in_->read_scanlines(spec_.y + (int)b[0], spec_.y + (int)e[0], spec_.z,
+                                           OIIO::BaseTypeFromC<T>::value, buffer.data());
+            }
+        }
+
+        void load_region(shape_t<2> b, shape_t<2> e)
+        {
+            align_region(b, e);
+
+            bool ok = false;
+            std::string error;
+            if(prefetch_thread_.joinable())
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                prefetch_done_.wait(lock, [this]() { return prefetch_state_ != prefetch_requested; });
+                if(prefetch_state_ == prefetch_ready && prefetch_begin_ == b && prefetch_end_ == e)
+                {
+                    ok = prefetch_ok_;
+                    error = prefetch_error_;
+                    buffer_.swap(prefetch_buffer_);
+                }
+                else
+                {
+                    ok = read_region(b, e, buffer_);
+                }
+                prefetch_state_ = prefetch_idle;
+            }
+            else
+            {
+                ok = read_region(b, e, buffer_);
+            }
+            if(!ok && error.empty())
+            {
+                error = in_->geterror();
+            }
+            vigra_precondition(ok,
+                "image_block_reader(): Error reading image '" + filename_ + "': " + error);
+            buffer_begin_ = b;
+            buffer_end_ = e;
+
+            schedule_prefetch();
+        }
+
+            // request the first region after the current buffer that
+            // subsequent blocks will need
+        void schedule_prefetch()
+        {
+            if(!prefetch_thread_.joinable())
+            {
+                return;
+            }
+            for(shape_t<2> core = next_core(core_begin_); core[0] < image_shape_[0]; core = next_core(core))
+            {
+                shape_t<2> b = max(core - overlap_, 0),
+                           e = min(min(core + block_shape_, image_shape_) + overlap_, image_shape_);
+                if(!buffer_contains(b, e))
+                {
+                    align_region(b, e);
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        prefetch_begin_ = b;
+                        prefetch_end_ = e;
+                        prefetch_state_ = prefetch_requested;
+                    }
+                    prefetch_changed_.notify_all();
+                    return;
+                }
+            }
+        }
+
+        void prefetch_loop()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for(;;)
+            {
+                prefetch_changed_.wait(lock, [this]() { return stop_ || prefetch_state_ == prefetch_requested; });
+                if(stop_)
+                {
+                    return;
+                }
+                lock.unlock();
+                bool ok = false;
+                std::string error;
+                try
+                {
+                    ok = read_region(prefetch_begin_, prefetch_end_, prefetch_buffer_);
+                    if(!ok)
+                    {
+                        error = in_->geterror();
+                    }
+                }
+                catch(std::exception & e)
+                {
+                    error = e.what();
+                }
+                lock.lock();
+                prefetch_ok_ = ok;
+                prefetch_error_ = error;
+                prefetch_state_ = prefetch_ready;
+                prefetch_done_.notify_all();
+            }
+        }
+
+        std::unique_ptr<OIIO::ImageInput, detail::close_image_input> in_;
+        OIIO::ImageSpec spec_;
+        std::string filename_;
+        shape_t<> shape_;
+        shape_t<2> image_shape_, block_shape_;
+        index_t overlap_;
+        shape_t<2> core_begin_, core_end_, block_begin_, block_end_;
+        std::vector<T> buffer_;
+        shape_t<2> buffer_begin_, buffer_end_;
+        view_type block_;
+
+            // state shared with the prefetch thread, guarded by mutex_
+            // (prefetch_buffer_ and in_ belong to the thread while a request is pending)
+        std::vector<T> prefetch_buffer_;
+        shape_t<2> prefetch_begin_, prefetch_end_;
+        prefetch_state prefetch_state_;
+        bool prefetch_ok_ = false, stop_;
+        std::string prefetch_error_;
+        std::mutex mutex_;
+        std::condition_variable prefetch_changed_, prefetch_done_;
+        std::thread prefetch_thread_;
+    };
+
         /** \brief Pass options to write_image().
         */
     struct write_image_options
@@ -85,6 +551,9 @@ namespace xvigra
         write_image_options()
         : spec(0,0,0)
         , autoconvert(true)
+        , range_lower(0.0)
+        , range_upper(0.0)
+        , rows_per_strip(64)
         {
             spec.attribute("CompressionQuality", 90);
         }
@@ -103,10 +572,128 @@ namespace xvigra
             return *this;
         }
 
+            /** \brief Value range to be mapped onto 0...1 when the file format
+                requires conversion.
+
+                When the file format doesn't support the data's value_type, the data
+                are normalized such that <tt>lower</tt> maps to 0 and <tt>upper</tt> to 1.
+                Values outside the range are clipped by OpenImageIO. If no range is
+                given (<tt>lower == upper</tt>), it is determined from the data by an
+                additional pass.
+
+                Default: no range (determined from the data)
+            */
+        write_image_options & value_range(double lower, double upper)
+        {
+            range_lower = lower;
+            range_upper = upper;
+            return *this;
+        }
+
+            /** \brief Number of rows evaluated and written at once.
+
+                Expressions are evaluated strip by strip into a buffer of this height,
+                so that no full-size temporary is needed. For tiled files, the value is
+                rounded up to a multiple of the tile height.
+
+                Default: 64
+            */
+        write_image_options & strip_height(index_t rows)
+        {
+            vigra_precondition(rows > 0,
+                "write_image_options::strip_height(): rows must be positive.");
+            rows_per_strip = rows;
+            return *this;
+        }
+
         OIIO::ImageSpec spec;
         bool autoconvert;
+        double range_lower, range_upper;
+        index_t rows_per_strip;
     };
 
+    namespace detail
+    {
+        struct close_image_output
+        {
+            void operator()(OIIO::ImageOutput * file) const
+            {
+                file->close();
+                OIIO::ImageOutput::destroy(file);
+            }
+        };
+
+            // Value range of the data: parallel reduction when the data are in memory,
+            // otherwise a lazy pass over the expression.
+        template <class E>
+        inline std::array<double, 2>
+        image_data_range(E const & e, std::true_type)
+        {
+            auto mM = reduce::minmax(e);
+            return {{static_cast<double>(mM[0]), static_cast<double>(mM[1])}};
+        }
+
+        template <class E>
+        inline std::array<double, 2>
+        image_data_range(E const & e, std::false_type)
+        {
+            auto mM = minmax(e)();
+            return {{static_cast<double>(mM[0]), static_cast<double>(mM[1])}};
+        }
+
+        template <class E>
+        inline std::array<double, 2>
+        image_data_range(E const & e)
+        {
+            using value_type = std::remove_const_t<typename E::value_type>;
+            return image_data_range(e, std::integral_constant<bool,
+                                           has_raw_data_api<E>::value && std::is_arithmetic<value_type>::value>());
+        }
+
+            // Evaluate 'f(rows of e)' strip by strip into a reusable buffer of type T
+            // and pass the buffer to the ImageOutput.
+        template <class T, class E, class F>
+        void
+        write_image_strips(OIIO::ImageOutput & out, E const & e, index_t rows_per_strip,
+                           F f, std::string const & filename)
+        {
+            OIIO::ImageSpec const & spec = out.spec();
+            index_t height = spec.height,
+                    width  = spec.width;
+            bool tiled = spec.tile_width > 0 && spec.tile_height > 0;
+            if(tiled)
+            {
+                rows_per_strip = (rows_per_strip + spec.tile_height - 1) / spec.tile_height * spec.tile_height;
+            }
+            rows_per_strip = min(rows_per_strip, height);
+
+            shape_t<> strip_shape{rows_per_strip, width};
+            if(e.shape().size() == 3)
+            {
+                strip_shape = strip_shape.push_back(e.shape()[2]);
+            }
+            array_nd<T> buffer(strip_shape);
+
+            for(index_t y = 0; y < height; y += rows_per_strip)
+            {
+                index_t yend = min(y + rows_per_strip, height);
+                strip_shape[0] = yend - y;
+                view_nd<T> strip(strip_shape, buffer.raw_data());
+                strip = f(xt::view(e, xt::range(y, yend)));
+
+                bool ok = tiled
+                            ? out.write_tiles(spec.x, spec.x + (int)width,
+                                              spec.y + (int)y, spec.y + (int)yend,
+                                              spec.z, spec.z + 1,
+                                              OIIO::BaseTypeFromC<T>::value, strip.raw_data())
+                            : out.write_scanlines(spec.y + (int)y, spec.y + (int)yend, spec.z,
+                                                  OIIO::BaseTypeFromC<T>::value, strip.raw_data());
+                vigra_precondition(ok,
+                    "write_image(): Error writing image '" + filename + "': " + out.geterror());
+            }
+        }
+    }
+
     /**
      * Save image to disk.
      * The desired image format is deduced from ``filename``.
@@ -114,6 +701,11 @@ namespace xvigra
      * Most common formats are supported (jpg, png, gif, bmp, tiff).
      * The shape of the array must be ``HEIGHT x WIDTH`` or ``HEIGHT x WIDTH x CHANNELS``.
      *
+     * Expressions are evaluated in strips of ``options.strip_height()`` rows, so
+     * memory consumption is independent of the image size. When the file format
+     * requires type conversion and no ``options.value_range()`` is given, the
+     * value range is determined by an additional pass over the data.
+     *
      * @param filename The path to the desired file
      * @param data Image data
      * @param options Pass a write_image_options object to fine-tune image export
@@ -129,12 +721,7 @@ namespace xvigra
         vigra_precondition(shape.size() == 2 || shape.size() == 3,
             "write_image(): data must have 2 or 3 dimensions (channels must be last).");
 
-        auto close_file  =  [](OIIO::ImageOutput * file)
-                            {
-                                file->close();
-                                OIIO::ImageOutput::destroy(file);
-                            };
-        std::unique_ptr<OIIO::ImageOutput, decltype(close_file)> out(OIIO::ImageOutput::create(filename), close_file);
+        std::unique_ptr<OIIO::ImageOutput, detail::close_image_output> out(OIIO::ImageOutput::create(filename));
         vigra_precondition(!!out,
             "write_image(): Error opening file '" + filename + "' to write image.");
 
@@ -147,30 +734,40 @@ namespace xvigra
                            : static_cast<int>(shape[2]);
         spec.format    = OIIO::BaseTypeFromC<value_type>::value;
 
-        out->open(filename, spec);
+        vigra_precondition(out->open(filename, spec),
+            "write_image(): Error opening file '" + filename + "' to write image: " + out->geterror());
 
-        auto && ex = xt::eval(e);
-        if(out->spec().format != OIIO::BaseTypeFromC<value_type>::value)
+        double lower = options.range_lower,
+               upper = options.range_upper;
+        bool convert = out->spec().format != OIIO::BaseTypeFromC<value_type>::value;
+        if(convert && lower == upper)
         {
             // OpenImageIO changed the target type because the file format doesn't support value_type.
             // It will do automatic conversion, but the data should be in the range 0...1
             // for good results.
-            auto mM = minmax(ex)();
+            auto mM = detail::image_data_range(e);
+            lower = mM[0];
+            upper = mM[1];
+        }
 
-            if(mM[0] != mM[1])
-            {
-                using real_t = real_promote_type_t<value_type>;
-                auto && normalized = xt::eval((real_t(1.0) / (mM[1] - mM[0])) * (ex - mM[0]));
-                out->write_image(OIIO::BaseTypeFromC<real_t>::value, normalized.raw_data());
-            }
-            else
-            {
-                out->write_image(OIIO::BaseTypeFromC<value_type>::value, ex.raw_data());
-            }
+        if(convert && lower != upper)
+        {
+            using real_t = real_promote_type_t<value_type>;
+            real_t offset = static_cast<real_t>(lower),
+                   scale  = real_t(1.0) / static_cast<real_t>(upper - lower);
+            detail::write_image_strips<real_t>(*out, e, options.rows_per_strip,
+                [offset, scale](auto && strip)
+                {
+                    return scale * (std::forward<decltype(strip)>(strip) - offset);
+                }, filename);
         }
         else
         {
-            out->write_image(OIIO::BaseTypeFromC<value_type>::value, ex.raw_data());
+            detail::write_image_strips<value_type>(*out, e, options.rows_per_strip,
+                [](auto && strip) -> decltype(auto)
+                {
+                    return std::forward<decltype(strip)>(strip);
+                }, filename);
         }
     }
 }
@@ -0,0 +1,469 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_IMAGE_SEQUENCE_HPP
+#define XVIGRA_IMAGE_SEQUENCE_HPP
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+#include "image_io.hpp"
+
+namespace xvigra
+{
+    /*********************/
+    /* image_buffer_pool */
+    /*********************/
+
+        /** \brief Thread-safe pool of image buffers for reuse.
+
+            Buffers returned by <tt>release()</tt> are handed out again by
+            <tt>acquire()</tt> when a buffer of the requested size is requested,
+            avoiding repeated allocation (and page faults) for same-sized frames.
+            At most <tt>capacity</tt> buffers are kept.
+        */
+    template <class T>
+    class image_buffer_pool
+    {
+      public:
+
+        explicit
+        image_buffer_pool(std::size_t capacity = 8)
+        : capacity_(capacity)
+        {}
+
+        array_nd<T> acquire(shape_t<> const & shape)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for(auto k = free_.begin(); k != free_.end(); ++k)
+                {
+                    if(k->size() == prod(shape))
+                    {
+                        array_nd<T> res(std::move(*k));
+                        free_.erase(k);
+                        if(res.shape() != shape)
+                        {
+                            res.reshape(shape);
+                        }
+                        return res;
+                    }
+                }
+            }
+            return array_nd<T>(shape);
+        }
+
+        void release(array_nd<T> && buffer)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(free_.size() < capacity_ && buffer.has_data())
+            {
+                free_.emplace_back(std::move(buffer));
+            }
+        }
+
+        std::size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return free_.size();
+        }
+
+      private:
+
+            // std::list never moves its elements (array_nd's move assignment may copy)
+        std::list<array_nd<T>> free_;
+        std::size_t capacity_;
+        mutable std::mutex mutex_;
+    };
+
+    /***************/
+    /* image_frame */
+    /***************/
+
+    template <class T>
+    struct image_frame
+    {
+        index_t index;
+        std::string filename;
+        array_nd<T> image;
+    };
+
+    /*************************/
+    /* image_sequence_reader */
+    /*************************/
+
+        /** \brief Read a sequence of images asynchronously.
+
+            \a nthreads decoder threads read the files in the background, staying at most
+            \a queue_size frames ahead of the consumer. <tt>next()</tt> returns the frames
+            in the order of \a filenames and blocks until the next frame is available.
+            Errors during decoding are rethrown by <tt>next()</tt> for the affected frame.
+            Buffers passed back via <tt>recycle()</tt> are reused for subsequent frames.
+
+            <b>Usage:</b>
+            \code
+            image_sequence_reader<float> reader(filenames, 4);
+            while(reader.has_more())
+            {
+                auto frame = reader.next();
+                process(frame.image);
+                reader.recycle(std::move(frame.image));
+            }
+            \endcode
+        */
+    template <class T = float>
+    class image_sequence_reader
+    {
+      public:
+
+        image_sequence_reader(std::vector<std::string> filenames,
+                              index_t nthreads = 2,
+                              index_t queue_size = 4)
+        : filenames_(std::move(filenames))
+        , queue_size_(queue_size)
+        , next_decode_(0)
+        , next_consume_(0)
+        , stop_(false)
+        , pool_(queue_size + 1)
+        {
+            vigra_precondition(nthreads > 0 && queue_size > 0,
+                "image_sequence_reader(): nthreads and queue_size must be positive.");
+            for(index_t k = 0; k < nthreads; ++k)
+            {
+                threads_.emplace_back([this]() { decode_loop(); });
+            }
+        }
+
+        ~image_sequence_reader()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            space_.notify_all();
+            for(auto & t : threads_)
+            {
+                t.join();
+            }
+        }
+
+        image_sequence_reader(image_sequence_reader const &) = delete;
+        image_sequence_reader & operator=(image_sequence_reader const &) = delete;
+
+            /** total number of frames in the sequence
+            */
+        index_t size() const
+        {
+            return (index_t)filenames_.size();
+        }
+
+        bool has_more() const
+        {
+            return next_consume_ < size();
+        }
+
+            /** get the next frame, waiting for the decoder if necessary
+            */
+        image_frame<T> next()
+        {
+            vigra_precondition(has_more(),
+                "image_sequence_reader::next(): no more frames.");
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this]() { return done_.count(next_consume_) > 0; });
+            auto k = done_.find(next_consume_);
+            slot s(std::move(k->second));
+            done_.erase(k);
+            index_t index = next_consume_++;
+            lock.unlock();
+            space_.notify_all();
+
+            if(s.error)
+            {
+                std::rethrow_exception(s.error);
+            }
+            return image_frame<T>{index, filenames_[index], std::move(s.image)};
+        }
+
+            /** pass a buffer back for reuse by the decoder threads
+            */
+        void recycle(array_nd<T> && image)
+        {
+            pool_.release(std::move(image));
+        }
+
+      private:
+
+        struct slot
+        {
+            array_nd<T> image;
+            std::exception_ptr error;
+        };
+
+        array_nd<T> decode(std::string const & filename)
+        {
+            std::unique_ptr<OIIO::ImageInput, detail::close_image_input> in(OIIO::ImageInput::open(filename));
+            vigra_precondition(!!in,
+                "image_sequence_reader: Error reading image '" + filename + "'.");
+
+            const OIIO::ImageSpec& spec = in->spec();
+            shape_t<> shape{spec.height, spec.width};
+            if(spec.nchannels > 1)
+            {
+                shape = shape.push_back(spec.nchannels);
+            }
+
+            array_nd<T> image = pool_.acquire(shape);
+            vigra_precondition(in->read_image(OIIO::BaseTypeFromC<T>::value, image.raw_data()),
+                "image_sequence_reader: Error reading image '" + filename + "': " + in->geterror());
+            return image;
+        }
+
+        void decode_loop()
+        {
+            for(;;)
+            {
+                index_t k;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    space_.wait(lock, [this]()
+                    {
+                        return stop_ || next_decode_ >= size() ||
+                               next_decode_ < next_consume_ + queue_size_;
+                    });
+                    if(stop_ || next_decode_ >= size())
+                    {
+                        return;
+                    }
+                    k = next_decode_++;
+                }
+
+                slot s;
+                try
+                {
+                    s.image = decode(filenames_[k]);
+                }
+                catch(...)
+                {
+                    s.error = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    done_.emplace(k, std::move(s));
+                }
+                ready_.notify_all();
+            }
+        }
+
+        std::vector<std::string> filenames_;
+        index_t queue_size_, next_decode_, next_consume_;
+        bool stop_;
+        std::map<index_t, slot> done_;
+        image_buffer_pool<T> pool_;
+        std::mutex mutex_;
+        std::condition_variable ready_, space_;
+        std::vector<std::thread> threads_;
+    };
+
+    /*************************/
+    /* image_sequence_writer */
+    /*************************/
+
+        /** \brief Write a sequence of images asynchronously.
+
+            <tt>write()</tt> enqueues an image and returns immediately unless
+            \a queue_size images are already waiting, in which case it blocks.
+            \a nthreads encoder threads write the images in the background.
+            Buffers obtained from <tt>acquire()</tt> are recycled after encoding.
+            <tt>wait()</tt> blocks until all pending images are written and rethrows
+            the first error that occurred. The destructor waits as well, but
+            swallows errors.
+
+            <b>Usage:</b>
+            \code
+            image_sequence_writer<float> writer(2);
+            for(...)
+            {
+                auto result = writer.acquire(shape);
+                compute(result);
+                writer.write(filename, std::move(result));
+            }
+            writer.wait();
+            \endcode
+        */
+    template <class T = float>
+    class image_sequence_writer
+    {
+      public:
+
+        image_sequence_writer(index_t nthreads = 1,
+                              index_t queue_size = 4,
+                              write_image_options const & options = write_image_options())
+        : options_(options)
+        , queue_size_(queue_size)
+        , active_(0)
+        , stop_(false)
+        , pool_(queue_size + nthreads)
+        {
+            vigra_precondition(nthreads > 0 && queue_size > 0,
+                "image_sequence_writer(): nthreads and queue_size must be positive.");
+            for(index_t k = 0; k < nthreads; ++k)
+            {
+                threads_.emplace_back([this]() { encode_loop(); });
+            }
+        }
+
+        ~image_sequence_writer()
+        {
+            try
+            {
+                wait();
+            }
+            catch(...)
+            {}
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            ready_.notify_all();
+            for(auto & t : threads_)
+            {
+                t.join();
+            }
+        }
+
+        image_sequence_writer(image_sequence_writer const &) = delete;
+        image_sequence_writer & operator=(image_sequence_writer const &) = delete;
+
+            /** get a (possibly recycled) buffer of the given shape
+            */
+        array_nd<T> acquire(shape_t<> const & shape)
+        {
+            return pool_.acquire(shape);
+        }
+
+            /** enqueue an image, taking ownership of its buffer
+            */
+        void write(std::string filename, array_nd<T> && image)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                space_.wait(lock, [this]() { return (index_t)queue_.size() < queue_size_; });
+                queue_.emplace_back(std::move(filename), std::move(image));
+            }
+            ready_.notify_one();
+        }
+
+            /** evaluate an expression into a recycled buffer and enqueue it
+            */
+        template <class E>
+        void write(std::string filename, xt::xexpression<E> const & data)
+        {
+            E const & e = data.derived_cast();
+            array_nd<T> image = acquire(shape_t<>(e.shape().begin(), e.shape().end()));
+            image = e;
+            write(std::move(filename), std::move(image));
+        }
+
+            /** wait until all enqueued images are written
+            */
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            idle_.wait(lock, [this]() { return queue_.empty() && active_ == 0; });
+            if(error_)
+            {
+                std::exception_ptr error = error_;
+                error_ = nullptr;
+                std::rethrow_exception(error);
+            }
+        }
+
+      private:
+
+        using job_list = std::list<std::pair<std::string, array_nd<T>>>;
+
+        void encode_loop()
+        {
+            for(;;)
+            {
+                job_list job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    ready_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+                    if(queue_.empty())
+                    {
+                        return;
+                    }
+                    job.splice(job.begin(), queue_, queue_.begin());
+                    ++active_;
+                }
+                space_.notify_one();
+
+                try
+                {
+                    write_image(job.front().first, job.front().second, options_);
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if(!error_)
+                    {
+                        error_ = std::current_exception();
+                    }
+                }
+                pool_.release(std::move(job.front().second));
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    --active_;
+                }
+                idle_.notify_all();
+            }
+        }
+
+        write_image_options options_;
+        index_t queue_size_, active_;
+        bool stop_;
+        job_list queue_;
+        std::exception_ptr error_;
+        image_buffer_pool<T> pool_;
+        std::mutex mutex_;
+        std::condition_variable ready_, space_, idle_;
+        std::vector<std::thread> threads_;
+    };
+
+} // namespace xvigra
+
+#endif // XVIGRA_IMAGE_SEQUENCE_HPP
@@ -85,14 +85,16 @@ namespace xvigra
     gaussian_kernel_1d(double sigma, index_t radius)
     {
         kernel_1d<T> res(2*radius+1, radius);
+        for(index_t k=-radius; k<=radius; ++k)
+        {
+            res(k+radius) = T(k);
+        }
+        gaussian<T>(sigma).evaluate(res, res);
 
-        gaussian<T> gauss(sigma);
         T sum = 0;
-        for(index_t k=-radius; k<=radius; ++k)
+        for(index_t k=0; k<res.size(); ++k)
         {
-            T g = gauss(k);
-            res(k+radius) = g;
-            sum += g;
+            sum += res(k);
         }
         res *= T(1)/sum;
         return res;
@@ -110,14 +112,16 @@ namespace xvigra
     gaussian_derivative_kernel_1d(double sigma, index_t order, index_t radius)
     {
         kernel_1d<T> res(2*radius+1, radius);
+        for(index_t k=-radius; k<=radius; ++k)
+        {
+            res(k+radius) = T(k);
+        }
+        gaussian<T>(sigma, order).evaluate(res, res);
 
-        gaussian<T> gauss(sigma, order);
         T sum = 0;
-        for(index_t k=-radius; k<=radius; ++k)
+        for(index_t k=0; k<res.size(); ++k)
         {
-            T g = gauss(k);
-            res(k+radius) = g;
-            sum += g;
+            sum += res(k);
         }
         if(order > 0)
         {
@@ -0,0 +1,245 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_KERNEL_CACHE_HPP
+#define XVIGRA_KERNEL_CACHE_HPP
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
+#include "global.hpp"
+#include "kernel.hpp"
+
+namespace xvigra
+{
+    /****************/
+    /* kernel_cache */
+    /****************/
+
+    struct kernel_cache_statistics
+    {
+        std::size_t hits = 0;
+        std::size_t misses = 0;
+        std::size_t evictions = 0;
+        std::size_t size = 0;
+        std::size_t capacity = 0;
+    };
+
+        /** \brief Thread-safe cache of Gaussian kernels.
+
+            Kernels are keyed by (sigma, derivative order, radius, value type) and
+            handed out as shared pointers to immutable kernels, so that repeated
+            requests for the same kernel (e.g. once per tile) don't recompute it.
+            At most <tt>capacity()</tt> kernels are kept; the least recently used
+            kernel is evicted first. Kernels still held by a caller stay valid after
+            eviction.
+
+            <b>Usage:</b>
+            \code
+            auto kernel = cached_gaussian_kernel_1d<float>(2.0);  // uses default_kernel_cache()
+            separable_convolution(in, out, *kernel);
+
+            auto stats = default_kernel_cache().statistics();
+            std::cout << stats.hits << " hits, " << stats.misses << " misses\n";
+            \endcode
+        */
+    class kernel_cache
+    {
+      public:
+
+        explicit
+        kernel_cache(std::size_t capacity = 128)
+        : capacity_(capacity)
+        {}
+
+        kernel_cache(kernel_cache const &) = delete;
+        kernel_cache & operator=(kernel_cache const &) = delete;
+
+            /** Get the Gaussian (derivative) kernel with the given parameters. A negative
+                radius selects the default radius of gaussian_kernel_1d() resp.
+                gaussian_derivative_kernel_1d().
+            */
+        template <class T = double>
+        std::shared_ptr<kernel_1d<T> const>
+        gaussian(double sigma, index_t derivative_order = 0, index_t radius = -1)
+        {
+            if(radius < 0)
+            {
+                radius = (index_t)((3.0 + 0.5*derivative_order) * sigma + 0.5);
+            }
+            key_type key(sigma, derivative_order, radius, std::type_index(typeid(T)));
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if(auto kernel = lookup(key))
+                {
+                    ++hits_;
+                    return std::static_pointer_cast<kernel_1d<T> const>(kernel);
+                }
+                ++misses_;
+            }
+
+            // compute the kernel without holding the lock
+            std::shared_ptr<kernel_1d<T> const> kernel =
+                std::make_shared<kernel_1d<T>>(derivative_order == 0
+                                                  ? gaussian_kernel_1d<T>(sigma, radius)
+                                                  : gaussian_derivative_kernel_1d<T>(sigma, derivative_order, radius));
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(auto existing = lookup(key))
+            {
+                // another thread was faster
+                return std::static_pointer_cast<kernel_1d<T> const>(existing);
+            }
+            insert(key, kernel);
+            return kernel;
+        }
+
+        std::size_t capacity() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return capacity_;
+        }
+
+        void set_capacity(std::size_t capacity)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            capacity_ = capacity;
+            shrink();
+        }
+
+        std::size_t size() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return entries_.size();
+        }
+
+        kernel_cache_statistics statistics() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            kernel_cache_statistics res;
+            res.hits      = hits_;
+            res.misses    = misses_;
+            res.evictions = evictions_;
+            res.size      = entries_.size();
+            res.capacity  = capacity_;
+            return res;
+        }
+
+        void reset_statistics()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            hits_ = misses_ = evictions_ = 0;
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.clear();
+            lru_.clear();
+        }
+
+      private:
+        using key_type = std::tuple<double, index_t, index_t, std::type_index>;
+
+        struct entry
+        {
+            std::shared_ptr<void const> kernel;
+            std::list<key_type>::iterator lru_position;
+        };
+
+            // must be called with locked mutex
+        std::shared_ptr<void const> lookup(key_type const & key)
+        {
+            auto k = entries_.find(key);
+            if(k == entries_.end())
+            {
+                return std::shared_ptr<void const>();
+            }
+            lru_.splice(lru_.begin(), lru_, k->second.lru_position);
+            return k->second.kernel;
+        }
+
+            // must be called with locked mutex
+        void insert(key_type const & key, std::shared_ptr<void const> kernel)
+        {
+            if(capacity_ == 0)
+            {
+                return;
+            }
+            lru_.push_front(key);
+            entries_.emplace(key, entry{std::move(kernel), lru_.begin()});
+            shrink();
+        }
+
+            // must be called with locked mutex
+        void shrink()
+        {
+            while(entries_.size() > capacity_)
+            {
+                entries_.erase(lru_.back());
+                lru_.pop_back();
+                ++evictions_;
+            }
+        }
+
+        std::map<key_type, entry> entries_;
+        std::list<key_type> lru_;    // most recently used first
+        std::size_t capacity_;
+        std::size_t hits_ = 0, misses_ = 0, evictions_ = 0;
+        mutable std::mutex mutex_;
+    };
+
+        /** The process-wide kernel cache used by the <tt>cached_*</tt> functions.
+        */
+    inline kernel_cache & default_kernel_cache()
+    {
+        static kernel_cache cache;
+        return cache;
+    }
+
+    template <class T=double>
+    inline std::shared_ptr<kernel_1d<T> const>
+    cached_gaussian_kernel_1d(double sigma, index_t radius = -1)
+    {
+        return default_kernel_cache().gaussian<T>(sigma, 0, radius);
+    }
+
+    template <class T=double>
+    inline std::shared_ptr<kernel_1d<T> const>
+    cached_gaussian_derivative_kernel_1d(double sigma, index_t order, index_t radius = -1)
+    {
+        return default_kernel_cache().gaussian<T>(sigma, order, radius);
+    }
+} // namespace xvigra
+
+#endif // XVIGRA_KERNEL_CACHE_HPP
@@ -0,0 +1,331 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_LINE_ITERATOR_HPP
+#define XVIGRA_LINE_ITERATOR_HPP
+
+#include <algorithm>
+#include <vector>
+#include "global.hpp"
+#include "error.hpp"
+#include "tiny_vector.hpp"
+#include "array_nd.hpp"
+
+namespace xvigra
+{
+    /*********************/
+    /* subarray_iterator */
+    /*********************/
+
+        /** \brief Iterate over all M-dimensional subarrays of a view_nd.
+
+            The subarrays are spanned by the given 'free' axes, and the iterator
+            visits all positions of the remaining (outer) axes in c-order.
+            In contrast to \ref slicer, the iterator never creates a slice_vector.
+            It only keeps a pointer to the first element of the current subarray,
+            which is advanced by the outer strides, so that the per-subarray
+            overhead is independent of the array's dimension. This matters when
+            the free axes are short.
+
+            When the view's dimension N is known at compile time, the outer
+            position and strides are static tiny_vectors of size N-M, so that
+            the compiler can fully unroll the position arithmetic. Use
+            \ref dispatch_static_dimension to obtain static views from
+            runtime-dimensional ones.
+
+            The range of visited subarrays can be restricted to a contiguous
+            interval of linear indices [begin, end). Function <tt>split()</tt>
+            uses this to partition the remaining range for parallel processing,
+            where each part can be handed to a different thread.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> a(shape_t<3>{100, 100, 4});
+            // iterate over all lines along axis 2
+            for(auto line = make_line_iterator(a, 2); line.has_more(); ++line)
+            {
+                float * p = line.data();
+                for(index_t k=0; k<line.size(); ++k, p += line.stride())
+                {
+                    *p = k;
+                }
+            }
+            // the same, using four independent parts
+            for(auto & part: make_line_iterator(a, 2).split(4))
+            {
+                for(; part.has_more(); ++part)
+                {
+                    auto v = *part;   // 'v' is a view_nd<float, 1>
+                    ...
+                }
+            }
+            \endcode
+        */
+    template <class T, index_t M = 1, index_t N = runtime_size>
+    class subarray_iterator
+    {
+      public:
+        static constexpr index_t outer_dimension = (N == runtime_size || N <= M) ? runtime_size : N - M;
+
+        using value_type   = view_nd<T, M>;
+        using pointer      = T *;
+        using shape_type   = shape_t<M>;
+        using outer_shape_type = shape_t<outer_dimension>;
+
+        template <class U, index_t NV>
+        subarray_iterator(view_nd<U, NV> const & v, shape_type const & free_axes)
+        : data_(const_cast<pointer>(v.raw_data()))
+        , current_(data_)
+        , index_(0)
+        , end_(0)
+        {
+            static_assert(std::is_convertible<U*, T*>::value,
+                "subarray_iterator<T, M, N>: view_nd has incompatible value_type.");
+            static_assert(N == runtime_size || N == NV,
+                "subarray_iterator<T, M, N>: view_nd has incompatible dimension.");
+
+            index_t n = v.dimension();
+            vigra_precondition(M <= n,
+                "subarray_iterator(): more free axes than array dimensions.");
+            shape_type axes = free_axes;
+            std::sort(axes.begin(), axes.end());
+            for(index_t k=0; k<M; ++k)
+            {
+                vigra_precondition(0 <= axes[k] && axes[k] < n && (k == 0 || axes[k-1] < axes[k]),
+                    "subarray_iterator(): free axes must be distinct and in range.");
+                shape_[k]   = v.shape(axes[k]);
+                strides_[k] = v.strides(axes[k]);
+            }
+
+            outer_shape_   = outer_shape_type(n-M, index_t(0));
+            outer_strides_ = outer_shape_type(n-M, index_t(0));
+            position_      = outer_shape_type(n-M, index_t(0));
+            for(index_t d=0, k=0, j=0; d<n; ++d)
+            {
+                if(k < M && axes[k] == d)
+                {
+                    ++k;
+                    continue;
+                }
+                outer_shape_[j]   = v.shape(d);
+                outer_strides_[j] = v.strides(d);
+                ++j;
+            }
+            count_ = (v.size() == 0) ? 0 : 1;
+            for(index_t k=0; k<outer_shape_.size(); ++k)
+            {
+                count_ *= outer_shape_[k];
+            }
+            set_range(0, count_);
+        }
+
+            /** \brief Restrict the iteration to the subarrays with linear
+                indices in [begin, end) and move to 'begin'.
+             */
+        void set_range(index_t begin, index_t end)
+        {
+            vigra_precondition(0 <= begin && begin <= end && end <= count_,
+                "subarray_iterator::set_range(): invalid range.");
+            index_   = begin;
+            end_     = end;
+            current_ = data_;
+            if(count_ == 0)
+            {
+                return; // an outer axis may have length zero
+            }
+            for(index_t k=outer_shape_.size()-1; k>=0; --k)
+            {
+                position_[k] = begin % outer_shape_[k];
+                begin       /= outer_shape_[k];
+                current_    += position_[k]*outer_strides_[k];
+            }
+        }
+
+            /** \brief Split the remaining range into (at most) 'parts'
+                contiguous, non-overlapping pieces of almost equal size.
+             */
+        std::vector<subarray_iterator> split(index_t parts) const
+        {
+            vigra_precondition(parts > 0,
+                "subarray_iterator::split(): number of parts must be positive.");
+            index_t remaining = end_ - index_;
+            parts = std::max<index_t>(1, std::min(parts, remaining));
+
+            std::vector<subarray_iterator> res;
+            res.reserve(parts);
+            for(index_t k=0; k<parts; ++k)
+            {
+                res.push_back(*this);
+                res.back().set_range(index_ + k*remaining / parts,
+                                     index_ + (k+1)*remaining / parts);
+            }
+            return res;
+        }
+
+        void operator++()
+        {
+            ++index_;
+            for(index_t k=outer_shape_.size()-1; k>=0; --k)
+            {
+                current_ += outer_strides_[k];
+                if(++position_[k] < outer_shape_[k])
+                {
+                    return;
+                }
+                current_ -= outer_strides_[k]*outer_shape_[k];
+                position_[k] = 0;
+            }
+        }
+
+        void operator++(int)
+        {
+            ++(*this);
+        }
+
+        bool has_more() const
+        {
+            return index_ < end_;
+        }
+
+        value_type operator*() const
+        {
+            return value_type(shape_, strides_, current_);
+        }
+
+            /** \brief Pointer to the first element of the current subarray.
+             */
+        pointer data() const
+        {
+            return current_;
+        }
+
+            /** \brief Shape and strides of the subarrays.
+             */
+        shape_type const & shape() const
+        {
+            return shape_;
+        }
+
+        shape_type const & strides() const
+        {
+            return strides_;
+        }
+
+            /** \brief Length and stride of the current line (only for M == 1).
+             */
+        index_t size() const
+        {
+            static_assert(M == 1, "subarray_iterator::size(): only valid for lines.");
+            return shape_[0];
+        }
+
+        index_t stride() const
+        {
+            static_assert(M == 1, "subarray_iterator::stride(): only valid for lines.");
+            return strides_[0];
+        }
+
+            /** \brief Total number of subarrays, linear index of the current
+                subarray, and end of the current range.
+             */
+        index_t count() const
+        {
+            return count_;
+        }
+
+        index_t index() const
+        {
+            return index_;
+        }
+
+        index_t end() const
+        {
+            return end_;
+        }
+
+            /** \brief Position of the current subarray along the outer axes.
+             */
+        outer_shape_type const & position() const
+        {
+            return position_;
+        }
+
+      private:
+        pointer data_, current_;
+        shape_type shape_, strides_;
+        outer_shape_type outer_shape_, outer_strides_, position_;
+        index_t count_, index_, end_;
+    };
+
+    /*****************/
+    /* line_iterator */
+    /*****************/
+
+    template <class T, index_t N = runtime_size>
+    using line_iterator = subarray_iterator<T, 1, N>;
+
+        /** \brief Create a line_iterator over all 1-dimensional lines along
+            'axis' of the given view. The iterator refers to const data
+            when the view is const, and keeps the view's static dimension.
+         */
+    template <class T, index_t N>
+    inline line_iterator<T, N>
+    make_line_iterator(view_nd<T, N> & v, index_t axis)
+    {
+        return line_iterator<T, N>(v, shape_t<1>{axis});
+    }
+
+    template <class T, index_t N>
+    inline line_iterator<typename view_nd<T, N>::const_value_type, N>
+    make_line_iterator(view_nd<T, N> const & v, index_t axis)
+    {
+        return line_iterator<typename view_nd<T, N>::const_value_type, N>(v, shape_t<1>{axis});
+    }
+
+        /** \brief Create a subarray_iterator over all M-dimensional subarrays
+            spanned by 'axes'.
+         */
+    template <index_t M, class T, index_t N>
+    inline subarray_iterator<T, M, N>
+    make_subarray_iterator(view_nd<T, N> & v, shape_t<M> const & axes)
+    {
+        return subarray_iterator<T, M, N>(v, axes);
+    }
+
+    template <index_t M, class T, index_t N>
+    inline subarray_iterator<typename view_nd<T, N>::const_value_type, M, N>
+    make_subarray_iterator(view_nd<T, N> const & v, shape_t<M> const & axes)
+    {
+        return subarray_iterator<typename view_nd<T, N>::const_value_type, M, N>(v, axes);
+    }
+
+} // namespace xvigra
+
+#endif // XVIGRA_LINE_ITERATOR_HPP
@@ -0,0 +1,497 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_MEMORY_MAP_HPP
+#define XVIGRA_MEMORY_MAP_HPP
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// memory mapping currently uses the POSIX API
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "global.hpp"
+#include "error.hpp"
+#include "array_nd.hpp"
+
+namespace xvigra
+{
+    /*******************/
+    /* memory_map_mode */
+    /*******************/
+
+        /** \brief Access mode of a memory-mapped file.
+
+            <tt>map_read_only</tt>: pages are shared with the file and must not
+            be modified (use a <tt>const</tt> value_type).<br>
+            <tt>map_copy_on_write</tt>: pages may be modified, but changes are
+            private to the process and never written back to the file.
+        */
+    enum memory_map_mode
+    {
+        map_read_only,
+        map_copy_on_write
+    };
+
+    /***************/
+    /* mapped_file */
+    /***************/
+
+        /** \brief RAII handle for a memory-mapped region of a file.
+
+            The file descriptor is closed right after mapping, the region
+            stays valid until the handle is destroyed. Pages are loaded on demand.
+        */
+    class mapped_file
+    {
+      public:
+
+        mapped_file(std::string const & filename, memory_map_mode mode,
+                    std::size_t offset = 0, std::size_t length = 0)
+        : region_(0)
+        , region_size_(0)
+        , data_(0)
+        , size_(0)
+        , mode_(mode)
+        {
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            vigra_precondition(fd >= 0,
+                "mapped_file(): unable to open file '" + filename + "'.");
+
+            struct stat info;
+            if(::fstat(fd, &info) != 0)
+            {
+                ::close(fd);
+                vigra_fail("mapped_file(): unable to determine size of file '" + filename + "'.");
+            }
+
+            std::size_t file_size = static_cast<std::size_t>(info.st_size);
+            if(length == 0 && offset <= file_size)
+            {
+                length = file_size - offset;
+            }
+            if(offset + length > file_size || length == 0)
+            {
+                ::close(fd);
+                vigra_fail("mapped_file(): requested range exceeds size of file '" + filename + "'.");
+            }
+
+                // mmap() requires the offset to be a multiple of the page size
+            std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGE_SIZE));
+            std::size_t page_offset = offset - offset % page;
+
+            region_size_ = length + (offset - page_offset);
+            int prot  = (mode == map_read_only)
+                            ? PROT_READ
+                            : PROT_READ | PROT_WRITE;
+            int flags = (mode == map_read_only)
+                            ? MAP_SHARED
+                            : MAP_PRIVATE;
+            region_ = ::mmap(0, region_size_, prot, flags, fd, static_cast<off_t>(page_offset));
+            ::close(fd);
+            vigra_precondition(region_ != MAP_FAILED,
+                "mapped_file(): unable to map file '" + filename + "'.");
+
+            data_ = static_cast<char *>(region_) + (offset - page_offset);
+            size_ = length;
+        }
+
+        ~mapped_file()
+        {
+            if(region_ != 0 && region_ != MAP_FAILED)
+            {
+                ::munmap(region_, region_size_);
+            }
+        }
+
+        mapped_file(mapped_file const &) = delete;
+        mapped_file & operator=(mapped_file const &) = delete;
+
+            /** pointer to the first byte of the requested range
+            */
+        char * data() const
+        {
+            return data_;
+        }
+
+            /** number of bytes in the requested range
+            */
+        std::size_t size() const
+        {
+            return size_;
+        }
+
+        memory_map_mode mode() const
+        {
+            return mode_;
+        }
+
+      private:
+
+        void * region_;
+        std::size_t region_size_;
+        char * data_;
+        std::size_t size_;
+        memory_map_mode mode_;
+    };
+
+    /******************/
+    /* mapped_array_nd */
+    /******************/
+
+        /** \brief Array whose data reside in a memory-mapped file.
+
+            The class behaves like an <tt>array_nd</tt> whose memory is owned by
+            a <tt>mapped_file</tt> handle instead of an allocator. Views created from it
+            (via <tt>view()</tt>, <tt>bind()</tt> etc.) do not keep the mapping alive,
+            just as views of an <tt>array_nd</tt> don't keep its buffer alive.
+            Objects are created by <tt>map_raw()</tt> and <tt>map_npy()</tt>.
+        */
+    template <class T, index_t N=runtime_size>
+    class mapped_array_nd
+    : public view_nd<T, N>
+    {
+      public:
+        using view_type = view_nd<T, N>;
+        using shape_type = typename view_type::shape_type;
+        using axistags_type = typename view_type::axistags_type;
+        using pointer = typename view_type::pointer;
+
+        mapped_array_nd()
+        {}
+
+        mapped_array_nd(std::shared_ptr<mapped_file> file,
+                        shape_type const & shape,
+                        shape_type const & strides,
+                        axistags_type const & axistags)
+        : view_type(shape, strides, axistags, reinterpret_cast<pointer>(file->data()))
+        , file_(std::move(file))
+        {
+            this->flags_ |= this->owns_memory_flag;
+        }
+
+        mapped_array_nd(mapped_array_nd const & rhs)
+        : view_type(rhs)
+        , file_(rhs.file_)
+        {
+            if(file_)
+            {
+                this->flags_ |= this->owns_memory_flag;
+            }
+        }
+
+        mapped_array_nd(mapped_array_nd && rhs)
+        : view_type(rhs)
+        , file_(std::move(rhs.file_))
+        {
+            if(file_)
+            {
+                this->flags_ |= this->owns_memory_flag;
+            }
+        }
+
+            /** Copy assignment.<br>
+                When the lhs is empty, it becomes another handle to the rhs mapping.
+                Otherwise, the data are copied (which requires a copy-on-write mapping).
+             */
+        mapped_array_nd & operator=(mapped_array_nd const & rhs)
+        {
+            if(this != &rhs)
+            {
+                if(!this->has_data())
+                {
+                    view_type::operator=(rhs);
+                    file_ = rhs.file_;
+                    if(file_)
+                    {
+                        this->flags_ |= this->owns_memory_flag;
+                    }
+                }
+                else
+                {
+                    view_type::operator=(rhs);
+                }
+            }
+            return *this;
+        }
+
+        using view_type::operator=;
+
+            /** the underlying file mapping
+            */
+        std::shared_ptr<mapped_file> const & file() const
+        {
+            return file_;
+        }
+
+      private:
+
+        std::shared_ptr<mapped_file> file_;
+    };
+
+    namespace detail
+    {
+        template <class T>
+        inline void
+        check_memory_map_mode(memory_map_mode mode, std::string const & function)
+        {
+            vigra_precondition(mode == map_copy_on_write || std::is_const<T>::value,
+                function + "(): read-only mappings require a const value_type.");
+        }
+
+        inline bool
+        is_little_endian()
+        {
+            const std::uint16_t one = 1;
+            return *reinterpret_cast<const char *>(&one) == 1;
+        }
+    }
+
+    /***********/
+    /* map_raw */
+    /***********/
+
+        /** \brief Map a headerless binary file into memory.
+
+            The file must contain the array elements in native byte order,
+            starting at byte position \a offset. The returned array has the given
+            \a shape and \a order. No data are read until they are accessed.
+
+            <b>Usage:</b>
+            \code
+            // read-only access to a 2048 x 2048 x 2048 volume of uint16
+            auto volume = map_raw<const uint16_t, 3>("volume.raw", {2048, 2048, 2048});
+
+            // modifiable private copy, the file remains unchanged
+            auto copy = map_raw<float>("data.raw", {100, 200}, map_copy_on_write);
+            \endcode
+        */
+    template <class T, index_t N=runtime_size>
+    mapped_array_nd<T, N>
+    map_raw(std::string const & filename,
+            shape_t<N> const & shape,
+            memory_map_mode mode = map_read_only,
+            std::size_t offset = 0,
+            tags::memory_order order = c_order)
+    {
+        detail::check_memory_map_mode<T>(mode, "map_raw");
+        vigra_precondition(shape.size() > 0 && all_greater(shape, 0),
+            "map_raw(): shape must be non-empty and positive.");
+
+        using axistags_type = typename mapped_array_nd<T, N>::axistags_type;
+        std::size_t length = prod(shape) * sizeof(T);
+        auto file = std::make_shared<mapped_file>(filename, mode, offset, length);
+        return mapped_array_nd<T, N>(std::move(file), shape, shape_to_strides(shape, order),
+                                     axistags_type(shape.size(), tags::axis_unknown));
+    }
+
+    /***********/
+    /* map_npy */
+    /***********/
+
+    namespace detail
+    {
+        template <class T>
+        inline char
+        npy_type_kind()
+        {
+            return std::is_same<std::remove_cv_t<T>, bool>::value
+                       ? 'b'
+                       : std::is_floating_point<T>::value
+                           ? 'f'
+                           : std::is_signed<T>::value
+                               ? 'i'
+                               : 'u';
+        }
+
+            // extract the value of 'key' from the header dictionary of a .npy file
+        inline std::string
+        npy_header_entry(std::string const & header, std::string const & key)
+        {
+            std::size_t pos = header.find("'" + key + "'");
+            vigra_precondition(pos != std::string::npos,
+                "map_npy(): header has no entry '" + key + "'.");
+            pos = header.find(':', pos);
+            vigra_precondition(pos != std::string::npos,
+                "map_npy(): malformed header.");
+            pos = header.find_first_not_of(' ', pos + 1);
+            vigra_precondition(pos != std::string::npos,
+                "map_npy(): malformed header.");
+
+            std::size_t end = std::string::npos;
+            switch(header[pos])
+            {
+                case '\'':
+                    end = header.find('\'', pos + 1) + 1;
+                    break;
+                case '(':
+                    end = header.find(')', pos + 1) + 1;
+                    break;
+                default:
+                    end = header.find_first_of(",}", pos);
+            }
+            vigra_precondition(end != std::string::npos && end != 0,
+                "map_npy(): malformed header.");
+            return header.substr(pos, end - pos);
+        }
+
+        struct npy_header
+        {
+            std::string descr;
+            bool fortran_order;
+            shape_t<> shape;
+            std::size_t data_offset;
+        };
+
+        inline npy_header
+        read_npy_header(std::string const & filename)
+        {
+            int fd = ::open(filename.c_str(), O_RDONLY);
+            vigra_precondition(fd >= 0,
+                "map_npy(): unable to open file '" + filename + "'.");
+
+            char preamble[12];
+            ssize_t count = ::read(fd, preamble, sizeof(preamble));
+            if(count < 10 || std::memcmp(preamble, "\x93NUMPY", 6) != 0)
+            {
+                ::close(fd);
+                vigra_fail("map_npy(): '" + filename + "' is not a .npy file.");
+            }
+
+            int major_version = static_cast<unsigned char>(preamble[6]);
+            std::size_t header_length = 0, header_start = 0;
+            if(major_version == 1)
+            {
+                header_length = static_cast<unsigned char>(preamble[8]) |
+                                (static_cast<std::size_t>(static_cast<unsigned char>(preamble[9])) << 8);
+                header_start = 10;
+            }
+            else if((major_version == 2 || major_version == 3) && count == 12)
+            {
+                for(int k = 3; k >= 0; --k)
+                {
+                    header_length = (header_length << 8) | static_cast<unsigned char>(preamble[8+k]);
+                }
+                header_start = 12;
+            }
+            else
+            {
+                ::close(fd);
+                vigra_fail("map_npy(): unsupported .npy format version in '" + filename + "'.");
+            }
+
+            std::string header(header_length, ' ');
+            count = ::pread(fd, &header[0], header_length, static_cast<off_t>(header_start));
+            ::close(fd);
+            vigra_precondition(count == static_cast<ssize_t>(header_length),
+                "map_npy(): unable to read header of '" + filename + "'.");
+
+            npy_header res;
+            res.data_offset = header_start + header_length;
+
+            std::string descr = npy_header_entry(header, "descr");
+            res.descr = descr.substr(1, descr.size() - 2);
+            res.fortran_order = npy_header_entry(header, "fortran_order") == "True";
+
+            std::string shape = npy_header_entry(header, "shape");
+            for(std::size_t pos = 1; pos < shape.size() - 1; )
+            {
+                std::size_t end = shape.find_first_of(",)", pos);
+                std::string item = shape.substr(pos, end - pos);
+                if(item.find_first_not_of(' ') != std::string::npos)
+                {
+                    res.shape = res.shape.push_back(std::stoll(item));
+                }
+                pos = end + 1;
+            }
+            return res;
+        }
+    }
+
+        /** \brief Map an array stored in NumPy's .npy format into memory.
+
+            The header is parsed to determine shape and memory order. The element type
+            in the file must match \a T exactly (kind, size, and byte order), since
+            no conversion takes place. When \a N is not <tt>runtime_size</tt>,
+            it must match the dimension in the file. No data are read until they are accessed.
+
+            <b>Usage:</b>
+            \code
+            auto a = map_npy<const float>("features.npy");
+            std::cout << a.shape() << "\n";
+            \endcode
+        */
+    template <class T, index_t N=runtime_size>
+    mapped_array_nd<T, N>
+    map_npy(std::string const & filename,
+            memory_map_mode mode = map_read_only)
+    {
+        detail::check_memory_map_mode<T>(mode, "map_npy");
+
+        using value_type = std::remove_cv_t<T>;
+        using shape_type = typename mapped_array_nd<T, N>::shape_type;
+        using axistags_type = typename mapped_array_nd<T, N>::axistags_type;
+
+        detail::npy_header header = detail::read_npy_header(filename);
+
+        vigra_precondition(header.descr.size() >= 3,
+            "map_npy(): unsupported dtype '" + header.descr + "'.");
+        char byte_order = header.descr[0];
+        vigra_precondition(byte_order == '|' || byte_order == '=' ||
+                           (byte_order == '<') == detail::is_little_endian(),
+            "map_npy(): byte order of '" + filename + "' differs from native byte order.");
+        vigra_precondition(header.descr[1] == detail::npy_type_kind<value_type>() &&
+                           std::stoul(header.descr.substr(2)) == sizeof(value_type),
+            "map_npy(): dtype '" + header.descr + "' doesn't match the requested value_type.");
+
+        vigra_precondition(header.shape.size() > 0 && all_greater(header.shape, 0),
+            "map_npy(): only non-empty arrays with at least one dimension can be mapped.");
+        vigra_precondition(N == runtime_size || N == header.shape.size(),
+            "map_npy(): dimension of '" + filename + "' doesn't match N.");
+
+        shape_type shape(header.shape.begin(), header.shape.end());
+        tags::memory_order order = header.fortran_order
+                                        ? f_order
+                                        : c_order;
+        std::size_t length = prod(shape) * sizeof(T);
+        auto file = std::make_shared<mapped_file>(filename, mode, header.data_offset, length);
+        return mapped_array_nd<T, N>(std::move(file), shape, shape_to_strides(shape, order),
+                                     axistags_type(shape.size(), tags::axis_unknown));
+    }
+
+} // namespace xvigra
+
+#endif // XVIGRA_MEMORY_MAP_HPP
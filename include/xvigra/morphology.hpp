@@ -52,7 +52,7 @@ namespace xvigra
                   double radius, bool dilation)
             {
                 // work on a real-valued temporary array if the squared distances wouldn't fit
-                rebind_container_t<OutArray, TmpType> tmp(out.shape());
+                rebind_temporary_t<OutArray, TmpType> tmp(out.shape());
 
                 distance_transform_squared(in, tmp, dilation);
 
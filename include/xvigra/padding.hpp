@@ -48,28 +48,20 @@ namespace xvigra
         reflect0_padding
     };
 
-    // 'in' and 'out' must be 1-dimensional arrays whose sizes fulfill:
-    // 'left_padding_size + in.size() + right_padding_size == out.size()'
-    // For padding modes periodic_padding, reflect_padding, reflect0_padding:
-    // 'left_padding_size < in.size() && right_padding_size < in.size()'
-    // For padding mode no_padding:
-    // 'left_padding_size == 0 && right_padding_size == 0'
-    template <class InArray, class OutArray,
-              VIGRA_REQUIRE<tensor_concept<InArray>::value && tensor_concept<OutArray>::value>>
-    void copy_with_padding(InArray const & in, OutArray && out,
-                           padding_mode left_padding_mode, index_t left_padding_size,
-                           padding_mode right_padding_mode, index_t right_padding_size)
+    // Fill the first 'left_padding_size' and the last 'right_padding_size' elements
+    // of the 1-dimensional array 'out' from the elements in between, which must
+    // already hold the data. The same preconditions as in copy_with_padding() apply.
+    template <class OutArray,
+              VIGRA_REQUIRE<tensor_concept<OutArray>::value>>
+    void apply_padding(OutArray && out,
+                       padding_mode left_padding_mode, index_t left_padding_size,
+                       padding_mode right_padding_mode, index_t right_padding_size)
     {
         using dest_type =  typename std::decay_t<OutArray>::value_type;
 
-        index_t size = in.size();
-        vigra_precondition(left_padding_size + size + right_padding_size == (index_t)out.size(),
-            "copy_with_padding(): output size must equal input size plus padding sizes.");
-
-        for(index_t k=0; k<(index_t)in.shape()[0]; ++k)
-        {
-            out(k+left_padding_size) = in(k);
-        }
+        index_t size = (index_t)out.size() - left_padding_size - right_padding_size;
+        vigra_precondition(size >= 0,
+            "apply_padding(): padding sizes must not exceed the output size.");
 
         switch(left_padding_mode)
         {
@@ -84,23 +76,23 @@ namespace xvigra
             case repeat_padding:
             {
                 vigra_precondition(size > 0,
-                    "copy_with_padding(): input size must be non-zero.");
+                    "apply_padding(): data size must be non-zero.");
 
                 for(index_t k=0; k<left_padding_size; ++k)
                 {
-                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(in(0));
+                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(out(left_padding_size));
                 }
                 break;
             }
             case periodic_padding:
             {
                 vigra_precondition(left_padding_size < size,
-                    "copy_with_padding(): left_padding_size must be less than input size.");
+                    "apply_padding(): left_padding_size must be less than data size.");
 
                 index_t offset = size-left_padding_size;
                 for(index_t k=0; k < left_padding_size; ++k)
                 {
-                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(in(offset+k));
+                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(out(left_padding_size+offset+k));
                 }
                 break;
             }
@@ -108,7 +100,7 @@ namespace xvigra
             case reflect0_padding:
             {
                 vigra_precondition(left_padding_size < size,
-                    "copy_with_padding(): left_padding_size must be less than input size.");
+                    "apply_padding(): left_padding_size must be less than data size.");
 
                 index_t offset = left_padding_size;
                 if(left_padding_mode == reflect0_padding)
@@ -117,14 +109,14 @@ namespace xvigra
                 }
                 for(index_t k=0; k < left_padding_size; ++k)
                 {
-                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(in(offset-k));
+                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(out(left_padding_size+offset-k));
                 }
                 break;
             }
             default:
             {
                 vigra_precondition(left_padding_mode == no_padding,
-                    "copy_with_padding(): illegal left_padding_mode.");
+                    "apply_padding(): illegal left_padding_mode.");
             }
         }
 
@@ -141,23 +133,23 @@ namespace xvigra
             case repeat_padding:
             {
                 vigra_precondition(size > 0,
-                    "copy_with_padding(): input size must be non-zero.");
+                    "apply_padding(): data size must be non-zero.");
 
                 for(index_t k=size+left_padding_size; k<(index_t)out.shape()[0]; ++k)
                 {
-                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(in(size-1));
+                    out(k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(out(left_padding_size+size-1));
                 }
                 break;
             }
             case periodic_padding:
             {
                 vigra_precondition(right_padding_size < size,
-                    "copy_with_padding(): right_padding_size must be less than input size.");
+                    "apply_padding(): right_padding_size must be less than data size.");
 
                 index_t offset = size + left_padding_size;
                 for(index_t k=0; k < right_padding_size; ++k)
                 {
-                    out(offset+k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(in(k));
+                    out(offset+k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(out(left_padding_size+k));
                 }
                 break;
             }
@@ -165,7 +157,7 @@ namespace xvigra
             case reflect0_padding:
             {
                 vigra_precondition(right_padding_size < size,
-                    "copy_with_padding(): right_padding_size must be less than input size.");
+                    "apply_padding(): right_padding_size must be less than data size.");
 
                 index_t in_offset  = size - 1,
                         out_offset = size + left_padding_size;
@@ -175,18 +167,43 @@ namespace xvigra
                 }
                 for(index_t k=0; k < right_padding_size; ++k)
                 {
-                    out(out_offset+k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(in(in_offset-k));
+                    out(out_offset+k) = conditional_cast<std::is_arithmetic<dest_type>::value, dest_type>(out(left_padding_size+in_offset-k));
                 }
                 break;
             }
             default:
             {
                 vigra_precondition(right_padding_mode == no_padding,
-                    "copy_with_padding(): illegal right_padding_mode.");
+                    "apply_padding(): illegal right_padding_mode.");
             }
         }
     }
 
+    // 'in' and 'out' must be 1-dimensional arrays whose sizes fulfill:
+    // 'left_padding_size + in.size() + right_padding_size == out.size()'
+    // For padding modes periodic_padding, reflect_padding, reflect0_padding:
+    // 'left_padding_size < in.size() && right_padding_size < in.size()'
+    // For padding mode no_padding:
+    // 'left_padding_size == 0 && right_padding_size == 0'
+    template <class InArray, class OutArray,
+              VIGRA_REQUIRE<tensor_concept<InArray>::value && tensor_concept<OutArray>::value>>
+    void copy_with_padding(InArray const & in, OutArray && out,
+                           padding_mode left_padding_mode, index_t left_padding_size,
+                           padding_mode right_padding_mode, index_t right_padding_size)
+    {
+        index_t size = in.size();
+        vigra_precondition(left_padding_size + size + right_padding_size == (index_t)out.size(),
+            "copy_with_padding(): output size must equal input size plus padding sizes.");
+
+        for(index_t k=0; k<(index_t)in.shape()[0]; ++k)
+        {
+            out(k+left_padding_size) = in(k);
+        }
+
+        apply_padding(std::forward<OutArray>(out), left_padding_mode, left_padding_size,
+                      right_padding_mode, right_padding_size);
+    }
+
     template <class InArray, class OutArray,
               VIGRA_REQUIRE<tensor_concept<InArray>::value && tensor_concept<OutArray>::value>>
     void copy_with_padding(InArray const & in, OutArray && out,
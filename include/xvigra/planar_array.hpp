@@ -0,0 +1,432 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_PLANAR_ARRAY_HPP
+#define XVIGRA_PLANAR_ARRAY_HPP
+
+#include <type_traits>
+#include <utility>
+
+#include "global.hpp"
+#include "error.hpp"
+#include "tiny_vector.hpp"
+#include "array_nd.hpp"
+#include "transpose.hpp"
+
+namespace xvigra
+{
+    /********************/
+    /* planar_reference */
+    /********************/
+
+        /** \brief Proxy for an element of a planar array.
+
+            Behaves like a <tt>tiny_vector<T, C></tt> whose components are
+            <tt>stride</tt> elements apart in memory.
+        */
+    template <class T, index_t C>
+    class planar_reference
+    {
+      public:
+        using value_type = tiny_vector<std::remove_const_t<T>, C>;
+
+        planar_reference(T * p, index_t stride)
+        : data_(p)
+        , stride_(stride)
+        {}
+
+        T & operator[](index_t c) const
+        {
+            XVIGRA_ASSERT_MSG(0 <= c && c < C,
+                "planar_reference::operator[]: index out of range.");
+            return data_[c*stride_];
+        }
+
+        constexpr index_t size() const
+        {
+            return C;
+        }
+
+        value_type get() const
+        {
+            value_type res(dont_init);
+            for(index_t c=0; c<C; ++c)
+            {
+                res[c] = data_[c*stride_];
+            }
+            return res;
+        }
+
+        operator value_type() const
+        {
+            return get();
+        }
+
+        template <class U, index_t M, class R>
+        planar_reference & operator=(tiny_vector<U, M, R> const & v)
+        {
+            static_assert(M == C || M == runtime_size,
+                "planar_reference::operator=(): size mismatch.");
+            XVIGRA_ASSERT_MSG(v.size() == C,
+                "planar_reference::operator=(): size mismatch.");
+            for(index_t c=0; c<C; ++c)
+            {
+                data_[c*stride_] = static_cast<T>(v[c]);
+            }
+            return *this;
+        }
+
+            // assign values, not the reference
+        planar_reference & operator=(planar_reference const & other)
+        {
+            return *this = other.get();
+        }
+
+      private:
+        T * data_;
+        index_t stride_;
+    };
+
+    /******************/
+    /* planar_view_nd */
+    /******************/
+
+        /** \brief View to an array of <tt>tiny_vector<T, C></tt> with planar
+            (structure-of-arrays) memory layout.
+
+            The data are stored in a scalar array with the channels along axis 0, so that
+            each channel is a separate plane with the same layout as a scalar image. Elements
+            are accessed as <tt>tiny_vector</tt>s via proxies, and each plane can be processed
+            as an ordinary <tt>view_nd<T, N></tt>, e.g. by the SIMD kernels of
+            <tt>separable_convolution()</tt>, see \ref for_each_plane(). Expanding the
+            channel axis (\ref expand_elements()) or wrapping a channel-first view
+            (the constructor) doesn't copy any data.
+        */
+    template <class T, index_t C, index_t N=runtime_size>
+    class planar_view_nd
+    {
+      public:
+        static_assert(C > 0,
+            "planar_view_nd<T, C, N>: channel count must be positive.");
+
+        static constexpr index_t channel_count = C;
+        static constexpr index_t ndim = N;
+        static constexpr index_t planar_dimension = N == runtime_size ? runtime_size : N + 1;
+
+        using value_type = tiny_vector<std::remove_const_t<T>, C>;
+        using reference = planar_reference<T, C>;
+        using const_reference = planar_reference<T const, C>;
+        using plane_type = view_nd<T, N>;
+        using planar_type = view_nd<T, planar_dimension>;
+        using shape_type = shape_t<N>;
+
+        planar_view_nd()
+        : planes_()
+        , first_()
+        {}
+
+            // interpret axis 0 of 'v' as the channel axis
+        explicit planar_view_nd(planar_type const & v)
+        {
+            reset(v);
+        }
+
+        planar_view_nd(planar_view_nd const & other)
+        : planes_(other.planes_)
+        , first_(other.first_)
+        , channel_stride_(other.channel_stride_)
+        {}
+
+            // like view_nd: copy the data when the view is already bound,
+            // otherwise bind the view to the data of 'other'
+        planar_view_nd & operator=(planar_view_nd const & other)
+        {
+            if(this != &other)
+            {
+                if(planes_.has_data())
+                {
+                    planes_ = other.planes_;
+                }
+                else
+                {
+                    reset(other.planes_);
+                }
+            }
+            return *this;
+        }
+
+        index_t dimension() const
+        {
+            return first_.dimension();
+        }
+
+        shape_type const & shape() const
+        {
+            return first_.shape();
+        }
+
+        index_t shape(index_t d) const
+        {
+            return first_.shape(d);
+        }
+
+        index_t size() const
+        {
+            return first_.size();
+        }
+
+            // distance between corresponding elements of consecutive channels
+        index_t channel_stride() const
+        {
+            return channel_stride_;
+        }
+
+            // the plane of channel 'c'
+        plane_type channel(index_t c) const
+        {
+            vigra_precondition(0 <= c && c < C,
+                "planar_view_nd::channel(): index out of range.");
+            return planes_.bind(0, c);
+        }
+
+            // the data as a scalar array with channel axis 0
+        planar_type const & view() const
+        {
+            return planes_;
+        }
+
+            // the data as a scalar array with the channel axis at position 'd'
+        planar_type expand_elements(index_t d) const
+        {
+            vigra_precondition(0 <= d && d <= dimension(),
+                "planar_view_nd::expand_elements(): 0 <= 'd' <= dimension() required.");
+            auto permutation = shape_t<>::range(planes_.dimension()).erase(0).insert(d, 0);
+            return planes_.transpose(permutation);
+        }
+
+        template <class ... INDICES>
+        reference operator()(INDICES ... i)
+        {
+            return reference(&first_(i...), channel_stride_);
+        }
+
+        template <class ... INDICES>
+        const_reference operator()(INDICES ... i) const
+        {
+            return const_reference(&first_(i...), channel_stride_);
+        }
+
+        reference operator[](shape_type const & p)
+        {
+            return reference(&first_[p], channel_stride_);
+        }
+
+        const_reference operator[](shape_type const & p) const
+        {
+            return const_reference(&first_[p], channel_stride_);
+        }
+
+            // copy the data into an array with interleaved layout
+        array_nd<value_type, N> interleaved() const
+        {
+            array_nd<value_type, N> res(shape());
+            transpose_copy(planes_, res.expand_elements(0));
+            return res;
+        }
+
+      protected:
+        void reset(planar_type const & v)
+        {
+            vigra_precondition(v.dimension() >= 1 && v.shape(0) == C,
+                "planar_view_nd(): axis 0 must have length C.");
+            planar_type planes(v);
+            plane_type first = planes.bind(0, 0);
+            planes_.swap(planes);
+            first_.swap(first);
+            channel_stride_ = planes_.strides(0);
+        }
+
+        void clear()
+        {
+            planar_type planes;
+            plane_type first;
+            planes_.swap(planes);
+            first_.swap(first);
+            channel_stride_ = 0;
+        }
+
+        planar_type planes_;
+        plane_type first_;
+        index_t channel_stride_ = 0;
+    };
+
+    /*******************/
+    /* planar_array_nd */
+    /*******************/
+
+        /** \brief Array of <tt>tiny_vector<T, C></tt> with planar memory layout.
+
+            See \ref planar_view_nd for the element access and the plane functions.
+
+            <b>Usage:</b>
+            \code
+            array_nd<tiny_vector<float, 3>, 2> rgb = ...;
+
+            // convert from interleaved (RGBRGB...) to planar (RR...GG...BB...) layout
+            planar_array_nd<float, 3, 2> planar(rgb), smoothed(planar.shape());
+
+            // each channel is convolved at full SIMD width
+            for_each_plane(planar, smoothed, [](auto const & in, auto out)
+            {
+                separable_convolution(in, out, gaussian_kernel_1d<float>(2.0));
+            });
+
+            tiny_vector<float, 3> pixel = smoothed(10, 20);
+            smoothed(10, 20) = pixel * 2.0f;
+            \endcode
+        */
+    template <class T, index_t C, index_t N=runtime_size>
+    class planar_array_nd
+    : public planar_view_nd<T, C, N>
+    {
+        using base_type = planar_view_nd<T, C, N>;
+
+      public:
+        using base_type::planar_dimension;
+        using typename base_type::value_type;
+        using typename base_type::shape_type;
+        using typename base_type::planar_type;
+
+        planar_array_nd()
+        {}
+
+        planar_array_nd(planar_array_nd const & other)
+        : base_type()
+        , data_(other.data_)
+        {
+            reset_view();
+        }
+
+        explicit planar_array_nd(shape_type const & shape,
+                                 value_type const & init = value_type())
+        : data_(shape.insert(0, C))
+        {
+            data_.set_channel_axis(0);
+            this->reset(data_);
+            for(index_t c=0; c<C; ++c)
+            {
+                this->channel(c) = init[c];
+            }
+        }
+
+            // convert from interleaved layout
+        template <class U, index_t M>
+        explicit planar_array_nd(view_nd<tiny_vector<U, C>, M> const & interleaved)
+        : planar_array_nd(shape_type(interleaved.shape()))
+        {
+            transpose_copy(interleaved.expand_elements(0), data_.view());
+        }
+
+        planar_array_nd(planar_array_nd && other)
+        {
+            swap(other);
+        }
+
+        planar_array_nd & operator=(planar_array_nd const & other)
+        {
+            if(this != &other)
+            {
+                planar_array_nd tmp(other);
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        planar_array_nd & operator=(planar_array_nd && other)
+        {
+            swap(other);
+            return *this;
+        }
+
+        void swap(planar_array_nd & other)
+        {
+            data_.swap(other.data_);
+            reset_view();
+            other.reset_view();
+        }
+
+      private:
+        void reset_view()
+        {
+            if(data_.has_data())
+            {
+                this->reset(data_);
+            }
+            else
+            {
+                this->clear();
+            }
+        }
+
+        array_nd<T, planar_dimension> data_;
+    };
+
+    /******************/
+    /* for_each_plane */
+    /******************/
+
+        /** \brief Call <tt>f(plane)</tt> for each channel plane of a planar array.
+        */
+    template <class T, index_t C, index_t N, class F>
+    void for_each_plane(planar_view_nd<T, C, N> const & a, F && f)
+    {
+        for(index_t c=0; c<C; ++c)
+        {
+            f(a.channel(c));
+        }
+    }
+
+        /** \brief Call <tt>f(in_plane, out_plane)</tt> for corresponding channel planes
+            of two planar arrays.
+        */
+    template <class T1, class T2, index_t C, index_t N, class F>
+    void for_each_plane(planar_view_nd<T1, C, N> const & in, planar_view_nd<T2, C, N> const & out, F && f)
+    {
+        vigra_precondition(in.shape() == out.shape(),
+            "for_each_plane(): shape mismatch between input and output.");
+        for(index_t c=0; c<C; ++c)
+        {
+            f(in.channel(c), out.channel(c));
+        }
+    }
+
+} // namespace xvigra
+
+#endif // XVIGRA_PLANAR_ARRAY_HPP
@@ -0,0 +1,351 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_POOL_ALLOCATOR_HPP
+#define XVIGRA_POOL_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "global.hpp"
+
+    // Upper limit for the memory that each thread keeps in its pool after
+    // temporaries have been released.
+#ifndef XVIGRA_POOL_MAX_RETAINED_BYTES
+#  define XVIGRA_POOL_MAX_RETAINED_BYTES (std::size_t(1) << 28)
+#endif
+
+namespace xvigra
+{
+    /**************************/
+    /* pool_allocator_options */
+    /**************************/
+
+    struct pool_allocator_options
+    {
+            // if false, released blocks are returned to the system immediately
+        bool enabled = true;
+        std::size_t max_retained_bytes = XVIGRA_POOL_MAX_RETAINED_BYTES;
+    };
+
+        /** \brief Global pool settings, read on every allocation and deallocation.
+        */
+    inline pool_allocator_options & default_pool_allocator_options()
+    {
+        static pool_allocator_options options;
+        return options;
+    }
+
+    /*******************/
+    /* pool_statistics */
+    /*******************/
+
+    struct pool_statistics
+    {
+        index_t allocations = 0;     // number of allocate() calls
+        index_t pool_hits = 0;       // allocations served from the pool
+        index_t current_bytes = 0;   // bytes handed out and not yet returned
+        index_t peak_bytes = 0;      // maximum of current_bytes
+        index_t retained_bytes = 0;  // bytes kept in the pool for reuse
+    };
+
+    namespace detail
+    {
+        /***************/
+        /* memory_pool */
+        /***************/
+
+            // Thread-local cache of memory blocks, organized in size classes with
+            // four classes per power of two, so that rounding wastes at most 25%.
+        class memory_pool
+        {
+          public:
+            static constexpr std::size_t alignment = 64;
+            static constexpr std::size_t min_block_size = 64;
+
+            ~memory_pool()
+            {
+                release();
+                alive() = false;
+            }
+
+                // false after the pool of the current thread has been destroyed
+            static bool & alive()
+            {
+                static thread_local bool res = true;
+                return res;
+            }
+
+            void * allocate(std::size_t bytes)
+            {
+                std::size_t block_size = 0;
+                std::size_t c = size_class(bytes, block_size);
+
+                ++statistics_.allocations;
+                statistics_.current_bytes += block_size;
+                statistics_.peak_bytes = std::max(statistics_.peak_bytes, statistics_.current_bytes);
+
+                if(default_pool_allocator_options().enabled &&
+                   c < free_blocks_.size() && free_blocks_[c].size() > 0)
+                {
+                    void * p = free_blocks_[c].back();
+                    free_blocks_[c].pop_back();
+                    ++statistics_.pool_hits;
+                    statistics_.retained_bytes -= block_size;
+                    return p;
+                }
+                return allocate_block(block_size);
+            }
+
+            void deallocate(void * p, std::size_t bytes)
+            {
+                if(p == 0)
+                {
+                    return;
+                }
+                std::size_t block_size = 0;
+                std::size_t c = size_class(bytes, block_size);
+
+                statistics_.current_bytes -= block_size;
+                auto const & options = default_pool_allocator_options();
+                if(options.enabled &&
+                   statistics_.retained_bytes + block_size <= options.max_retained_bytes)
+                {
+                    if(c >= free_blocks_.size())
+                    {
+                        free_blocks_.resize(c+1);
+                    }
+                    free_blocks_[c].push_back(p);
+                    statistics_.retained_bytes += block_size;
+                }
+                else
+                {
+                    deallocate_block(p);
+                }
+            }
+
+                // return all cached blocks to the system
+            void release()
+            {
+                for(auto & blocks: free_blocks_)
+                {
+                    for(void * p: blocks)
+                    {
+                        deallocate_block(p);
+                    }
+                    blocks.clear();
+                }
+                statistics_.retained_bytes = 0;
+            }
+
+            pool_statistics & statistics()
+            {
+                return statistics_;
+            }
+
+            static std::size_t size_class(std::size_t bytes, std::size_t & block_size)
+            {
+                std::size_t base = min_block_size,
+                            c = 0;
+                while(true)
+                {
+                    for(std::size_t s=0; s<4; ++s, ++c)
+                    {
+                        block_size = base + s*(base / 4);
+                        if(block_size >= bytes)
+                        {
+                            return c;
+                        }
+                    }
+                    base *= 2;
+                }
+            }
+
+                // blocks are aligned to a cache line; the original pointer
+                // is stored in front of the aligned address
+            static void * allocate_block(std::size_t block_size)
+            {
+                char * raw = static_cast<char *>(::operator new(block_size + alignment));
+                char * aligned = reinterpret_cast<char *>(
+                                    (reinterpret_cast<std::uintptr_t>(raw) + alignment) & ~(alignment - 1));
+                reinterpret_cast<void **>(aligned)[-1] = raw;
+                return aligned;
+            }
+
+            static void deallocate_block(void * p)
+            {
+                ::operator delete(static_cast<void **>(p)[-1]);
+            }
+
+          private:
+            std::vector<std::vector<void *>> free_blocks_;
+            pool_statistics statistics_;
+        };
+
+        inline memory_pool & thread_memory_pool()
+        {
+            static thread_local memory_pool pool;
+            return pool;
+        }
+    } // namespace detail
+
+    /******************/
+    /* pool_allocator */
+    /******************/
+
+        /** \brief Allocator that recycles memory blocks in a thread-local pool.
+
+            Blocks are grouped into size classes. A released block is kept in the pool of
+            the releasing thread (up to <tt>pool_allocator_options::max_retained_bytes</tt>)
+            and handed out again for the next request of the same size class, so that
+            repeated temporaries don't cause mmap/munmap churn and page faults.
+
+            The allocator is meant for temporaries that are released by the thread that
+            allocated them. Memory freed by another thread is correct, but it moves into
+            that thread's pool and skews the per-thread statistics: the allocating
+            thread still counts the block in its <tt>current_bytes</tt>, and the releasing
+            thread's <tt>current_bytes</tt> can become negative.
+
+            The library's internal temporaries use <tt>XVIGRA_TEMPORARY_ALLOCATOR</tt>,
+            which defaults to <tt>pool_allocator</tt>. To use it for all arrays, define
+            <tt>XVIGRA_DEFAULT_ALLOCATOR(T)</tt> as <tt>xvigra::pool_allocator<T></tt>
+            before including any xvigra header, or pass it explicitly:
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 2, pool_allocator<float>> tile(shape_t<2>{512, 512});
+
+            pool_statistics stats = pool_allocator_statistics();
+            std::cout << stats.pool_hits << " of " << stats.allocations << " allocations reused, peak "
+                      << stats.peak_bytes << " bytes\n";
+            \endcode
+        */
+    template <class T>
+    class pool_allocator
+    {
+      public:
+        using value_type = T;
+        using pointer = T *;
+        using const_pointer = T const *;
+        using reference = T &;
+        using const_reference = T const &;
+        using size_type = std::size_t;
+        using difference_type = std::ptrdiff_t;
+
+        template <class U>
+        struct rebind
+        {
+            using other = pool_allocator<U>;
+        };
+
+        pool_allocator() noexcept
+        {}
+
+        template <class U>
+        pool_allocator(pool_allocator<U> const &) noexcept
+        {}
+
+        T * allocate(std::size_t n)
+        {
+            if(n > std::size_t(-1) / 4 / sizeof(T))
+            {
+                throw std::bad_alloc();
+            }
+            if(!detail::memory_pool::alive())
+            {
+                // the thread is shutting down: the block must nevertheless be
+                // compatible with the pool of another thread
+                std::size_t block_size = 0;
+                detail::memory_pool::size_class(n*sizeof(T), block_size);
+                return static_cast<T *>(detail::memory_pool::allocate_block(block_size));
+            }
+            return static_cast<T *>(detail::thread_memory_pool().allocate(n*sizeof(T)));
+        }
+
+        void deallocate(T * p, std::size_t n)
+        {
+            if(!detail::memory_pool::alive())
+            {
+                if(p != 0)
+                {
+                    detail::memory_pool::deallocate_block(p);
+                }
+                return;
+            }
+            detail::thread_memory_pool().deallocate(p, n*sizeof(T));
+        }
+    };
+
+    template <class T, class U>
+    inline bool
+    operator==(pool_allocator<T> const &, pool_allocator<U> const &)
+    {
+        return true;
+    }
+
+    template <class T, class U>
+    inline bool
+    operator!=(pool_allocator<T> const &, pool_allocator<U> const &)
+    {
+        return false;
+    }
+
+        /** \brief Pool statistics of the current thread.
+        */
+    inline pool_statistics pool_allocator_statistics()
+    {
+        return detail::thread_memory_pool().statistics();
+    }
+
+        /** \brief Reset the counters of the current thread's pool.
+
+            The peak is set to the currently allocated bytes.
+        */
+    inline void reset_pool_allocator_statistics()
+    {
+        pool_statistics & stats = detail::thread_memory_pool().statistics();
+        stats.allocations = 0;
+        stats.pool_hits = 0;
+        stats.peak_bytes = stats.current_bytes;
+    }
+
+        /** \brief Return the memory cached by the current thread's pool to the system.
+        */
+    inline void release_pool_memory()
+    {
+        detail::thread_memory_pool().release();
+    }
+
+} // namespace xvigra
+
+#endif // XVIGRA_POOL_ALLOCATOR_HPP
@@ -0,0 +1,352 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_PYRAMID_HPP
+#define XVIGRA_PYRAMID_HPP
+
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include "global.hpp"
+#include "error.hpp"
+#include "array_nd.hpp"
+#include "resample.hpp"
+
+namespace xvigra
+{
+    namespace detail
+    {
+        // Weights of the 5-tap binomial kernel (Burt and Adelson, 1983), evaluated
+        // at the even input positions only: out[j] = sum_k w[k] * in[2*j + k - 2].
+        inline resample_weights
+        pyramid_reduce_weights(index_t in_size, index_t out_size)
+        {
+            resample_weights res;
+            res.ksize  = 5;
+            res.period = 1;
+            res.weights = { 1.0/16.0, 4.0/16.0, 6.0/16.0, 4.0/16.0, 1.0/16.0 };
+            res.first.resize(out_size);
+            for(index_t j=0; j<out_size; ++j)
+            {
+                res.first[j] = 2*j - 2;
+            }
+            return res;
+        }
+
+        // The corresponding expansion: out[x] = 2 * sum_k w[k] * in[(x - k + 2)/2],
+        // summing only over the k where (x - k) is even.
+        inline resample_weights
+        pyramid_expand_weights(index_t in_size, index_t out_size)
+        {
+            resample_weights res;
+            res.ksize  = 3;
+            res.period = 2;
+            res.weights = { 1.0/8.0, 3.0/4.0, 1.0/8.0,    // even x
+                            1.0/2.0, 1.0/2.0, 0.0 };      // odd x
+            res.first.resize(out_size);
+            for(index_t x=0; x<out_size; ++x)
+            {
+                res.first[x] = x / 2 - 1 + x % 2;
+            }
+            return res;
+        }
+
+        // scratch and work buffers, taken from the temporary memory pool
+        template <class T>
+        using pyramid_buffer = std::vector<T, XVIGRA_TEMPORARY_ALLOCATOR(T)>;
+
+        // Resample the first 'spatial_dim' axes of 'in' to the shape of 'out', using
+        // the weights returned by make_weights(in_size, out_size).
+        template <class T, class F>
+        void pyramid_resample(view_nd<T> in, view_nd<T> out, index_t spatial_dim,
+                              pyramid_buffer<T> (&scratch)[2], F make_weights)
+        {
+            view_nd<T> current(in);
+            for(index_t d=0; d<spatial_dim; ++d)
+            {
+                view_nd<T> next;
+                if(d == spatial_dim - 1)
+                {
+                    view_nd<T>(out).swap(next);
+                }
+                else
+                {
+                    shape_t<> new_shape(current.shape());
+                    new_shape[d] = out.shape(d);
+                    scratch[d % 2].resize(prod(new_shape));
+                    view_nd<T>(new_shape, scratch[d % 2].data()).swap(next);
+                }
+                resample.resample_axis(current, next, d, std::vector<double>(),
+                                       make_weights(current.shape(d), out.shape(d)), true);
+                current.swap(next);
+            }
+        }
+    } // namespace detail
+
+    /****************/
+    /* pyramid_base */
+    /****************/
+
+        /** \brief Common storage of gaussian_pyramid and laplacian_pyramid.
+
+            All levels are stored in a single contiguous arena, level 0 first.
+            The first <tt>spatial_dimension()</tt> axes are halved from level to
+            level (rounding up). A remaining last axis is treated as channel axis
+            and keeps its size.
+        */
+    template <class T, index_t N>
+    class pyramid_base
+    {
+      public:
+        static_assert(std::is_floating_point<T>::value,
+                      "pyramid_base: value type must be a floating point type.");
+
+        using value_type      = T;
+        using shape_type      = shape_t<N>;
+        using view_type       = view_nd<T, N>;
+        using const_view_type = view_nd<T const, N>;
+
+            /** Number of levels.
+            */
+        index_t size() const
+        {
+            return (index_t)shapes_.size();
+        }
+
+        index_t spatial_dimension() const
+        {
+            return spatial_dimension_;
+        }
+
+        shape_type const & shape(index_t level) const
+        {
+            return shapes_[level];
+        }
+
+            /** Access a level. Level 0 has the original resolution.
+            */
+        view_type operator[](index_t level)
+        {
+            vigra_precondition(0 <= level && level < size(),
+                "pyramid::operator[]: level out of range.");
+            return view_type(shapes_[level], arena_.data() + offsets_[level]);
+        }
+
+        const_view_type operator[](index_t level) const
+        {
+            vigra_precondition(0 <= level && level < size(),
+                "pyramid::operator[]: level out of range.");
+            return const_view_type(shapes_[level], arena_.data() + offsets_[level]);
+        }
+
+            /** Total number of elements of all levels.
+            */
+        index_t arena_size() const
+        {
+            return (index_t)arena_.size();
+        }
+
+      protected:
+
+        template <class U, index_t M>
+        void build_gaussian(index_t spatial_dim, view_nd<U, M> const & image, index_t levels)
+        {
+            vigra_precondition(image.dimension() == spatial_dim || image.dimension() == spatial_dim+1,
+                "pyramid(): input dimension contradicts dimension_hint.");
+            vigra_precondition(levels > 0 && image.size() > 0,
+                "pyramid(): levels > 0 and non-empty input required.");
+
+            spatial_dimension_ = spatial_dim;
+            shape_type shape(image.shape());
+            index_t offset = 0;
+            for(index_t l=0; l<levels; ++l)
+            {
+                shapes_.push_back(shape);
+                offsets_.push_back(offset);
+                offset += prod(shape);
+
+                index_t max_extent = 1;
+                for(index_t d=0; d<spatial_dim; ++d)
+                {
+                    max_extent = std::max(max_extent, shape[d]);
+                    shape[d] = (shape[d] + 1) / 2;
+                }
+                if(max_extent == 1)
+                {
+                    break; // no further reduction possible
+                }
+            }
+            arena_.resize(offset);
+
+            (*this)[0] = image;
+            detail::pyramid_buffer<T> scratch[2];
+            for(index_t l=1; l<size(); ++l)
+            {
+                detail::pyramid_resample<T>((*this)[l-1], (*this)[l], spatial_dim, scratch,
+                                            detail::pyramid_reduce_weights);
+            }
+        }
+
+        // Expand 'in' (a level) to the shape of 'out' (the next finer level).
+        void expand(view_nd<T> in, view_nd<T> out, detail::pyramid_buffer<T> (&scratch)[2]) const
+        {
+            detail::pyramid_resample<T>(in, out, spatial_dimension_, scratch,
+                                        detail::pyramid_expand_weights);
+        }
+
+        // the levels are long-lived and may be released by another thread,
+        // so they don't use the thread-local temporary pool
+        std::vector<T, XVIGRA_DEFAULT_ALLOCATOR(T)> arena_;
+        std::vector<shape_type> shapes_;
+        std::vector<index_t> offsets_;
+        index_t spatial_dimension_ = 0;
+    };
+
+    /********************/
+    /* gaussian_pyramid */
+    /********************/
+
+        /** \brief Gaussian pyramid with 2x decimation per level.
+
+            Each level is computed from the previous one by smoothing with the
+            5-tap binomial kernel <tt>[1 4 6 4 1]/16</tt> (Burt and Adelson) along each
+            spatial axis, evaluated only at the retained samples. The axes are
+            processed one after the other, so that each pass already works on the
+            decimated result of the previous one.
+
+            The number of levels is limited such that the coarsest level is
+            at least 1 along all spatial axes. With a <tt>dimension_hint</tt>,
+            the input may have an additional channel axis at the end.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> rgb(...);  // shape (h, w, 3)
+            gaussian_pyramid<float, 3> pyramid(2_d, rgb, 4);
+            for(index_t l=0; l<pyramid.size(); ++l)
+            {
+                auto level = pyramid[l];  // shape ((h+1)/2, (w+1)/2, 3) for l == 1 etc.
+            }
+            \endcode
+        */
+    template <class T = float, index_t N = runtime_size>
+    class gaussian_pyramid
+    : public pyramid_base<T, N>
+    {
+      public:
+        template <class U, index_t M>
+        explicit gaussian_pyramid(view_nd<U, M> const & image,
+                                  index_t levels = std::numeric_limits<index_t>::max())
+        {
+            this->build_gaussian(image.dimension(), image, levels);
+        }
+
+        template <class U, index_t M>
+        gaussian_pyramid(dimension_hint dim, view_nd<U, M> const & image,
+                         index_t levels = std::numeric_limits<index_t>::max())
+        {
+            this->build_gaussian(dim, image, levels);
+        }
+    };
+
+    /*********************/
+    /* laplacian_pyramid */
+    /*********************/
+
+        /** \brief Laplacian pyramid (band-pass decomposition).
+
+            Level <tt>l</tt> holds the difference between level <tt>l</tt> of the
+            gaussian_pyramid and the expansion of level <tt>l+1</tt>. The last level
+            is the coarsest Gaussian level. <tt>reconstruct()</tt> inverts the
+            decomposition exactly (up to rounding).
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 2> image(...);
+            laplacian_pyramid<float, 2> pyramid(image, 5);
+            pyramid[0] *= 2.0f;  // amplify finest details
+            array_nd<float, 2> sharpened = pyramid.reconstruct();
+            \endcode
+        */
+    template <class T = float, index_t N = runtime_size>
+    class laplacian_pyramid
+    : public pyramid_base<T, N>
+    {
+      public:
+        template <class U, index_t M>
+        explicit laplacian_pyramid(view_nd<U, M> const & image,
+                                   index_t levels = std::numeric_limits<index_t>::max())
+        {
+            this->build_gaussian(image.dimension(), image, levels);
+            build_laplacian();
+        }
+
+        template <class U, index_t M>
+        laplacian_pyramid(dimension_hint dim, view_nd<U, M> const & image,
+                          index_t levels = std::numeric_limits<index_t>::max())
+        {
+            this->build_gaussian(dim, image, levels);
+            build_laplacian();
+        }
+
+            /** Reconstruct the image from the pyramid levels.
+            */
+        array_nd<T, N> reconstruct() const
+        {
+            detail::pyramid_buffer<T> scratch[2], buffers[2];
+            index_t top = this->size() - 1;
+            buffers[top % 2].assign(this->arena_.begin() + this->offsets_[top], this->arena_.end());
+            view_nd<T> current(shape_t<>(this->shapes_[top]), buffers[top % 2].data());
+            for(index_t l=top-1; l>=0; --l)
+            {
+                buffers[l % 2].resize(prod(this->shapes_[l]));
+                view_nd<T> next(shape_t<>(this->shapes_[l]), buffers[l % 2].data());
+                this->expand(current, next, scratch);
+                next += (*this)[l];
+                current.swap(next);
+            }
+            return array_nd<T, N>(current);
+        }
+
+      private:
+        void build_laplacian()
+        {
+            detail::pyramid_buffer<T> scratch[2], expanded;
+            for(index_t l=0; l<this->size()-1; ++l)
+            {
+                expanded.resize(prod(this->shapes_[l]));
+                view_nd<T> e(shape_t<>(this->shapes_[l]), expanded.data());
+                this->expand((*this)[l+1], e, scratch);
+                (*this)[l] -= e;
+            }
+        }
+    };
+} // namespace xvigra
+
+#endif // XVIGRA_PYRAMID_HPP
@@ -0,0 +1,494 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_RECURSIVE_FILTER_HPP
+#define XVIGRA_RECURSIVE_FILTER_HPP
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "global.hpp"
+#include "array_nd.hpp"
+#include "padding.hpp"
+#include "slice.hpp"
+#include "line_iterator.hpp"
+#include "functor_base.hpp"
+#include "separable_convolution.hpp"
+
+namespace xvigra
+{
+    /****************************/
+    /* recursive_filter_columns */
+    /****************************/
+
+    namespace detail
+    {
+        inline void recursive_filter_check(double z, padding_mode border)
+        {
+            vigra_precondition(std::abs(z) < 1.0,
+                "recursive_filter(): poles must satisfy |z| < 1.");
+            vigra_precondition(border == reflect_padding || border == repeat_padding || border == zero_padding,
+                "recursive_filter(): border treatment must be reflect_padding, repeat_padding, or zero_padding.");
+        }
+
+        // the filter response has decayed below machine precision after 'horizon' samples
+        template <class T>
+        index_t recursive_filter_horizon(double z)
+        {
+            double eps = std::numeric_limits<std::conditional_t<std::is_same<T, float>::value, float, double>>::epsilon();
+            return (index_t)std::ceil(std::log(eps) / std::log(std::abs(z)));
+        }
+
+        // Apply the first-order recursive filter with pole 'z' along axis 0 of 'data' (in-place),
+        // working along rows in the inner loop (as in convolve_columns()).
+        // The causal pass computes c+[j] = gain*f[j] + z*c+[j-1], the anti-causal pass
+        // c-[j] = z*(c-[j+1] - c+[j]) (Unser et al., "B-Spline Signal Processing", 1993).
+        // 'gain' must be (1-z)*(1-1/z) when the result is to be normalized to unit DC gain.
+        template <class T>
+        void recursive_filter_columns(view_nd<T, 2> data, double z, double gain,
+                                      padding_mode border, bool use_simd)
+        {
+            index_t n = data.shape(0),
+                    m = data.shape(1);
+            if(n < 2)
+            {
+                return; // a single sample is a constant signal, which passes unchanged
+            }
+
+            recursive_filter_check(z, border);
+
+#ifdef XVIGRA_USE_SIMD
+            use_simd = use_simd && std::is_floating_point<T>::value &&
+                       data.bind(0,0).is_contiguous();
+#else
+            use_simd = false;
+#endif
+
+                // row(j) *= a
+            auto scale_row = [&](index_t j, T a)
+            {
+                if(use_simd)
+                {
+                    detail::simd_mul_row(&data(j,0), m, &data(j,0), a);
+                }
+                else
+                {
+                    for(index_t l=0; l<m; ++l)
+                    {
+                        data(j,l) *= a;
+                    }
+                }
+            };
+
+                // row(j) += a*row(i)
+            auto fma_row = [&](index_t i, index_t j, T a)
+            {
+                if(use_simd)
+                {
+                    detail::simd_fma_row(&data(i,0), m, &data(j,0), a);
+                }
+                else
+                {
+                    for(index_t l=0; l<m; ++l)
+                    {
+                        data(j,l) += a*data(i,l);
+                    }
+                }
+            };
+
+            // initialization of the causal pass
+            std::vector<T> init(m, T());
+            if(border == reflect_padding)
+            {
+                index_t horizon = recursive_filter_horizon<T>(z);
+                if(horizon < n)
+                {
+                    double zk = 1.0;
+                    for(index_t k=0; k<horizon; ++k, zk *= z)
+                    {
+                        for(index_t l=0; l<m; ++l)
+                        {
+                            init[l] += static_cast<T>(zk)*data(k,l);
+                        }
+                    }
+                }
+                else
+                {
+                    // exact initialization for mirror-symmetric boundary conditions
+                    double zn  = std::pow(z, (double)(n-1)),
+                           z2n = zn*zn,
+                           zk  = z,
+                           iz  = 1.0 / z;
+                    for(index_t l=0; l<m; ++l)
+                    {
+                        init[l] = data(0,l) + static_cast<T>(zn)*data(n-1,l);
+                    }
+                    zn *= zn*iz; // z^(2n-3)
+                    for(index_t k=1; k<n-1; ++k, zk *= z, zn *= iz)
+                    {
+                        for(index_t l=0; l<m; ++l)
+                        {
+                            init[l] += static_cast<T>(zk + zn)*data(k,l);
+                        }
+                    }
+                    for(index_t l=0; l<m; ++l)
+                    {
+                        init[l] /= static_cast<T>(1.0 - z2n);
+                    }
+                }
+            }
+            else
+            {
+                double f = (border == repeat_padding)
+                               ? 1.0 / (1.0 - z)
+                               : 1.0;
+                for(index_t l=0; l<m; ++l)
+                {
+                    init[l] = static_cast<T>(f)*data(0,l);
+                }
+            }
+
+            // causal pass
+            for(index_t l=0; l<m; ++l)
+            {
+                data(0,l) = static_cast<T>(gain)*init[l];
+            }
+            for(index_t j=1; j<n; ++j)
+            {
+                if(gain != 1.0)
+                {
+                    scale_row(j, static_cast<T>(gain));
+                }
+                fma_row(j-1, j, static_cast<T>(z));
+            }
+
+            // initialization of the anti-causal pass
+            if(border == reflect_padding)
+            {
+                double a = z / (z*z - 1.0);
+                scale_row(n-1, static_cast<T>(a));
+                fma_row(n-2, n-1, static_cast<T>(a*z));
+            }
+            else if(border == repeat_padding)
+            {
+                scale_row(n-1, static_cast<T>(-z / (1.0 - z)));
+            }
+            else
+            {
+                scale_row(n-1, static_cast<T>(-z));
+            }
+
+            // anti-causal pass
+            for(index_t j=n-2; j>=0; --j)
+            {
+                scale_row(j, static_cast<T>(-z));
+                fma_row(j+1, j, static_cast<T>(z));
+            }
+        }
+
+        // The same filter as recursive_filter_columns() for a single strided line,
+        // used for the innermost axis where lines can't be processed side by side.
+        // Doesn't allocate; 'horizon' must be recursive_filter_horizon<T>(z).
+        template <class T>
+        void recursive_filter_line(T * data, index_t n, index_t stride,
+                                   double z, double gain, index_t horizon, padding_mode border)
+        {
+            if(n < 2)
+            {
+                return;
+            }
+
+            T const tz = static_cast<T>(z),
+                    tgain = static_cast<T>(gain);
+
+            // initialization of the causal pass
+            T init = T();
+            if(border == reflect_padding)
+            {
+                if(horizon < n)
+                {
+                    double zk = 1.0;
+                    for(index_t k=0; k<horizon; ++k, zk *= z)
+                    {
+                        init += static_cast<T>(zk)*data[k*stride];
+                    }
+                }
+                else
+                {
+                    double zn  = std::pow(z, (double)(n-1)),
+                           z2n = zn*zn,
+                           zk  = z,
+                           iz  = 1.0 / z;
+                    init = data[0] + static_cast<T>(zn)*data[(n-1)*stride];
+                    zn *= zn*iz; // z^(2n-3)
+                    for(index_t k=1; k<n-1; ++k, zk *= z, zn *= iz)
+                    {
+                        init += static_cast<T>(zk + zn)*data[k*stride];
+                    }
+                    init /= static_cast<T>(1.0 - z2n);
+                }
+            }
+            else
+            {
+                double f = (border == repeat_padding)
+                               ? 1.0 / (1.0 - z)
+                               : 1.0;
+                init = static_cast<T>(f)*data[0];
+            }
+
+            // causal pass
+            T * p = data;
+            T prev = tgain*init;
+            *p = prev;
+            for(index_t j=1; j<n; ++j)
+            {
+                p += stride;
+                prev = tgain * *p + tz*prev;
+                *p = prev;
+            }
+
+            // initialization of the anti-causal pass
+            if(border == reflect_padding)
+            {
+                double a = z / (z*z - 1.0);
+                prev = static_cast<T>(a) * *p + static_cast<T>(a*z) * p[-stride];
+            }
+            else if(border == repeat_padding)
+            {
+                prev = static_cast<T>(-z / (1.0 - z)) * *p;
+            }
+            else
+            {
+                prev = -tz * *p;
+            }
+            *p = prev;
+
+            // anti-causal pass
+            for(index_t j=n-2; j>=0; --j)
+            {
+                p -= stride;
+                prev = tz*(prev - *p);
+                *p = prev;
+            }
+        }
+    } // namespace detail
+
+    /****************************/
+    /* recursive_filter_functor */
+    /****************************/
+
+        /** \brief First-order recursive (IIR) filtering along all axes.
+
+            For each pole <tt>z</tt> in \a poles and each axis, a causal and an anti-causal
+            first-order filter is applied such that the combined filter has the transfer function
+
+            \f[ H(q) = \frac{(1-z)(1-1/z)}{(1 - z q^{-1})(1 - z q)} \f]
+
+            i.e. unit DC gain. This is exactly the inverse of sampled B-spline kernels when
+            the poles are taken from <tt>b_spline<ORDER>::prefilter_coefficients()</tt>
+            (see <tt>spline_prefilter</tt>). The border treatment may be
+            <tt>reflect_padding</tt> (default, exact for B-spline prefiltering),
+            <tt>repeat_padding</tt>, or <tt>zero_padding</tt>.
+
+            The filter works in-place when <tt>in</tt> and <tt>out</tt> refer to the same
+            memory. Integral destination types are computed via a real-valued temporary.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> volume(...), res(volume.shape());
+            recursive_filter(volume, res, -0.5);
+            recursive_filter(volume, volume, std::vector<double>{-0.43, -0.043}); // in-place
+            \endcode
+        */
+    struct recursive_filter_functor
+    : public functor_base<recursive_filter_functor>
+    {
+        std::string name = "recursive_filter";
+
+        template <class T1, index_t N1, class T2, index_t N2>
+        void impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                  std::vector<double> const & poles,
+                  padding_mode border = reflect_padding,
+                  bool use_simd = true) const
+        {
+            vigra_precondition(in.shape() == out.shape(),
+                name + "(): shape mismatch between input and output.");
+
+            if(!std::is_floating_point<T2>::value)
+            {
+                // work on a real-valued temporary array
+                temporary_array_nd<real_promote_type_t<T2>, N2> tmp(in);
+                impl(tmp, tmp, poles, border, use_simd);
+                out = round(tmp);
+                return;
+            }
+
+            if((void const *)in.raw_data() != (void const *)out.raw_data() || in.strides() != out.strides())
+            {
+                out = in;
+            }
+
+            // use static dimension for 2D and 3D data
+            dispatch_static_dimension(out, out, [&](auto &, auto & sout)
+            {
+                filter_axes(sout, poles, border, use_simd);
+            });
+        }
+
+        template <class T, index_t N>
+        void filter_axes(view_nd<T, N> out, std::vector<double> const & poles,
+                         padding_mode border, bool use_simd) const
+        {
+            index_t ndim = out.dimension();
+            for(index_t d=0; d<ndim; ++d)
+            {
+                if(d == ndim-1)
+                {
+                    // operate on last dimension, line by line
+                    recursive_filter_lines(out, d, poles, border);
+                }
+                else
+                {
+                    // operate on further dimensions, working along rows in the inner loop
+                    for(auto plane = make_subarray_iterator(out, shape_t<2>{d, ndim-1}); plane.has_more(); ++plane)
+                    {
+                        recursive_filter_axis(*plane, poles, border, use_simd);
+                    }
+                }
+            }
+        }
+
+        template <class T1, index_t N1, class T2, index_t N2>
+        void impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                  double pole,
+                  padding_mode border = reflect_padding,
+                  bool use_simd = true) const
+        {
+            impl(in, out, std::vector<double>(1, pole), border, use_simd);
+        }
+
+        template <class T, index_t N>
+        void recursive_filter_lines(view_nd<T, N> & out, index_t d,
+                                    std::vector<double> const & poles,
+                                    padding_mode border) const
+        {
+            index_t n = out.shape(d);
+            if(n < 2 || out.size() == 0)
+            {
+                return;
+            }
+            for(std::size_t k=0; k<poles.size(); ++k)
+            {
+                double z = poles[k];
+                if(z == 0.0)
+                {
+                    continue;
+                }
+                detail::recursive_filter_check(z, border);
+                double gain = (1.0 - z)*(1.0 - 1.0/z);
+                index_t horizon = detail::recursive_filter_horizon<T>(z);
+                for(auto line = make_line_iterator(out, d); line.has_more(); ++line)
+                {
+                    detail::recursive_filter_line((*line).raw_data(), n, (*line).strides(0),
+                                                  z, gain, horizon, border);
+                }
+            }
+        }
+
+        template <class T>
+        void recursive_filter_axis(view_nd<T, 2> && data, std::vector<double> const & poles,
+                                   padding_mode border, bool use_simd) const
+        {
+            for(std::size_t k=0; k<poles.size(); ++k)
+            {
+                double z = poles[k];
+                if(z == 0.0)
+                {
+                    continue;
+                }
+                detail::recursive_filter_columns(data, z, (1.0 - z)*(1.0 - 1.0/z), border, use_simd);
+            }
+        }
+    };
+
+    namespace
+    {
+        recursive_filter_functor  recursive_filter;
+
+        inline void recursive_filter_dummy()
+        {
+            std::ignore = recursive_filter;
+        }
+    }
+
+    /****************************/
+    /* spline_prefilter_functor */
+    /****************************/
+
+        /** \brief Compute B-spline coefficients for interpolation.
+
+            Applies <tt>recursive_filter</tt> with the poles
+            <tt>spline.prefilter_coefficients()</tt>, such that convolution of the
+            result with the sampled spline reproduces the input. When the spline
+            requires no prefiltering (e.g. orders 0 and 1, or <tt>catmull_rom_spline</tt>),
+            the input is just copied.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> volume(...), coefficients(volume.shape());
+            spline_prefilter(volume, coefficients, b_spline<3, float>());
+            \endcode
+        */
+    struct spline_prefilter_functor
+    : public functor_base<spline_prefilter_functor>
+    {
+        std::string name = "spline_prefilter";
+
+        template <class T1, index_t N1, class T2, index_t N2, class SPLINE>
+        void impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                  SPLINE const & spline,
+                  padding_mode border = reflect_padding) const
+        {
+            recursive_filter.impl(in, std::move(out), spline.prefilter_coefficients(), border);
+        }
+    };
+
+    namespace
+    {
+        spline_prefilter_functor  spline_prefilter;
+
+        inline void spline_prefilter_dummy()
+        {
+            std::ignore = spline_prefilter;
+        }
+    }
+} // namespace xvigra
+
+#endif // XVIGRA_RECURSIVE_FILTER_HPP
@@ -0,0 +1,744 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_REDUCTION_HPP
+#define XVIGRA_REDUCTION_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef XVIGRA_USE_SIMD
+#  include <xsimd/xsimd.hpp>
+#endif
+
+#include "global.hpp"
+#include "concepts.hpp"
+#include "error.hpp"
+#include "array_nd.hpp"
+#include "line_iterator.hpp"
+#include "streaming_store.hpp"
+
+namespace xvigra
+{
+    /*********************/
+    /* reduction_options */
+    /*********************/
+
+        /** \brief Options for the reductions in namespace <tt>reduce</tt>.
+
+            The data are split into at most <tt>thread_count</tt> parts of at least
+            <tt>min_elements_per_thread</tt> elements, which are reduced concurrently.
+            When <tt>simd</tt> is true and <tt>XVIGRA_USE_SIMD</tt> is defined,
+            unit-stride runs of floating-point data are reduced with SIMD instructions.
+        */
+    struct reduction_options
+    {
+        index_t thread_count = std::max<index_t>(1, std::thread::hardware_concurrency());
+        index_t min_elements_per_thread = index_t(1) << 16;
+        bool simd = true;
+
+        reduction_options & threads(index_t n)
+        {
+            vigra_precondition(n > 0,
+                "reduction_options::threads(): thread count must be positive.");
+            thread_count = n;
+            return *this;
+        }
+
+        reduction_options & use_simd(bool v)
+        {
+            simd = v;
+            return *this;
+        }
+    };
+
+    inline reduction_options & default_reduction_options()
+    {
+        static reduction_options options;
+        return options;
+    }
+
+    namespace detail
+    {
+        template <class T>
+        struct reduction_sum_type
+        {
+            using type = std::conditional_t<std::is_floating_point<T>::value,
+                             std::conditional_t<(sizeof(T) > sizeof(double)), T, double>,
+                             std::conditional_t<std::is_signed<T>::value, long long, unsigned long long>>;
+        };
+
+        template <class T>
+        using reduction_sum_type_t = typename reduction_sum_type<T>::type;
+
+            // value types for which unit-stride runs are reduced with xsimd
+        template <class T>
+        using reduction_use_simd = std::integral_constant<bool,
+                                       std::is_same<T, float>::value || std::is_same<T, double>::value>;
+
+        template <class T>
+        inline T reduction_abs(T v, std::true_type)
+        {
+            return v < T() ? -v : v;
+        }
+
+        template <class T>
+        inline T reduction_abs(T v, std::false_type)
+        {
+            return v;
+        }
+
+        template <class T>
+        inline T reduction_abs(T v)
+        {
+            return reduction_abs(v, std::is_signed<T>());
+        }
+
+        /******************/
+        /* reduction_runs */
+        /******************/
+
+            // Decompose a view into strided 1D runs: a single flat run when the view is
+            // contiguous in c-order, otherwise all lines along the axis with the smallest
+            // stride. Runs are reduced in parallel by 'kernel(acc, p, stride, size, run, k0)',
+            // where 'run' is the line index (0 in flat mode) and 'k0' the index of 'p' in
+            // its run. The per-thread accumulators are combined in order by 'combine(acc, other)'.
+        template <class T>
+        class reduction_runs
+        {
+          public:
+            using view_type = view_nd<T const>;
+
+            template <class E>
+            explicit reduction_runs(E const & e)
+            : view_(e)
+            , flat_(is_c_order_contiguous(view_.shape(), view_.strides()))
+            , axis_(0)
+            {
+                if(!flat_)
+                {
+                    for(index_t d=1; d<view_.dimension(); ++d)
+                    {
+                        if(view_.shape(axis_) == 1 ||
+                           (view_.shape(d) > 1 && std::abs(view_.strides(d)) < std::abs(view_.strides(axis_))))
+                        {
+                            axis_ = d;
+                        }
+                    }
+                }
+            }
+
+            index_t size() const
+            {
+                return view_.size();
+            }
+
+            view_type const & view() const
+            {
+                return view_;
+            }
+
+            template <class ACC, class KERNEL, class COMBINE>
+            ACC reduce(ACC const & init, KERNEL const & kernel, COMBINE const & combine,
+                       reduction_options const & options) const
+            {
+                index_t size = view_.size();
+                index_t parts = std::max<index_t>(1,
+                                    std::min(options.thread_count,
+                                             size / std::max<index_t>(1, options.min_elements_per_thread)));
+                std::vector<ACC> results(parts, init);
+
+                auto run_part = [&](index_t part)
+                {
+                    ACC & acc = results[part];
+                    if(flat_)
+                    {
+                        index_t begin = part*size / parts,
+                                end   = (part+1)*size / parts;
+                        kernel(acc, view_.raw_data() + begin, 1, end-begin, 0, begin);
+                    }
+                    else
+                    {
+                        auto lines = make_line_iterator(view_, axis_);
+                        lines.set_range(part*lines.count() / parts, (part+1)*lines.count() / parts);
+                        for(; lines.has_more(); ++lines)
+                        {
+                            kernel(acc, lines.data(), lines.stride(), lines.size(), lines.index(), 0);
+                        }
+                    }
+                };
+
+                if(parts == 1)
+                {
+                    run_part(0);
+                }
+                else
+                {
+                    std::vector<std::thread> threads;
+                    threads.reserve(parts-1);
+                    for(index_t part=1; part<parts; ++part)
+                    {
+                        threads.emplace_back(run_part, part);
+                    }
+                    run_part(0);
+                    for(auto & t: threads)
+                    {
+                        t.join();
+                    }
+                }
+
+                ACC res = results[0];
+                for(index_t part=1; part<parts; ++part)
+                {
+                    combine(res, results[part]);
+                }
+                return res;
+            }
+
+                // coordinates of element 'k' in run 'run'
+            shape_t<> coordinate(index_t run, index_t k) const
+            {
+                index_t n = view_.dimension();
+                shape_t<> res(n, index_t(0));
+                if(flat_)
+                {
+                    for(index_t d=n-1; d>=0; --d)
+                    {
+                        res[d] = k % view_.shape(d);
+                        k     /= view_.shape(d);
+                    }
+                }
+                else
+                {
+                    for(index_t d=n-1; d>=0; --d)
+                    {
+                        if(d == axis_)
+                        {
+                            continue;
+                        }
+                        res[d] = run % view_.shape(d);
+                        run   /= view_.shape(d);
+                    }
+                    res[axis_] = k;
+                }
+                return res;
+            }
+
+                // scan-order index of element 'k' in run 'run' (c-order in flat mode)
+            index_t linear_index(index_t run, index_t k) const
+            {
+                shape_t<> c = coordinate(run, k);
+                index_t res = 0;
+                for(index_t d=0; d<view_.dimension(); ++d)
+                {
+                    res = res*view_.shape(d) + c[d];
+                }
+                return res;
+            }
+
+          private:
+            view_type view_;
+            bool flat_;
+            index_t axis_;
+        };
+
+        template <class E>
+        inline auto make_reduction_runs(E const & e)
+        {
+            static_assert(has_raw_data_api<E>::value,
+                "reduce: argument must provide raw data (use xt::eval() for expressions).");
+            using value_type = std::remove_const_t<typename E::value_type>;
+            static_assert(std::is_arithmetic<value_type>::value,
+                "reduce: value_type must be arithmetic.");
+            return reduction_runs<value_type>(e);
+        }
+
+        /*********************/
+        /* reduction kernels */
+        /*********************/
+
+            // sum of f(p[k]) over a run, 'f' being identity, abs or square
+        enum reduction_element_op { reduction_identity, reduction_absolute, reduction_square };
+
+        template <reduction_element_op OP, class T, class R>
+        inline R reduction_element(T v)
+        {
+            return OP == reduction_identity
+                       ? static_cast<R>(v)
+                       : OP == reduction_absolute
+                           ? static_cast<R>(reduction_abs(v))
+                           : static_cast<R>(v)*static_cast<R>(v);
+        }
+
+        template <reduction_element_op OP, class T, class R>
+        inline void reduction_sum_strided(R & acc, T const * p, index_t stride, index_t size)
+        {
+            R s0 = R(), s1 = R();
+            index_t k = 0;
+            for(; k+1 < size; k += 2, p += 2*stride)
+            {
+                s0 += reduction_element<OP, T, R>(p[0]);
+                s1 += reduction_element<OP, T, R>(p[stride]);
+            }
+            if(k < size)
+            {
+                s0 += reduction_element<OP, T, R>(p[0]);
+            }
+            acc += s0 + s1;
+        }
+
+    #ifdef XVIGRA_USE_SIMD
+        template <reduction_element_op OP, class B>
+        inline B reduction_element_simd(B v)
+        {
+            return OP == reduction_identity
+                       ? v
+                       : OP == reduction_absolute
+                           ? xsimd::abs(v)
+                           : v*v;
+        }
+
+            // blocks are summed in T before they are added to the (wider) accumulator
+        template <reduction_element_op OP, class T, class R>
+        inline void reduction_sum_simd(R & acc, T const * p, index_t size)
+        {
+            using batch = decltype(xsimd::set_simd(T()));
+            constexpr index_t simd_size = xsimd::simd_batch_traits<batch>::size;
+            constexpr index_t block_size = 1024;
+
+            for(index_t block=0; block<size; block += block_size)
+            {
+                index_t block_end = std::min(size, block+block_size),
+                        simd_end  = block + (block_end - block) / simd_size * simd_size;
+                batch s(T(0));
+                for(index_t k=block; k<simd_end; k += simd_size)
+                {
+                    s += reduction_element_simd<OP>(xsimd::load_unaligned(p+k));
+                }
+                R r = static_cast<R>(xsimd::hadd(s));
+                for(index_t k=simd_end; k<block_end; ++k)
+                {
+                    r += reduction_element<OP, T, R>(p[k]);
+                }
+                acc += r;
+            }
+        }
+    #endif
+
+        template <reduction_element_op OP, class T, class R>
+        inline void reduction_sum_run(R & acc, T const * p, index_t stride, index_t size, bool, std::false_type)
+        {
+            reduction_sum_strided<OP>(acc, p, stride, size);
+        }
+
+        template <reduction_element_op OP, class T, class R>
+        inline void reduction_sum_run(R & acc, T const * p, index_t stride, index_t size, bool use_simd, std::true_type)
+        {
+    #ifdef XVIGRA_USE_SIMD
+            if(stride == 1 && use_simd)
+            {
+                reduction_sum_simd<OP>(acc, p, size);
+                return;
+            }
+    #endif
+            std::ignore = use_simd;
+            reduction_sum_strided<OP>(acc, p, stride, size);
+        }
+
+        template <reduction_element_op OP, class T, class R>
+        inline void reduction_sum_run(R & acc, T const * p, index_t stride, index_t size, bool use_simd)
+        {
+            reduction_sum_run<OP>(acc, p, stride, size, use_simd, reduction_use_simd<T>());
+        }
+
+        template <class T>
+        inline void reduction_minmax_strided(std::array<T, 2> & acc, T const * p, index_t stride, index_t size)
+        {
+            for(index_t k=0; k<size; ++k, p += stride)
+            {
+                if(*p < acc[0])
+                {
+                    acc[0] = *p;
+                }
+                if(acc[1] < *p)
+                {
+                    acc[1] = *p;
+                }
+            }
+        }
+
+    #ifdef XVIGRA_USE_SIMD
+        template <class T>
+        inline void reduction_minmax_simd(std::array<T, 2> & acc, T const * p, index_t size)
+        {
+            using batch = decltype(xsimd::set_simd(T()));
+            constexpr index_t simd_size = xsimd::simd_batch_traits<batch>::size;
+
+            index_t simd_end = size - size % simd_size;
+            if(simd_end > 0)
+            {
+                batch lo(acc[0]), hi(acc[1]);
+                for(index_t k=0; k<simd_end; k += simd_size)
+                {
+                    batch v = xsimd::load_unaligned(p+k);
+                    lo = xsimd::min(lo, v);
+                    hi = xsimd::max(hi, v);
+                }
+                alignas(64) T l[simd_size], h[simd_size];
+                lo.store_aligned(l);
+                hi.store_aligned(h);
+                for(index_t k=0; k<simd_size; ++k)
+                {
+                    acc[0] = std::min(acc[0], l[k]);
+                    acc[1] = std::max(acc[1], h[k]);
+                }
+            }
+            reduction_minmax_strided(acc, p+simd_end, 1, size-simd_end);
+        }
+    #endif
+
+        template <class T>
+        inline void reduction_minmax_run(std::array<T, 2> & acc, T const * p, index_t stride, index_t size,
+                                         bool, std::false_type)
+        {
+            reduction_minmax_strided(acc, p, stride, size);
+        }
+
+        template <class T>
+        inline void reduction_minmax_run(std::array<T, 2> & acc, T const * p, index_t stride, index_t size,
+                                         bool use_simd, std::true_type)
+        {
+    #ifdef XVIGRA_USE_SIMD
+            if(stride == 1 && use_simd)
+            {
+                reduction_minmax_simd(acc, p, size);
+                return;
+            }
+    #endif
+            std::ignore = use_simd;
+            reduction_minmax_strided(acc, p, stride, size);
+        }
+
+        template <class T>
+        inline void reduction_minmax_run(std::array<T, 2> & acc, T const * p, index_t stride, index_t size, bool use_simd)
+        {
+            reduction_minmax_run(acc, p, stride, size, use_simd, reduction_use_simd<T>());
+        }
+
+            // best element found so far: value, run and index in run (run < 0: none)
+        template <class T>
+        struct reduction_arg_entry
+        {
+            T value;
+            index_t run, k;
+        };
+
+        template <class T, class COMPARE>
+        shape_t<> reduction_arg(reduction_runs<T> const & runs, COMPARE const & better,
+                                reduction_options const & options)
+        {
+            using entry = reduction_arg_entry<T>;
+
+            // on ties, keep the element that comes first in c-order
+            auto combine = [&runs, &better](entry & acc, entry const & other)
+            {
+                if(other.run < 0)
+                {
+                    return;
+                }
+                if(acc.run < 0 || better(other.value, acc.value) ||
+                   (!better(acc.value, other.value) &&
+                    runs.linear_index(other.run, other.k) < runs.linear_index(acc.run, acc.k)))
+                {
+                    acc = other;
+                }
+            };
+            auto kernel = [&combine, &better](entry & acc, T const * p, index_t stride, index_t size,
+                                              index_t run, index_t k0)
+            {
+                if(size == 0)
+                {
+                    return;
+                }
+                entry local{p[0], run, k0};
+                p += stride;
+                for(index_t k=1; k<size; ++k, p += stride)
+                {
+                    if(better(*p, local.value))
+                    {
+                        local.value = *p;
+                        local.k = k0 + k;
+                    }
+                }
+                combine(acc, local);
+            };
+
+            entry res = runs.reduce(entry{T(), -1, 0}, kernel, combine, options);
+            return runs.coordinate(res.run, res.k);
+        }
+    } // namespace detail
+
+    /**********/
+    /* reduce */
+    /**********/
+
+        /** \brief Fast reductions over arrays with raw data.
+
+            The functions accept view_nd, array_nd, and other xtensor containers
+            and views with raw data, of arbitrary dimension, memory order and strides.
+            Contiguous data are processed as a single range, otherwise the data are
+            traversed line by line along the axis with the smallest stride. Large
+            arrays are split into parts that are reduced concurrently (see
+            \ref reduction_options). Sums are accumulated in <tt>double</tt> resp.
+            64-bit integers.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> volume(...);
+            auto range = reduce::minmax(volume);                // std::array<float, 2>
+            double m = reduce::mean(volume.transpose());
+            shape_t<> p = reduce::argmax(volume);
+            auto h = reduce::histogram(volume, 256, range[0], range[1]);
+            \endcode
+        */
+    namespace reduce
+    {
+            /** \brief Sum of all elements.
+             */
+        template <class E>
+        inline auto sum(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            auto runs = detail::make_reduction_runs(e);
+            using T = std::remove_const_t<typename E::value_type>;
+            using R = detail::reduction_sum_type_t<T>;
+            bool use_simd = options.simd;
+            return runs.reduce(R(),
+                [use_simd](R & acc, T const * p, index_t stride, index_t size, index_t, index_t)
+                {
+                    detail::reduction_sum_run<detail::reduction_identity>(acc, p, stride, size, use_simd);
+                },
+                [](R & acc, R const & other) { acc += other; },
+                options);
+        }
+
+            /** \brief Average of all elements (as <tt>double</tt>).
+             */
+        template <class E>
+        inline double mean(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            vigra_precondition(e.size() > 0,
+                "reduce::mean(): array must not be empty.");
+            return static_cast<double>(reduce::sum(e, options)) / static_cast<double>(e.size());
+        }
+
+            /** \brief Smallest and largest element as <tt>std::array<T, 2></tt>.
+             */
+        template <class E>
+        inline auto minmax(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            auto runs = detail::make_reduction_runs(e);
+            using T = std::remove_const_t<typename E::value_type>;
+            vigra_precondition(runs.size() > 0,
+                "reduce::minmax(): array must not be empty.");
+            bool use_simd = options.simd;
+            T first = *runs.view().raw_data();
+            return runs.reduce(std::array<T, 2>{{first, first}},
+                [use_simd](std::array<T, 2> & acc, T const * p, index_t stride, index_t size, index_t, index_t)
+                {
+                    detail::reduction_minmax_run(acc, p, stride, size, use_simd);
+                },
+                [](std::array<T, 2> & acc, std::array<T, 2> const & other)
+                {
+                    acc[0] = std::min(acc[0], other[0]);
+                    acc[1] = std::max(acc[1], other[1]);
+                },
+                options);
+        }
+
+            /** \brief Coordinates of the smallest element (the first in c-order
+                when there are several).
+             */
+        template <class E>
+        inline shape_t<> argmin(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            auto runs = detail::make_reduction_runs(e);
+            using T = std::remove_const_t<typename E::value_type>;
+            vigra_precondition(runs.size() > 0,
+                "reduce::argmin(): array must not be empty.");
+            return detail::reduction_arg(runs, [](T a, T b) { return a < b; }, options);
+        }
+
+            /** \brief Coordinates of the largest element (the first in c-order
+                when there are several).
+             */
+        template <class E>
+        inline shape_t<> argmax(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            auto runs = detail::make_reduction_runs(e);
+            using T = std::remove_const_t<typename E::value_type>;
+            vigra_precondition(runs.size() > 0,
+                "reduce::argmax(): array must not be empty.");
+            return detail::reduction_arg(runs, [](T a, T b) { return b < a; }, options);
+        }
+
+            /** \brief Sum of absolute values.
+             */
+        template <class E>
+        inline auto norm_l1(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            auto runs = detail::make_reduction_runs(e);
+            using T = std::remove_const_t<typename E::value_type>;
+            using R = detail::reduction_sum_type_t<T>;
+            bool use_simd = options.simd;
+            return runs.reduce(R(),
+                [use_simd](R & acc, T const * p, index_t stride, index_t size, index_t, index_t)
+                {
+                    detail::reduction_sum_run<detail::reduction_absolute>(acc, p, stride, size, use_simd);
+                },
+                [](R & acc, R const & other) { acc += other; },
+                options);
+        }
+
+            /** \brief Sum of squares.
+             */
+        template <class E>
+        inline auto norm_sq(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            auto runs = detail::make_reduction_runs(e);
+            using T = std::remove_const_t<typename E::value_type>;
+            using R = detail::reduction_sum_type_t<T>;
+            bool use_simd = options.simd;
+            return runs.reduce(R(),
+                [use_simd](R & acc, T const * p, index_t stride, index_t size, index_t, index_t)
+                {
+                    detail::reduction_sum_run<detail::reduction_square>(acc, p, stride, size, use_simd);
+                },
+                [](R & acc, R const & other) { acc += other; },
+                options);
+        }
+
+            /** \brief Euclidean norm (as floating-point number).
+             */
+        template <class E>
+        inline auto norm_l2(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            using T = std::remove_const_t<typename E::value_type>;
+            using R = real_promote_type_t<detail::reduction_sum_type_t<T>>;
+            return std::sqrt(static_cast<R>(reduce::norm_sq(e, options)));
+        }
+
+            /** \brief Largest absolute value.
+             */
+        template <class E>
+        inline auto norm_linf(E const & e, reduction_options const & options = default_reduction_options())
+        {
+            using T = std::remove_const_t<typename E::value_type>;
+            using R = detail::reduction_sum_type_t<T>;
+            if(e.size() == 0)
+            {
+                return R();
+            }
+            auto mM = reduce::minmax(e, options);
+            return std::max(detail::reduction_abs(static_cast<R>(mM[0])),
+                            detail::reduction_abs(static_cast<R>(mM[1])));
+        }
+
+            /** \brief Histogram with 'bin_count' equally sized bins over the range
+                [lower, upper].
+
+                Bin <tt>i</tt> counts the values in
+                <tt>[lower + i*w, lower + (i+1)*w)</tt> with <tt>w = (upper - lower) / bin_count</tt>,
+                except for the last bin, which also contains 'upper'. Values outside
+                the range (and NaNs) are not counted.
+             */
+        template <class E>
+        inline std::vector<std::size_t>
+        histogram(E const & e, index_t bin_count, double lower, double upper,
+                  reduction_options const & options = default_reduction_options())
+        {
+            vigra_precondition(bin_count > 0,
+                "reduce::histogram(): bin_count must be positive.");
+            vigra_precondition(lower < upper,
+                "reduce::histogram(): lower must be less than upper.");
+            auto runs = detail::make_reduction_runs(e);
+            using T = std::remove_const_t<typename E::value_type>;
+            using H = std::vector<std::size_t>;
+            double scale = bin_count / (upper - lower);
+            return runs.reduce(H(bin_count, 0),
+                [bin_count, lower, upper, scale](H & acc, T const * p, index_t stride, index_t size, index_t, index_t)
+                {
+                    for(index_t k=0; k<size; ++k, p += stride)
+                    {
+                        double v = static_cast<double>(*p);
+                        if(v >= lower && v <= upper)
+                        {
+                            ++acc[std::min<index_t>(static_cast<index_t>((v - lower)*scale), bin_count-1)];
+                        }
+                    }
+                },
+                [](H & acc, H const & other)
+                {
+                    for(std::size_t k=0; k<acc.size(); ++k)
+                    {
+                        acc[k] += other[k];
+                    }
+                },
+                options);
+        }
+
+            /** \brief Histogram with 'bin_count' equally sized bins over the data range.
+             */
+        template <class E>
+        inline std::vector<std::size_t>
+        histogram(E const & e, index_t bin_count,
+                  reduction_options const & options = default_reduction_options())
+        {
+            vigra_precondition(e.size() > 0,
+                "reduce::histogram(): array must not be empty.");
+            auto mM = reduce::minmax(e, options);
+            double lower = static_cast<double>(mM[0]),
+                   upper = static_cast<double>(mM[1]);
+            if(lower == upper)
+            {
+                upper = lower + 1.0;
+            }
+            return reduce::histogram(e, bin_count, lower, upper, options);
+        }
+    } // namespace reduce
+
+} // namespace xvigra
+
+#endif // XVIGRA_REDUCTION_HPP
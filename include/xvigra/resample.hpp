@@ -0,0 +1,530 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_RESAMPLE_HPP
+#define XVIGRA_RESAMPLE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <vector>
+#include <xtensor/xmath.hpp>
+#include "global.hpp"
+#include "array_nd.hpp"
+#include "slice.hpp"
+#include "line_iterator.hpp"
+#include "functor_base.hpp"
+#include "kernel.hpp"
+#include "kernel_cache.hpp"
+#include "splines.hpp"
+#include "separable_convolution.hpp"
+#include "recursive_filter.hpp"
+#include "spline_view.hpp"
+
+namespace xvigra
+{
+    /********************/
+    /* resample_options */
+    /********************/
+
+    struct resample_options
+    {
+        bool simd = true;
+        bool anti_aliasing = true;
+        bool corners_aligned = true;
+
+        resample_options & use_simd(bool v=true)
+        {
+            simd = v;
+            return *this;
+        }
+
+            // Smooth with a Gaussian before downsampling along an axis.
+        resample_options & anti_alias(bool v=true)
+        {
+            anti_aliasing = v;
+            return *this;
+        }
+
+            // If true, the first and last samples of input and output are located at the
+            // same positions, i.e. output sample j is taken from input coordinate
+            // j*(in_size-1)/(out_size-1). Otherwise, the pixel centers are aligned:
+            // (j+0.5)*in_size/out_size - 0.5.
+        resample_options & align_corners(bool v=true)
+        {
+            corners_aligned = v;
+            return *this;
+        }
+    };
+
+    /*************************/
+    /* make_resample_weights */
+    /*************************/
+
+    namespace detail
+    {
+        inline index_t resample_gcd(index_t a, index_t b)
+        {
+            a = std::abs(a);
+            b = std::abs(b);
+            while(b != 0)
+            {
+                index_t t = a % b;
+                a = b;
+                b = t;
+            }
+            return a;
+        }
+
+        // Weight table for resampling a single axis. Output sample j is located
+        // at the rational input coordinate x_j = (a*j + b) / c. Since the fractional part
+        // of x_j is periodic in j with period c / gcd(a, c), weights are only stored for
+        // one period and shared by all output samples of the same phase.
+        struct resample_weights
+        {
+            index_t ksize = 1, period = 1;
+            std::vector<index_t> first;    // index of the first input sample of each output sample
+            std::vector<double>  weights;  // period x ksize
+
+            double const * operator[](index_t j) const
+            {
+                return &weights[(j % period)*ksize];
+            }
+        };
+
+        template <class KERNEL>
+        inline std::vector<double>
+        resample_prefilter_coefficients(KERNEL const & kernel, decltype(&KERNEL::prefilter_coefficients))
+        {
+            return kernel.prefilter_coefficients();
+        }
+
+        template <class KERNEL>
+        inline std::vector<double>
+        resample_prefilter_coefficients(KERNEL const &, ...)
+        {
+            return std::vector<double>(); // kernel is used without prefiltering (e.g. gaussian)
+        }
+
+        // Compute the weight table for resampling an axis of size 'in_size' to 'out_size'.
+        // When 'sigma' > 0, the kernel is combined with a sampled Gaussian of that
+        // scale (anti-aliasing).
+        template <class KERNEL>
+        resample_weights
+        make_resample_weights(KERNEL const & kernel, index_t in_size, index_t out_size,
+                              bool align_corners, double sigma)
+        {
+            index_t a, b, c;
+            if(align_corners)
+            {
+                a = std::max<index_t>(in_size - 1, 0);
+                b = 0;
+                c = std::max<index_t>(out_size - 1, 1);
+            }
+            else
+            {
+                a = 2*in_size;
+                b = in_size - out_size;
+                c = 2*out_size;
+            }
+            index_t g = resample_gcd(resample_gcd(a, b), c);
+            a /= g;
+            b /= g;
+            c /= g;
+
+            std::shared_ptr<kernel_1d<double> const> smoothing =
+                sigma > 0.0
+                    ? cached_gaussian_kernel_1d<double>(sigma)
+                    : std::make_shared<kernel_1d<double>>(averaging_kernel_1d<double>(0));
+            index_t sradius = smoothing->center();
+
+            double radius = kernel.radius();
+            index_t kernel_size = (index_t)std::ceil(2.0*radius) + 1;
+
+            resample_weights res;
+            res.ksize  = kernel_size + 2*sradius;
+            res.period = std::min(c / resample_gcd(a, c), std::max<index_t>(out_size, 1));
+            res.first.resize(out_size);
+            res.weights.assign(res.period*res.ksize, 0.0);
+
+            for(index_t j=0; j<out_size; ++j)
+            {
+                // split x_j into integer part i and fractional part u (exactly)
+                index_t num = a*j + b,
+                        i   = num >= 0
+                                  ? num / c
+                                  : -((c - 1 - num) / c);
+                double  u   = (double)(num - i*c) / c;
+                index_t k0  = (index_t)std::floor(u - radius);
+
+                res.first[j] = i + k0 - sradius;
+                if(j < res.period)
+                {
+                    double * w = &res.weights[j*res.ksize];
+                    for(index_t k=0; k<kernel_size; ++k)
+                    {
+                        double kw = kernel(u - (double)(k0 + k));
+                        if(kw == 0.0)
+                        {
+                            continue;
+                        }
+                        // the smoothing kernel is symmetric
+                        for(index_t s=0; s<smoothing->size(); ++s)
+                        {
+                            w[k+s] += kw * (*smoothing)(s);
+                        }
+                    }
+                }
+            }
+            return res;
+        }
+
+        // Resample a 1D line.
+        template <class T>
+        void resample_line(view_nd<T, 1> const & in, view_nd<T, 1> out, resample_weights const & weights)
+        {
+            index_t n = in.shape(0),
+                    ksize = weights.ksize,
+                    in_stride = in.strides(0),
+                    out_stride = out.strides(0);
+            T const * src = in.raw_data();
+            T * dest = out.raw_data();
+            for(index_t j=0; j<out.shape(0); ++j, dest += out_stride)
+            {
+                index_t first = weights.first[j];
+                double const * w = weights[j];
+                double sum = 0.0;
+                if(first >= 0 && first + ksize <= n)
+                {
+                    T const * s = src + first*in_stride;
+                    for(index_t k=0; k<ksize; ++k, s += in_stride)
+                    {
+                        sum += w[k] * *s;
+                    }
+                }
+                else
+                {
+                    for(index_t k=0; k<ksize; ++k)
+                    {
+                        sum += w[k] * src[spline_reflect_index(first + k, n)*in_stride];
+                    }
+                }
+                *dest = static_cast<T>(sum);
+            }
+        }
+
+        // Resample along axis 0 of 'in', working along rows in the inner loop
+        // (as in convolve_columns()).
+        template <class T>
+        void resample_columns(view_nd<T, 2> const & in, view_nd<T, 2> out,
+                              resample_weights const & weights, bool use_simd)
+        {
+#ifdef XVIGRA_USE_SIMD
+            use_simd = use_simd && in.bind(0,0).is_contiguous() && out.bind(0,0).is_contiguous();
+#else
+            use_simd = false;
+#endif
+            index_t n = in.shape(0),
+                    m = in.shape(1);
+            for(index_t j=0; j<out.shape(0); ++j)
+            {
+                index_t first = weights.first[j];
+                double const * w = weights[j];
+                bool initialized = false;
+                for(index_t k=0; k<weights.ksize; ++k)
+                {
+                    if(w[k] == 0.0)
+                    {
+                        continue;
+                    }
+                    index_t i = spline_reflect_index(first + k, n);
+                    T a = static_cast<T>(w[k]);
+                    if(use_simd)
+                    {
+                        if(initialized)
+                        {
+                            simd_fma_row(&in(i,0), m, &out(j,0), a);
+                        }
+                        else
+                        {
+                            simd_mul_row(&in(i,0), m, &out(j,0), a);
+                        }
+                    }
+                    else if(initialized)
+                    {
+                        for(index_t l=0; l<m; ++l)
+                        {
+                            out(j,l) += a*in(i,l);
+                        }
+                    }
+                    else
+                    {
+                        for(index_t l=0; l<m; ++l)
+                        {
+                            out(j,l) = a*in(i,l);
+                        }
+                    }
+                    initialized = true;
+                }
+                if(!initialized)
+                {
+                    for(index_t l=0; l<m; ++l)
+                    {
+                        out(j,l) = T();
+                    }
+                }
+            }
+        }
+    } // namespace detail
+
+    /********************/
+    /* resample_functor */
+    /********************/
+
+        /** \brief Separable resampling with an arbitrary interpolation kernel.
+
+            The input is resampled to the shape of the output. The kernel must provide
+            <tt>operator()(double)</tt> and <tt>radius()</tt>, e.g. <tt>b_spline<ORDER></tt>,
+            <tt>catmull_rom_spline</tt>, or <tt>gaussian</tt>. If the kernel provides
+            <tt>prefilter_coefficients()</tt>, the data are prefiltered accordingly
+            along each resampled axis, such that B-splines of any order interpolate.
+
+            The mapping between output and input coordinates is rational
+            (see <tt>resample_options::align_corners()</tt>), so that the fractional
+            sample positions repeat periodically. The kernel weights are therefore
+            computed once per axis and phase. Axes whose size doesn't change are skipped,
+            and the remaining axes are processed in order of increasing scale factor,
+            so that downsampling reduces the data before upsampling enlarges them.
+            All axes except the innermost one are processed row by row, using SIMD
+            when <tt>XVIGRA_USE_SIMD</tt> is defined.
+
+            When downsampling by factor <tt>f > 1</tt> along an axis and
+            <tt>options.anti_aliasing</tt> is true (default), the kernel is combined
+            with a Gaussian of scale <tt>sqrt(f*f - 1) / 2</tt> to avoid aliasing.
+
+            Integral output types are computed via a real-valued temporary and
+            rounded, clipping to the range of the output type.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 2> image(...), small(shape_t<2>{100, 150}), large(shape_t<2>{1000, 1500});
+            resample(image, small, b_spline<3, double>());
+            resample(image, large, catmull_rom_spline<double>(), resample_options().align_corners(false));
+            \endcode
+        */
+    struct resample_functor
+    : public functor_base<resample_functor>
+    {
+        std::string name = "resample";
+
+        template <class T1, index_t N1, class T2, index_t N2, class KERNEL>
+        void impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                  KERNEL const & kernel,
+                  resample_options const & options = resample_options()) const
+        {
+            using tmp_type = real_promote_type_t<T2>;
+
+            index_t N = in.dimension();
+            vigra_precondition(N == out.dimension(),
+                name + "(): input and output must have the same dimension.");
+            vigra_precondition(all_greater(in.shape(), 0) && all_greater(out.shape(), 0),
+                name + "(): input and output must not be empty.");
+
+            // axes to be resampled, in order of increasing scale factor
+            std::vector<index_t> axes;
+            for(index_t d=0; d<N; ++d)
+            {
+                if(in.shape(d) != out.shape(d))
+                {
+                    axes.push_back(d);
+                }
+            }
+            std::stable_sort(axes.begin(), axes.end(),
+                [&](index_t l, index_t r)
+                {
+                    return out.shape(l)*in.shape(r) < out.shape(r)*in.shape(l);
+                });
+
+            std::vector<double> poles = detail::resample_prefilter_coefficients(kernel, 0);
+
+            std::vector<tmp_type, XVIGRA_TEMPORARY_ALLOCATOR(tmp_type)> buffers[2];
+            buffers[0].resize(in.size());
+            view_nd<tmp_type> current(shape_t<>(in.shape()), buffers[0].data());
+            current = in;
+
+            for(std::size_t k=0; k<axes.size(); ++k)
+            {
+                index_t d = axes[k];
+                double factor = (double)in.shape(d) / out.shape(d);
+                double sigma  = options.anti_aliasing && factor > 1.0
+                                    ? 0.5*std::sqrt(factor*factor - 1.0)
+                                    : 0.0;
+                detail::resample_weights weights =
+                    detail::make_resample_weights(kernel, in.shape(d), out.shape(d),
+                                                  options.corners_aligned, sigma);
+
+                shape_t<> new_shape(current.shape());
+                new_shape[d] = out.shape(d);
+                auto & buffer = buffers[(k+1) % 2];
+                buffer.resize(prod(new_shape));
+                view_nd<tmp_type> next(new_shape, buffer.data());
+
+                // use static dimension for 2D and 3D data
+                dispatch_static_dimension(current, next, [&](auto & scurrent, auto & snext)
+                {
+                    resample_axis(scurrent, snext, d, poles, weights, options.simd);
+                });
+                current.swap(next);
+            }
+
+            if(std::is_integral<T2>::value)
+            {
+                out = round(xt::clip(current, (tmp_type)std::numeric_limits<T2>::lowest(),
+                                              (tmp_type)std::numeric_limits<T2>::max()));
+            }
+            else
+            {
+                out = current;
+            }
+        }
+
+        template <class T, index_t N>
+        void resample_axis(view_nd<T, N> current, view_nd<T, N> next, index_t d,
+                           std::vector<double> const & poles,
+                           detail::resample_weights const & weights, bool use_simd) const
+        {
+            index_t ndim = current.dimension();
+            if(d == ndim-1)
+            {
+                auto current_line = make_line_iterator(current, d);
+                auto next_line    = make_line_iterator(next, d);
+                for(; current_line.has_more(); ++current_line, ++next_line)
+                {
+                    if(poles.size() > 0)
+                    {
+                        recursive_filter.recursive_filter_axis((*current_line).newaxis(1).template view<2>(),
+                                                               poles, reflect_padding, use_simd);
+                    }
+                    detail::resample_line(*current_line, *next_line, weights);
+                }
+            }
+            else
+            {
+                // operate on further dimensions, working along rows in the inner loop
+                shape_t<2> plane_axes{d, ndim-1};
+                auto current_plane = make_subarray_iterator(current, plane_axes);
+                auto next_plane    = make_subarray_iterator(next, plane_axes);
+                for(; current_plane.has_more(); ++current_plane, ++next_plane)
+                {
+                    if(poles.size() > 0)
+                    {
+                        recursive_filter.recursive_filter_axis(*current_plane, poles, reflect_padding, use_simd);
+                    }
+                    detail::resample_columns(*current_plane, *next_plane, weights, use_simd);
+                }
+            }
+        }
+    };
+
+    namespace
+    {
+        resample_functor  resample;
+
+        inline void resample_dummy()
+        {
+            std::ignore = resample;
+        }
+    }
+
+    /******************/
+    /* resize_functor */
+    /******************/
+
+        /** \brief Resize an array using B-spline interpolation of the given order (0...5).
+
+            Shorthand for <tt>resample(in, out, b_spline<ORDER, double>(), options)</tt>.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> volume(...), isotropic(shape_t<3>{200, 200, 200});
+            resize(volume, isotropic);     // cubic interpolation
+            resize(volume, isotropic, 1);  // linear interpolation
+            \endcode
+        */
+    struct resize_functor
+    : public functor_base<resize_functor>
+    {
+        std::string name = "resize";
+
+        template <class T1, index_t N1, class T2, index_t N2>
+        void impl(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                  int spline_order = 3,
+                  resample_options const & options = resample_options()) const
+        {
+            switch(spline_order)
+            {
+                case 0:
+                    resample.impl(in, std::move(out), b_spline<0, double>(), options);
+                    break;
+                case 1:
+                    resample.impl(in, std::move(out), b_spline<1, double>(), options);
+                    break;
+                case 2:
+                    resample.impl(in, std::move(out), b_spline<2, double>(), options);
+                    break;
+                case 3:
+                    resample.impl(in, std::move(out), b_spline<3, double>(), options);
+                    break;
+                case 4:
+                    resample.impl(in, std::move(out), b_spline<4, double>(), options);
+                    break;
+                case 5:
+                    resample.impl(in, std::move(out), b_spline<5, double>(), options);
+                    break;
+                default:
+                    vigra_fail(name + "(): spline_order must be in [0...5].");
+            }
+        }
+    };
+
+    namespace
+    {
+        resize_functor  resize;
+
+        inline void resize_dummy()
+        {
+            std::ignore = resize;
+        }
+    }
+} // namespace xvigra
+
+#endif // XVIGRA_RESAMPLE_HPP
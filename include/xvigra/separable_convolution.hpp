@@ -31,7 +31,15 @@
 #ifndef XVIGRA_SEPARABLE_CONVOLUTION_HPP
 #define XVIGRA_SEPARABLE_CONVOLUTION_HPP
 
+#include <chrono>
+#include <cmath>
+#include <complex>
 #include <deque>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #ifdef XVIGRA_USE_SIMD
 #  include <xsimd/xsimd.hpp>
@@ -39,12 +47,128 @@
 
 #include "padding.hpp"
 #include "slice.hpp"
+#include "line_iterator.hpp"
 #include "array_nd.hpp"
 #include "functor_base.hpp"
 #include "kernel.hpp"
 
 namespace xvigra
 {
+    /*************************/
+    /* convolution_algorithm */
+    /*************************/
+
+    enum convolution_algorithm
+    {
+        automatic_convolution,  // choose per axis according to the cost model
+        direct_convolution,     // one multiply-add per tap
+        symmetric_convolution,  // fold (anti-)symmetric kernels, one multiply per pair of taps
+        fft_convolution         // multiplication in the Fourier domain
+    };
+
+    inline std::string to_string(convolution_algorithm algorithm)
+    {
+        switch(algorithm)
+        {
+            case automatic_convolution:
+                return "automatic";
+            case direct_convolution:
+                return "direct";
+            case symmetric_convolution:
+                return "symmetric";
+            case fft_convolution:
+                return "fft";
+        }
+        return "unknown";
+    }
+
+    namespace detail
+    {
+        inline index_t next_power_of_two(index_t n)
+        {
+            index_t res = 1;
+            while(res < n)
+            {
+                res *= 2;
+            }
+            return res;
+        }
+    } // namespace detail
+
+        /** \brief Cost model for the choice of the convolution algorithm per axis.
+
+            Costs are estimated in nanoseconds per output sample. The defaults were
+            measured for <tt>float</tt> data with SIMD enabled; use
+            <tt>calibrate_convolution_cost_model()</tt> to measure them on the
+            target machine.
+        */
+    struct convolution_cost_model
+    {
+        double direct_per_tap = 0.25;     // per kernel tap
+        double symmetric_per_tap = 0.45;  // per pair of folded taps
+        double fft_per_stage = 1.0;       // per sample of the transform and butterfly stage
+
+        double cost(convolution_algorithm algorithm, index_t kernel_size, index_t line_length) const
+        {
+            switch(algorithm)
+            {
+                case symmetric_convolution:
+                {
+                    return symmetric_per_tap * (kernel_size / 2 + 1);
+                }
+                case fft_convolution:
+                {
+                    index_t fft_size = detail::next_power_of_two(line_length + kernel_size - 1);
+                    return fft_per_stage * std::log2((double)fft_size) * fft_size / std::max<index_t>(line_length, 1);
+                }
+                default:
+                {
+                    return direct_per_tap * kernel_size;
+                }
+            }
+        }
+
+            /** The cheapest algorithm. Symmetric convolution is only considered for
+                (anti-)symmetric kernels.
+            */
+        convolution_algorithm select(index_t kernel_size, index_t line_length, bool symmetric) const
+        {
+            convolution_algorithm res = direct_convolution;
+            double best = cost(direct_convolution, kernel_size, line_length);
+            if(symmetric && cost(symmetric_convolution, kernel_size, line_length) < best)
+            {
+                res = symmetric_convolution;
+                best = cost(symmetric_convolution, kernel_size, line_length);
+            }
+            if(cost(fft_convolution, kernel_size, line_length) < best)
+            {
+                res = fft_convolution;
+            }
+            return res;
+        }
+    };
+
+        /** \brief The algorithm chosen by <tt>separable_convolution</tt> for one axis,
+            as reported by <tt>separable_convolution.plan()</tt>.
+        */
+    struct convolution_axis_plan
+    {
+        index_t axis = 0;
+        index_t kernel_size = 0;
+        index_t line_length = 0;
+        convolution_algorithm algorithm = direct_convolution;
+        double cost = 0.0;  // estimated nanoseconds per sample
+    };
+
+    inline std::string to_string(convolution_axis_plan const & plan)
+    {
+        std::ostringstream s;
+        s << "axis " << plan.axis << ": " << to_string(plan.algorithm)
+          << " (" << plan.kernel_size << " taps, " << plan.line_length << " samples per line, "
+          << plan.cost << " ns per sample)";
+        return s.str();
+    }
+
     /***********************/
     /* convolution_options */
     /***********************/
@@ -53,8 +177,12 @@ namespace xvigra
     {
         using padding_vec = tiny_vector<padding_mode>;
 
+        using algorithm_vec = tiny_vector<convolution_algorithm>;
+
         bool simd = true;
         padding_vec left_padding{reflect_padding}, right_padding{reflect_padding};
+        algorithm_vec algorithm{automatic_convolution};
+        convolution_cost_model cost_model;
 
         convolution_options & use_simd(bool v=true)
         {
@@ -62,6 +190,27 @@ namespace xvigra
             return *this;
         }
 
+            // force the algorithm for all axes, or choose it automatically (default)
+        convolution_options & use_algorithm(convolution_algorithm a)
+        {
+            algorithm = a;
+            return *this;
+        }
+
+            // force the algorithm per axis
+        template <index_t N>
+        convolution_options & use_algorithm(tiny_vector<convolution_algorithm, N> const & a)
+        {
+            algorithm = a;
+            return *this;
+        }
+
+        convolution_options & use_cost_model(convolution_cost_model const & model)
+        {
+            cost_model = model;
+            return *this;
+        }
+
         convolution_options & padding(padding_mode p)
         {
             return padding(p, p);
@@ -112,6 +261,21 @@ namespace xvigra
                 "convolution_options.get_right_padding(d): requested dimension out of bounds.");
             return right_padding[d];
         }
+
+        convolution_algorithm get_algorithm(index_t d) const
+        {
+            if(algorithm.size() == 0)
+            {
+                return automatic_convolution;
+            }
+            if(algorithm.size() == 1)
+            {
+                return algorithm[0];
+            }
+            vigra_precondition(0 <= d && d < algorithm.size(),
+                "convolution_options.get_algorithm(d): requested dimension out of bounds.");
+            return algorithm[d];
+        }
     };
 
     /******************************/
@@ -152,31 +316,30 @@ namespace xvigra
 
         index_t N = in.dimension();
 
-        slicer nav(in.shape());
         {
             // operate on last dimension first
-            nav.set_free_axes(N-1);
             padding_mode left_padding  = options.get_left_padding(N-1),
                          right_padding = options.get_right_padding(N-1);
-            array_nd<T2, 1> padded(shape_t<1>{in.shape(N-1)+left+right});
-            for(; nav.has_more(); ++nav)
+            temporary_array_nd<T2, 1> padded(shape_t<1>{in.shape(N-1)+left+right});
+            auto in_line  = make_line_iterator(in, N-1);
+            auto out_line = make_line_iterator(out, N-1);
+            for(; in_line.has_more(); ++in_line, ++out_line)
             {
-                copy_with_padding(in.view(*nav), padded, left_padding, left, right_padding, right);
-                detail::convolve_row(padded, out.view(*nav), rev_kernel);
+                copy_with_padding(*in_line, padded, left_padding, left, right_padding, right);
+                detail::convolve_row(padded, *out_line, rev_kernel);
             }
         }
 
         for( index_t d = N-2; d >= 0; --d )
         {
             // operate on further dimensions
-            nav.set_free_axes(d);
             padding_mode left_padding  = options.get_left_padding(d),
                          right_padding = options.get_right_padding(d);
-            array_nd<T2, 1> padded(shape_t<1>{out.shape(d)+left+right});
-            for(; nav.has_more(); ++nav)
+            temporary_array_nd<T2, 1> padded(shape_t<1>{out.shape(d)+left+right});
+            for(auto line = make_line_iterator(out, d); line.has_more(); ++line)
             {
-                copy_with_padding(out.view(*nav), padded, left_padding, left, right_padding, right);
-                detail::convolve_row(padded, out.view(*nav), rev_kernel);
+                copy_with_padding(*line, padded, left_padding, left, right_padding, right);
+                detail::convolve_row(padded, *line, rev_kernel);
             }
         }
     }
@@ -246,6 +409,28 @@ namespace xvigra
                 *(dest+j) += *(src+j) * a;
             }
         }
+
+        // dest += a * (src1 + sign * src2), for folding (anti-)symmetric kernels
+        template <class T,
+                  VIGRA_REQUIRE<std::is_floating_point<T>::value>>
+        inline void simd_fma_row_symmetric(T const * src1, T const * src2, index_t size, T * dest, T a, T sign)
+        {
+            auto ba = xsimd::set_simd(a),
+                 bs = xsimd::set_simd(sign);
+
+            constexpr index_t simd_size = xsimd::simd_batch_traits<decltype(ba)>::size;
+
+            index_t simd_end = size - size % simd_size;
+            for(index_t j=0; j<simd_end; j += simd_size)
+            {
+                auto folded = xsimd::fma(bs, xsimd::load_unaligned(src2+j), xsimd::load_unaligned(src1+j));
+                xsimd::fma(ba, folded, xsimd::load_unaligned(dest+j)).store_unaligned(dest+j);
+            }
+            for(index_t j=simd_end; j<size; ++j)
+            {
+                *(dest+j) += (*(src1+j) + sign * *(src2+j)) * a;
+            }
+        }
     #else
         template <class T1, class T2, class T3>
         inline void simd_mul_row(T1 const * src, index_t size, T2 * dest, T3 a)
@@ -258,23 +443,332 @@ namespace xvigra
         {
             vigra_fail("internal error: invalid call to SIMD function.");
         }
+
+        template <class T1, class T2, class T3>
+        inline void simd_fma_row_symmetric(T1 const * src1, T1 const * src2, index_t size, T2 * dest, T3 a, T3 sign)
+        {
+            vigra_fail("internal error: invalid call to SIMD function.");
+        }
     #endif
 
+        // +1 for symmetric kernels, -1 for antisymmetric ones, 0 otherwise
+        template <class T>
+        inline int kernel_symmetry(kernel_1d<T> const & kernel)
+        {
+            index_t size = kernel.size(), center = kernel.center();
+            if(size < 3 || 2*center + 1 != size)
+            {
+                return 0;
+            }
+            double tolerance = 0.0;
+            for(index_t k=0; k<size; ++k)
+            {
+                tolerance = std::max(tolerance, 1e-6 * std::abs((double)kernel(k)));
+            }
+            bool symmetric = true, antisymmetric = std::abs((double)kernel(center)) <= tolerance;
+            for(index_t k=1; k<=center; ++k)
+            {
+                double l = kernel(center-k), r = kernel(center+k);
+                symmetric = symmetric && std::abs(l - r) <= tolerance;
+                antisymmetric = antisymmetric && std::abs(l + r) <= tolerance;
+            }
+            return symmetric ? 1 : antisymmetric ? -1 : 0;
+        }
+
+        // in-place radix-2 FFT of size 2^k
+        class fft_radix2
+        {
+          public:
+            explicit fft_radix2(index_t size)
+            : size_(size)
+            , twiddles_(size / 2)
+            , bit_reversed_(size, 0)
+            {
+                for(index_t k=0; k<size/2; ++k)
+                {
+                    twiddles_[k] = std::polar(1.0, -2.0 * M_PI * k / size);
+                }
+                for(index_t i=1, j=0; i<size; ++i)
+                {
+                    index_t bit = size >> 1;
+                    for(; j & bit; bit >>= 1)
+                    {
+                        j ^= bit;
+                    }
+                    j ^= bit;
+                    bit_reversed_[i] = j;
+                }
+            }
+
+            index_t size() const
+            {
+                return size_;
+            }
+
+                // the inverse transform is not normalized
+            void transform(std::complex<double> * data, bool inverse) const
+            {
+                for(index_t i=0; i<size_; ++i)
+                {
+                    if(i < bit_reversed_[i])
+                    {
+                        std::swap(data[i], data[bit_reversed_[i]]);
+                    }
+                }
+                for(index_t length=2; length<=size_; length *= 2)
+                {
+                    index_t half = length / 2, step = size_ / length;
+                    for(index_t i=0; i<size_; i += length)
+                    {
+                        for(index_t k=0; k<half; ++k)
+                        {
+                            std::complex<double> w = inverse ? std::conj(twiddles_[k*step]) : twiddles_[k*step],
+                                                 u = data[i+k],
+                                                 v = data[i+k+half] * w;
+                            data[i+k]      = u + v;
+                            data[i+k+half] = u - v;
+                        }
+                    }
+                }
+            }
+
+          private:
+            index_t size_;
+            std::vector<std::complex<double>> twiddles_;
+            std::vector<index_t> bit_reversed_;
+        };
+
+        template <class E>
+        class expression_line_reader;
+
+        // Copy the next line of 'in' into the middle of the contiguous 1D array 'padded'
+        // and fill the borders according to the padding modes.
+        template <class T1, index_t N1, class Array>
+        inline void load_padded_line(view_nd<T1, N1> const & in, Array & padded,
+                                     padding_mode left_padding, index_t left_pad,
+                                     padding_mode right_padding, index_t right_pad)
+        {
+            copy_with_padding(in.template view<1>(), padded, left_padding, left_pad, right_padding, right_pad);
+        }
+
+        // An expression is evaluated directly into 'padded', without a line buffer.
+        template <class E, class Array>
+        inline void load_padded_line(expression_line_reader<E> const & in, Array & padded,
+                                     padding_mode left_padding, index_t left_pad,
+                                     padding_mode right_padding, index_t right_pad)
+        {
+            vigra_precondition(left_pad + in.shape(0) + right_pad == (index_t)padded.size(),
+                "load_padded_line(): output size must equal input size plus padding sizes.");
+            in.read_line(padded.raw_data() + left_pad);
+            apply_padding(padded, left_padding, left_pad, right_padding, right_pad);
+        }
+
+        // Convolution of lines of fixed length via FFT. Two real lines are
+        // transformed at once as real and imaginary part of a complex line.
+        // The padded line is never longer than the transform, so that the
+        // circular convolution doesn't wrap around.
+        class fft_line_convolver
+        {
+          public:
+            template <class T>
+            fft_line_convolver(kernel_1d<T> const & kernel, index_t line_length,
+                               padding_mode left_padding, padding_mode right_padding)
+            : left_padding_(left_padding)
+            , right_padding_(right_padding)
+            , right_(kernel.center())
+            , left_(kernel.size() - kernel.center() - 1)
+            , left_pad_(left_padding == no_padding ? 0 : left_)
+            , right_pad_(right_padding == no_padding ? 0 : right_)
+            , start_(left_padding == no_padding ? left_ : 0)
+            , end_(right_padding == no_padding ? line_length - right_ : line_length)
+            , fft_(next_power_of_two(line_length + left_pad_ + right_pad_))
+            , spectrum_(fft_.size())
+            , work_(fft_.size())
+            , padded_(shape_t<1>{line_length + left_pad_ + right_pad_})
+            {
+                // out(i) = sum_k kernel(center - k) * in(i + k) is a circular convolution
+                // with h((-k) mod size) = kernel(center - k)
+                index_t size = fft_.size();
+                for(index_t k=-left_; k<=right_; ++k)
+                {
+                    spectrum_[((-k) % size + size) % size] += (double)kernel(right_ - k);
+                }
+                fft_.transform(spectrum_.data(), false);
+                for(auto & v: spectrum_)
+                {
+                    v /= (double)size;
+                }
+            }
+
+                // 'in' is either a view_nd or a detail::expression_line_reader
+            template <class IN, class T2, index_t N2>
+            void operator()(IN const & in, view_nd<T2, N2> out)
+            {
+                load(in, 0);
+                std::fill(work_.begin() + padded_.size(), work_.end(), std::complex<double>());
+                convolve();
+                for(index_t i=start_; i<end_; ++i)
+                {
+                    out(i) = static_cast<T2>(work_[i+left_pad_].real());
+                }
+            }
+
+            template <class T1, index_t N1, class T2, index_t N2>
+            void operator()(view_nd<T1, N1> const & in1, view_nd<T1, N1> const & in2,
+                            view_nd<T2, N2> out1, view_nd<T2, N2> out2)
+            {
+                load(in1, 0);
+                load(in2, 1);
+                std::fill(work_.begin() + padded_.size(), work_.end(), std::complex<double>());
+                convolve();
+                for(index_t i=start_; i<end_; ++i)
+                {
+                    out1(i) = static_cast<T2>(work_[i+left_pad_].real());
+                    out2(i) = static_cast<T2>(work_[i+left_pad_].imag());
+                }
+            }
+
+          private:
+            template <class IN>
+            void load(IN const & in, int part)
+            {
+                load_padded_line(in, padded_, left_padding_, left_pad_, right_padding_, right_pad_);
+                for(index_t j=0; j<(index_t)padded_.size(); ++j)
+                {
+                    if(part == 0)
+                    {
+                        work_[j] = std::complex<double>(padded_(j), 0.0);
+                    }
+                    else
+                    {
+                        work_[j].imag(padded_(j));
+                    }
+                }
+            }
+
+            void convolve()
+            {
+                fft_.transform(work_.data(), false);
+                for(index_t k=0; k<fft_.size(); ++k)
+                {
+                    work_[k] *= spectrum_[k];
+                }
+                fft_.transform(work_.data(), true);
+            }
+
+            padding_mode left_padding_, right_padding_;
+            index_t right_, left_, left_pad_, right_pad_, start_, end_;
+            fft_radix2 fft_;
+            std::vector<std::complex<double>> spectrum_, work_;
+            array_nd<double, 1> padded_;
+        };
+
+        // Mimics the part of the view_nd API used by separable_convolution_functor::convolve_axes()
+        // for an xexpression without raw data. The expression is evaluated on the fly, one
+        // innermost line at a time, into a line buffer. Lines must be requested in row-major
+        // order, which is the order in which convolve_axes() visits them.
+        template <class E>
+        class expression_line_reader
+        {
+          public:
+            static constexpr index_t ndim = runtime_size;
+
+            using value_type = typename E::value_type;
+            using iterator = decltype(std::declval<E const &>().cbegin());
+
+            explicit expression_line_reader(E const & e)
+            : shape_(e.shape())
+            , state_(std::make_shared<state>(e.cbegin(), shape_.size() > 0 ? shape_.back() : 1))
+            {}
+
+            index_t dimension() const
+            {
+                return shape_.size();
+            }
+
+            shape_t<> const & shape() const
+            {
+                return shape_;
+            }
+
+            index_t shape(index_t d) const
+            {
+                return shape_[d];
+            }
+
+                // only binding of the first axis is supported
+            expression_line_reader bind(index_t axis, index_t) const
+            {
+                vigra_precondition(axis == 0,
+                    "expression_line_reader::bind(): axis must be 0.");
+                return expression_line_reader(shape_.erase(0), state_);
+            }
+
+                // evaluate the next line into 'dest'
+            template <class T>
+            void read_line(T * dest) const
+            {
+                vigra_precondition(shape_.size() == 1,
+                    "expression_line_reader::read_line(): only lines can be read.");
+                for(index_t k=0; k<shape_[0]; ++k, ++state_->iter)
+                {
+                    dest[k] = *state_->iter;
+                }
+            }
+
+                // read the next line into the line buffer
+            template <index_t M>
+            view_nd<value_type, 1> view() const
+            {
+                read_line(state_->line.raw_data());
+                return state_->line;
+            }
+
+          private:
+            struct state
+            {
+                state(iterator i, index_t line_length)
+                : iter(i)
+                , line(shape_t<1>{line_length})
+                {}
+
+                iterator iter;
+                array_nd<value_type, 1> line;
+            };
+
+            expression_line_reader(shape_t<> const & shape, std::shared_ptr<state> const & s)
+            : shape_(shape)
+            , state_(s)
+            {}
+
+            shape_t<> shape_;
+            std::shared_ptr<state> state_;
+        };
+
+        // the per-axis algorithms and FFT convolvers of a separable convolution
+        struct separable_convolution_plan
+        {
+            std::vector<convolution_axis_plan> axes;
+            std::vector<int> symmetry;
+            std::vector<std::unique_ptr<fft_line_convolver>> fft;
+        };
     } // namespace detail
 
         // introduction of convolve_columns gives a 5x speed-up
         // SIMD gives another 3x
-        // taking advantage of the kernel symmetry has negligible effect
+        // taking advantage of the kernel symmetry only pays off for medium-sized
+        // kernels, and FFT for long ones (see convolution_cost_model)
     struct separable_convolution_functor
     {
         std::string name = "separable_convolution";
 
+            // Inputs without raw data (e.g. 'a*b + c') are not evaluated into a temporary,
+            // but streamed line by line into the convolution of the innermost axis.
         template <class E1, class E2, class ... ARGS>
         void operator()(E1 && e1, E2 && e2, ARGS ... a) const
         {
-            auto && a1 = eval_expr(std::forward<E1>(e1));
             auto && a2 = eval_expr(std::forward<E2>(e2));
-            impl(0, make_view(a1), make_view(a2), std::forward<ARGS>(a)...);
+            apply(has_raw_data_api<E1>(), std::forward<E1>(e1), make_view(a2), std::forward<ARGS>(a)...);
         }
 
         template <class E1, class E2, class ... ARGS>
@@ -305,6 +799,46 @@ namespace xvigra
             }
         }
 
+        template <class E1, class T2, index_t N2, class ... ARGS>
+        void apply(std::true_type, E1 && e1, view_nd<T2, N2> out, ARGS ... a) const
+        {
+            auto && a1 = eval_expr(std::forward<E1>(e1));
+            impl(0, make_view(a1), std::move(out), std::forward<ARGS>(a)...);
+        }
+
+        template <class E1, class T2, index_t N2, class ... ARGS>
+        void apply(std::false_type, E1 && e1, view_nd<T2, N2> out, ARGS ... a) const
+        {
+            impl_expression(e1, std::move(out), std::forward<ARGS>(a)...);
+        }
+
+        template <class E, class T2, index_t N2, class T3>
+        void impl_expression(E const & e, view_nd<T2, N2> out,
+                             kernel_1d<T3> const & kernel,
+                             convolution_options const & options = convolution_options()) const
+        {
+            impl_expression(e, std::move(out),
+                            std::vector<kernel_1d<T3>>(e.dimension(), kernel), options);
+        }
+
+        template <class E, class T2, index_t N2, class Kernels,
+                  VIGRA_REQUIRE<kernel_1d_concept<typename std::decay_t<Kernels>::value_type>::value>>
+        void impl_expression(E const & e, view_nd<T2, N2> out,
+                             Kernels && kernels,
+                             convolution_options const & options = convolution_options()) const
+        {
+            detail::expression_line_reader<E> in(e);
+            vigra_precondition(in.shape() == shape_t<>(out.shape()),
+                name + "(): shape mismatch between input and output.");
+            vigra_precondition((index_t)kernels.size() == in.dimension(),
+                name + "(): number of kernels doesn't match data dimension.");
+
+            // The output is only written after all lines have been read, so that
+            // the expression may refer to the output array.
+            detail::separable_convolution_plan execution_plan = make_plan(0, in.shape(), kernels, options, true);
+            convolve_axes(0, std::move(in), std::move(out), kernels, options, execution_plan);
+        }
+
         template <class T1, index_t N1, class T2, index_t N2, class T3>
         void impl(index_t dim, view_nd<T1, N1> in, view_nd<T2, N2> out,
                   kernel_1d<T3> const & kernel,
@@ -325,35 +859,229 @@ namespace xvigra
             vigra_precondition(dim > 0 || kernels.size() == in.dimension(),
                 name + "(): number of kernels doesn't match data dimension.");
 
+            detail::separable_convolution_plan execution_plan = make_plan(dim, shape_t<>(in.shape()), kernels, options, true);
+            // use static dimension for 2D and 3D data
+            dispatch_static_dimension(std::move(in), std::move(out), [&](auto & sin, auto & sout)
+            {
+                convolve_axes(dim, sin, sout, kernels, options, execution_plan);
+            });
+        }
+
+            /** \brief The algorithm chosen for each axis when data of the given shape
+                are convolved with the given kernel(s) and options.
+
+                The algorithm is chosen per axis, depending on the kernel size and line
+                length, by minimizing <tt>options.cost_model.cost()</tt>, unless it is
+                fixed via <tt>options.use_algorithm()</tt>. Symmetric convolution is
+                only applied to (anti-)symmetric kernels and falls back to direct
+                convolution otherwise.
+
+                <b>Usage:</b>
+                \code
+                for(auto const & p: separable_convolution.plan(image.shape(), gaussian_kernel_1d<float>(10.0)))
+                {
+                    std::cerr << to_string(p) << "\n";
+                }
+                \endcode
+            */
+        template <class T3>
+        std::vector<convolution_axis_plan>
+        plan(shape_t<> const & shape, kernel_1d<T3> const & kernel,
+             convolution_options const & options = convolution_options()) const
+        {
+            return plan(shape, std::vector<kernel_1d<T3>>(shape.size(), kernel), options);
+        }
+
+        template <class Kernels,
+                  VIGRA_REQUIRE<kernel_1d_concept<typename std::decay_t<Kernels>::value_type>::value>>
+        std::vector<convolution_axis_plan>
+        plan(shape_t<> const & shape, Kernels const & kernels,
+             convolution_options const & options = convolution_options()) const
+        {
+            vigra_precondition((index_t)kernels.size() == shape.size(),
+                name + ".plan(): number of kernels doesn't match data dimension.");
+            return make_plan(0, shape, kernels, options, false).axes;
+        }
+
+        template <class Kernels>
+        detail::separable_convolution_plan
+        make_plan(index_t dim, shape_t<> const & shape, Kernels const & kernels,
+                  convolution_options const & options, bool create_fft) const
+        {
+            detail::separable_convolution_plan res;
+            index_t N = dim + shape.size();
+            res.axes.resize(N);
+            res.symmetry.resize(N, 0);
+            res.fft.resize(N);
+            for(index_t d=dim; d<N; ++d)
+            {
+                auto const & kernel = kernels[d];
+                index_t length = shape[d-dim];
+                int symmetry = detail::kernel_symmetry(kernel);
+                convolution_algorithm algorithm = options.get_algorithm(d);
+                if(algorithm == automatic_convolution)
+                {
+                    algorithm = options.cost_model.select(kernel.size(), length, symmetry != 0);
+                }
+                else if(algorithm == symmetric_convolution && symmetry == 0)
+                {
+                    algorithm = direct_convolution;
+                }
+
+                convolution_axis_plan & p = res.axes[d];
+                p.axis = d;
+                p.kernel_size = kernel.size();
+                p.line_length = length;
+                p.algorithm = algorithm;
+                p.cost = options.cost_model.cost(algorithm, kernel.size(), length);
+                res.symmetry[d] = symmetry;
+                if(create_fft && algorithm == fft_convolution)
+                {
+                    res.fft[d].reset(new detail::fft_line_convolver(kernel, length,
+                                                                    options.get_left_padding(d),
+                                                                    options.get_right_padding(d)));
+                }
+            }
+            return res;
+        }
+
+            // 'in' is either a view_nd or a detail::expression_line_reader
+        template <class IN, class T2, index_t N2, class Kernels>
+        void convolve_axes(index_t dim, IN in, view_nd<T2, N2> out,
+                           Kernels const & kernels, convolution_options const & options,
+                           detail::separable_convolution_plan & execution_plan) const
+        {
+            using T1 = typename IN::value_type;
             padding_mode left_padding  = options.get_left_padding(dim),
                          right_padding = options.get_right_padding(dim);
+            convolution_algorithm algorithm = execution_plan.axes[dim].algorithm;
 
             if(in.dimension() == 1)
             {
                 // execute convolution over right-most dimension
-                convolve_row(in.template view<1>(), out.template view<1>(), kernels[dim],
-                             options.simd, left_padding, right_padding);
+                if(algorithm == fft_convolution)
+                {
+                    (*execution_plan.fft[dim])(in, out.template view<1>());
+                }
+                else if(algorithm == symmetric_convolution)
+                {
+                    convolve_row_symmetric(in, out.template view<1>(), kernels[dim],
+                                           execution_plan.symmetry[dim], options.simd, left_padding, right_padding);
+                }
+                else
+                {
+                    convolve_row(in.template view<1>(), out.template view<1>(), kernels[dim],
+                                 options.simd, left_padding, right_padding);
+                }
             }
             else
             {
                 using tmp_type = std::conditional_t<std::is_integral<T1>::value, float, T1>;
-                array_nd<tmp_type> tmp(in.shape()); // FIXME: use less tmp memory
+                constexpr index_t tmp_dimension = IN::ndim > 1 ? IN::ndim : runtime_size;
+                temporary_array_nd<tmp_type, tmp_dimension> tmp(in.shape()); // FIXME: use less tmp memory
                 for(index_t k=0; k<in.shape(0); ++k)
                 {
-                    impl(dim+1, in.bind(0,k), tmp.bind(0,k), kernels, options);
+                    convolve_axes(dim+1, in.bind(0,k), tmp.bind(0,k), kernels, options, execution_plan);
                 }
-                slicer nav(out.shape());
-                nav.set_free_axes(shape_t<>{0, (index_t)out.dimension()-1});
-                for(; nav.has_more(); ++nav)
+                shape_t<2> plane_axes{0, (index_t)out.dimension()-1};
+                auto tmp_plane = make_subarray_iterator(tmp, plane_axes);
+                auto out_plane = make_subarray_iterator(out, plane_axes);
+                for(; tmp_plane.has_more(); ++tmp_plane, ++out_plane)
                 {
                     // execute convolution over left-most dimension, working
                     // along rows in the inner loop
-                    convolve_columns(tmp.view(*nav).template view<2>(), out.view(*nav).template view<2>(),
-                                     kernels[dim], options.simd, left_padding, right_padding);
+                    if(algorithm == fft_convolution)
+                    {
+                        convolve_columns_fft(*tmp_plane, *out_plane, *execution_plan.fft[dim]);
+                    }
+                    else
+                    {
+                        convolve_columns(*tmp_plane, *out_plane,
+                                         kernels[dim], options.simd, left_padding, right_padding,
+                                         algorithm == symmetric_convolution ? execution_plan.symmetry[dim] : 0);
+                    }
                 }
             }
         }
 
+            // 'in' is either a view_nd or a detail::expression_line_reader
+        template <class IN, class T2, class T3>
+        void convolve_row_symmetric(IN const & in, view_nd<T2, 1> && out,
+                                    kernel_1d<T3> const & kernel, int symmetry, bool use_simd,
+                                    padding_mode left_padding, padding_mode right_padding) const
+        {
+            using tmp_type = std::conditional_t<std::is_floating_point<T2>::value, T2, float>;
+#ifdef XVIGRA_USE_SIMD
+            use_simd = use_simd && std::is_floating_point<tmp_type>::value;
+#else
+            use_simd = false;
+#endif
+            index_t radius = kernel.center();
+            index_t left_pad  = (left_padding == no_padding) ? 0 : radius,
+                    right_pad = (right_padding == no_padding) ? 0 : radius;
+            index_t start = (left_padding == no_padding) ? radius : 0;
+            index_t end   = (right_padding == no_padding) ? in.shape(0) - radius : in.shape(0);
+            if(end <= start)
+            {
+                return;
+            }
+
+            temporary_array_nd<tmp_type, 1> padded(shape_t<1>{in.shape(0)+left_pad+right_pad});
+            detail::load_padded_line(in, padded, left_padding, left_pad, right_padding, right_pad);
+            std::vector<tmp_type, XVIGRA_TEMPORARY_ALLOCATOR(tmp_type)> res(end-start);
+
+            // p[l] corresponds to in(start+l)
+            tmp_type const * p = &padded(left_pad+start);
+            tmp_type sign = (tmp_type)symmetry;
+            index_t size = end - start;
+            if(use_simd)
+            {
+                detail::simd_mul_row(p, size, res.data(), (tmp_type)kernel(radius));
+            }
+            else
+            {
+                for(index_t l=0; l<size; ++l)
+                {
+                    res[l] = (tmp_type)kernel(radius)*p[l];
+                }
+            }
+            for(index_t k=1; k<=radius; ++k)
+            {
+                // kernel(radius+k) == sign*kernel(radius-k)
+                tmp_type a = (tmp_type)kernel(radius-k);
+                if(use_simd)
+                {
+                    detail::simd_fma_row_symmetric(p+k, p-k, size, res.data(), a, sign);
+                }
+                else
+                {
+                    for(index_t l=0; l<size; ++l)
+                    {
+                        res[l] += a*(p[l+k] + sign*p[l-k]);
+                    }
+                }
+            }
+            for(index_t l=0; l<size; ++l)
+            {
+                out(start+l) = static_cast<T2>(res[l]);
+            }
+        }
+
+        template <class T1, class T2>
+        void convolve_columns_fft(view_nd<T1, 2> && in, view_nd<T2, 2> && out,
+                                  detail::fft_line_convolver & fft) const
+        {
+            index_t l = 0;
+            for(; l+1 < in.shape(1); l += 2)
+            {
+                fft(in.bind(1, l), in.bind(1, l+1), out.bind(1, l), out.bind(1, l+1));
+            }
+            if(l < in.shape(1))
+            {
+                fft(in.bind(1, l), out.bind(1, l));
+            }
+        }
+
         template <class T1, class T2, class T3>
         void convolve_row(view_nd<T1, 1> && in, view_nd<T2, 1> && out,
                           kernel_1d<T3> const & kernel, bool use_simd,
@@ -385,7 +1113,7 @@ namespace xvigra
             }
             if(!in.is_contiguous())
             {
-                array_nd<float, 1> padded(shape_t<1>{in.shape(0)+left+right});
+                temporary_array_nd<float, 1> padded(shape_t<1>{in.shape(0)+left+right});
                 copy_with_padding(in, padded, left_padding, left, right_padding, right);
                 for(index_t k=0; k<rev_kernel.size(); ++k)
                 {
@@ -594,7 +1322,8 @@ namespace xvigra
         template <class T1, class T2, class T3>
         void convolve_columns(view_nd<T1, 2> && in, view_nd<T2, 2> && out,
                               kernel_1d<T3> const & kernel, bool use_simd,
-                              padding_mode left_padding, padding_mode right_padding) const
+                              padding_mode left_padding, padding_mode right_padding,
+                              int symmetry = 0) const
         {
 #ifdef XVIGRA_USE_SIMD
             use_simd = use_simd &&
@@ -607,7 +1336,6 @@ namespace xvigra
             auto rev_kernel = kernel.view(slice(_,_,-1));
             index_t right = kernel.center(),
                     left  = kernel.size() - right - 1;
-            // FIXME: optimize for (a)symmetric kernels
             index_t start = (left_padding == no_padding) ? left : 0;
             index_t end   = (right_padding == no_padding) ? in.shape(0) - right : in.shape(0);
             for(index_t j=start; j<end; ++j)
@@ -624,56 +1352,75 @@ namespace xvigra
                         out(j,l) = rev_kernel(left)*in(j,l);
                     }
                 }
-                for(index_t k=-left; k<=right; ++k)
+                if(symmetry == 0)
                 {
-                    if(k==0)
+                    for(index_t k=-left; k<=right; ++k)
                     {
-                        continue;
-                    }
-                    index_t i = j + k;
-                    if(!adjust_index_near_border(i, in.shape(0), left_padding, right_padding))
-                    {
-                        continue; // if zero_padding
-                    }
-
-                    if(use_simd)
-                    {
-                        detail::simd_fma_row(&in(i,0), in.shape(1), &out(j,0), rev_kernel(k+left));
+                        if(k==0)
+                        {
+                            continue;
+                        }
+                        index_t i = j + k;
+                        if(!adjust_index_near_border(i, in.shape(0), left_padding, right_padding))
+                        {
+                            continue; // if zero_padding
+                        }
+                        add_row(in, i, out, j, rev_kernel(k+left), use_simd);
                     }
-                    else
+                }
+                else
+                {
+                    // use symmetry of the kernel: rev_kernel(left-k) == symmetry*rev_kernel(left+k)
+                    for(index_t k=1; k<=right; ++k)
                     {
-                        // out.bind(0, j) += rev_kernel(k+left)*in.bind(0,i);
-                        for(index_t l=0; l<in.shape(1); ++l)
+                        index_t i1 = j + k,
+                                i2 = j - k;
+                        bool has1 = adjust_index_near_border(i1, in.shape(0), left_padding, right_padding),
+                             has2 = adjust_index_near_border(i2, in.shape(0), left_padding, right_padding);
+                        T3 a = rev_kernel(k+left);
+                        if(has1 && has2)
                         {
-                            out(j,l) += rev_kernel(k+left)*in(i,l);
+                            if(use_simd)
+                            {
+                                detail::simd_fma_row_symmetric(&in(i1,0), &in(i2,0), in.shape(1), &out(j,0), a, T3(symmetry));
+                            }
+                            else
+                            {
+                                // out.bind(0, j) += a*(in.bind(0,i1) + symmetry*in.bind(0,i2));
+                                for(index_t l=0; l<in.shape(1); ++l)
+                                {
+                                    out(j,l) += a*(in(i1,l) + symmetry*in(i2,l));
+                                }
+                            }
+                        }
+                        else if(has1)
+                        {
+                            add_row(in, i1, out, j, a, use_simd);
+                        }
+                        else if(has2)
+                        {
+                            add_row(in, i2, out, j, T3(symmetry*a), use_simd);
                         }
                     }
                 }
-                // // experimental: use symmetry of the kernel, minimal speed advantage (within measurement noise)
-                // for(index_t k=-left; k<0; ++k)
-                // {
-                //     index_t i1 = j + k,
-                //             i2 = j - k;
-                //     if(!adjust_index_near_border(i1, in.shape(0), left_padding, right_padding) ||
-                //        !adjust_index_near_border(i2, in.shape(0), left_padding, right_padding))
-                //     {
-                //         continue;
-                //     }
-
-                //     // convolution of interior
-                //     if(use_simd)
-                //     {
-                //         detail::simd_fma_row_symmetric(&in(i1,0), &in(i2,0), in.shape(1), &out(j,0), rev_kernel(k+left));
-                //     }
-                //     else
-                //     {
-                //         // out.bind(0, j) += rev_kernel(k)*(in.bind(0,i1)+in.bind(0,i2));
-                //         for(index_t l=0; l<in.shape(1); ++l)
-                //         {
-                //             out(j,l) += rev_kernel(k+left)*(in(i1,l) + in(i2,l));
-                //         }
-                //     }
-                // }
+            }
+        }
+
+            // out.bind(0, j) += a*in.bind(0, i)
+        template <class T1, class T2, class T3>
+        void add_row(view_nd<T1, 2> const & in, index_t i, view_nd<T2, 2> & out, index_t j,
+                     T3 a, bool use_simd) const
+        {
+            if(use_simd)
+            {
+                detail::simd_fma_row(&in(i,0), in.shape(1), &out(j,0), a);
+            }
+            else
+            {
+                for(index_t l=0; l<in.shape(1); ++l)
+                {
+                    out(j,l) += a*in(i,l);
+                }
             }
         }
     };
@@ -688,6 +1435,45 @@ namespace xvigra
         }
     }
 
+        /** \brief Measure the cost model of <tt>separable_convolution</tt> on this machine.
+
+            Convolves a <tt>size x size</tt> <tt>float</tt> image with a Gaussian of
+            31 taps using each algorithm and derives the cost constants from the
+            fastest of three runs. Pass the result to <tt>convolution_options::use_cost_model()</tt>.
+        */
+    inline convolution_cost_model
+    calibrate_convolution_cost_model(index_t size = 512)
+    {
+        array_nd<float, 2> in(shape_t<2>{size, size}), out(in.shape());
+        index_t k = 0;
+        for(auto & v: in)
+        {
+            v = (float)(k++ % 17);
+        }
+        auto kernel = gaussian_kernel_1d<float>(5.0);
+
+        auto measure = [&](convolution_algorithm algorithm)
+        {
+            double best = std::numeric_limits<double>::max();
+            for(int run=0; run<3; ++run)
+            {
+                auto start = std::chrono::steady_clock::now();
+                separable_convolution(in, out, kernel, convolution_options().use_algorithm(algorithm));
+                std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+                best = std::min(best, t.count());
+            }
+            // per sample and axis
+            return best / (2.0 * in.size());
+        };
+
+        convolution_cost_model res, defaults;
+        index_t ksize = kernel.size();
+        res.direct_per_tap = measure(direct_convolution) / ksize;
+        res.symmetric_per_tap = measure(symmetric_convolution) / (ksize / 2 + 1);
+        res.fft_per_stage = measure(fft_convolution) / defaults.cost(fft_convolution, ksize, size) * defaults.fft_per_stage;
+        return res;
+    }
+
 }
 
 #endif // XVIGRA_SEPARABLE_CONVOLUTION_HPP
@@ -0,0 +1,585 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_SPLINE_VIEW_HPP
+#define XVIGRA_SPLINE_VIEW_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <vector>
+#include "global.hpp"
+#include "error.hpp"
+#include "tiny_vector.hpp"
+#include "array_nd.hpp"
+#include "splines.hpp"
+#include "recursive_filter.hpp"
+
+namespace xvigra
+{
+    namespace detail
+    {
+        // Mirror index 'i' into the range [0, size) without repeating the border sample
+        // (consistent with the reflect_padding mode of spline_prefilter()).
+        inline index_t spline_reflect_index(index_t i, index_t size)
+        {
+            if(i >= 0 && i < size)
+            {
+                return i;
+            }
+            if(size == 1)
+            {
+                return 0;
+            }
+            index_t period = 2*(size - 1);
+            i %= period;
+            if(i < 0)
+            {
+                i += period;
+            }
+            return i < size
+                       ? i
+                       : period - i;
+        }
+
+        // Weighted sum over a (ksize x ... x ksize) neighborhood. 'offsets' and 'weights'
+        // hold 'ksize' entries per axis, the innermost axis coming last.
+        template <class T>
+        inline double spline_weighted_sum(T const * p, index_t const * offsets, double const * weights,
+                                          index_t ksize, index_t axes)
+        {
+            double sum = 0.0;
+            if(axes == 1)
+            {
+                for(index_t k=0; k<ksize; ++k)
+                {
+                    sum += weights[k]*p[offsets[k]];
+                }
+            }
+            else
+            {
+                for(index_t k=0; k<ksize; ++k)
+                {
+                    sum += weights[k]*spline_weighted_sum(p + offsets[k], offsets + ksize, weights + ksize,
+                                                          ksize, axes - 1);
+                }
+            }
+            return sum;
+        }
+
+        // Weighted sums for a block of 'n' points whose neighborhoods lie inside the array,
+        // contracting one axis after the other. 'base' holds the offset of each point's
+        // first tap, 'w' the kernel weights indexed by (axis, tap, point) with 'ws'
+        // entries per tap. The tap loops have compile-time length and are unrolled.
+        template <index_t KSIZE, class T>
+        inline void spline_block_sum(T const * data, index_t const * base, index_t n,
+                                     index_t s0, double const * w, index_t ws, double * res)
+        {
+            for(index_t j=0; j<n; ++j)
+            {
+                T const * p = data + base[j];
+                double sum = 0.0;
+                for(index_t k=0; k<KSIZE; ++k)
+                {
+                    sum += w[k*ws+j]*p[k*s0];
+                }
+                res[j] = sum;
+            }
+        }
+
+        template <index_t KSIZE, class T>
+        inline void spline_block_sum(T const * data, index_t const * base, index_t n,
+                                     index_t s0, index_t s1, double const * w, index_t ws, double * res)
+        {
+            double const * w0 = w,
+                         * w1 = w + KSIZE*ws;
+            std::fill(res, res+n, 0.0);
+            for(index_t i=0; i<KSIZE; ++i)
+            {
+                for(index_t j=0; j<n; ++j)
+                {
+                    T const * p = data + base[j] + i*s0;
+                    double sum = 0.0;
+                    for(index_t k=0; k<KSIZE; ++k)
+                    {
+                        sum += w1[k*ws+j]*p[k*s1];
+                    }
+                    res[j] += w0[i*ws+j]*sum;
+                }
+            }
+        }
+
+        template <index_t KSIZE, class T>
+        inline void spline_block_sum(T const * data, index_t const * base, index_t n,
+                                     index_t s0, index_t s1, index_t s2, double const * w, index_t ws, double * res)
+        {
+            double const * w0 = w,
+                         * w1 = w + KSIZE*ws,
+                         * w2 = w + 2*KSIZE*ws;
+            std::fill(res, res+n, 0.0);
+            for(index_t i=0; i<KSIZE; ++i)
+            {
+                for(index_t l=0; l<KSIZE; ++l)
+                {
+                    for(index_t j=0; j<n; ++j)
+                    {
+                        T const * p = data + base[j] + i*s0 + l*s1;
+                        double sum = 0.0;
+                        for(index_t k=0; k<KSIZE; ++k)
+                        {
+                            sum += w2[k*ws+j]*p[k*s2];
+                        }
+                        res[j] += w0[i*ws+j]*w1[l*ws+j]*sum;
+                    }
+                }
+            }
+        }
+    } // namespace detail
+
+    /******************/
+    /* spline_view_nd */
+    /******************/
+
+        /** \brief Interpolated access to a view_nd via B-spline coefficients.
+
+            The constructor computes the B-spline coefficients of the given data by
+            <tt>spline_prefilter()</tt> (or just copies the data when they are already
+            prefiltered). Afterwards, the spline and its partial derivatives can be sampled
+            at arbitrary real-valued coordinates. Coordinates outside the array are
+            handled by mirroring at the borders (the same convention as the prefilter).
+
+            The kernel weights are polynomials in the sub-pixel offset whose coefficients
+            are given by <tt>b_spline<ORDER>::weights()</tt>. Point queries via
+            <tt>operator()</tt>, <tt>dx()</tt> etc. combine these with the coefficients of
+            the current cell into a single N-D polynomial, which is cached. Consecutive
+            queries in the same cell therefore only need to evaluate this polynomial.
+            Since the cache is shared state, point queries on the same object must not be
+            issued concurrently.
+
+            Batched queries (<tt>operator()(points, out)</tt>) do not touch the cache and
+            are thread-safe. They evaluate the kernel weights for blocks of points at
+            once (see <tt>b_spline_weights()</tt>), followed by the weighted sum over
+            the neighborhoods. For 1D, 2D and 3D arrays, the sum is contracted axis by
+            axis over the whole block with unrolled tap loops, and border mirroring is
+            only done for points whose neighborhood leaves the array.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 2> image(...);
+            spline_view_nd<3, float, 2> spline(image);
+
+            float v  = spline({10.3, 20.7});        // interpolated value
+            float gy = spline.dx({10.3, 20.7}, 0);  // derivative along axis 0
+            float gx = spline.dx({10.3, 20.7}, 1);  // derivative along axis 1
+
+            array_nd<double, 2> points({count, 2});  // one (y, x) coordinate per row
+            array_nd<float, 1>  values({count});
+            spline(points, values);
+            \endcode
+        */
+    template <int ORDER, class T = float, index_t N = runtime_size>
+    class spline_view_nd
+    {
+      public:
+        static_assert(std::is_floating_point<T>::value,
+                      "spline_view_nd: value type must be a floating point type.");
+
+        static constexpr int     static_order = ORDER;
+        static constexpr index_t ksize        = ORDER + 1;
+
+        using value_type      = T;
+        using spline_type     = b_spline<ORDER, double>;
+        using array_type      = array_nd<T, N>;
+        using shape_type      = shape_t<N>;
+        using coordinate_type = tiny_vector<double, N>;
+
+            /** Compute the spline coefficients of \a data. If \a is_prefiltered is
+                <tt>true</tt>, \a data are taken as the coefficients.
+            */
+        template <class U, index_t M>
+        explicit spline_view_nd(view_nd<U, M> const & data, bool is_prefiltered = false)
+        : coefficients_(shape_type(data.shape()))
+        , weights_(ksize*ksize)
+        , cell_()
+        , cache_valid_(false)
+        {
+            recursive_filter(data, coefficients_,
+                             is_prefiltered
+                                 ? std::vector<double>()
+                                 : spline_type().prefilter_coefficients());
+
+            auto const & w = spline_type::weights();
+            for(index_t i=0; i<ksize; ++i)
+            {
+                for(index_t k=0; k<ksize; ++k)
+                {
+                    weights_[i*ksize+k] = w[i][k];
+                }
+            }
+
+            index_t size = 1;
+            for(index_t d=0; d<dimension(); ++d)
+            {
+                size *= ksize;
+            }
+            polynomial_.resize(size);
+            work_.resize(size);
+            offsets_.resize(dimension()*ksize);
+            powers_.resize(dimension()*ksize);
+        }
+
+        index_t dimension() const
+        {
+            return coefficients_.dimension();
+        }
+
+        shape_type const & shape() const
+        {
+            return coefficients_.shape();
+        }
+
+        array_type const & coefficients() const
+        {
+            return coefficients_;
+        }
+
+            /** Check if all coordinates are in the range <tt>[0, shape(d)-1]</tt>.
+            */
+        bool is_inside(coordinate_type const & p) const
+        {
+            for(index_t d=0; d<dimension(); ++d)
+            {
+                if(p[d] < 0.0 || p[d] > (double)(shape()[d] - 1))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+            /** Interpolated value at \a p.
+            */
+        value_type operator()(coordinate_type const & p) const
+        {
+            return (*this)(p, shape_type(dimension(), 0));
+        }
+
+            /** Partial derivative of the spline at \a p, where \a derivative_order
+                specifies the derivative order along each axis.
+            */
+        value_type operator()(coordinate_type const & p, shape_type const & derivative_order) const
+        {
+            index_t ndim = dimension();
+            vigra_precondition(p.size() == ndim && derivative_order.size() == ndim,
+                "spline_view_nd::operator(): coordinate dimension mismatch.");
+
+            shape_type cell(ndim);
+            coordinate_type u(ndim);
+            for(index_t d=0; d<ndim; ++d)
+            {
+                cell[d] = split_coordinate(p[d], u[d]);
+            }
+            if(!cache_valid_ || cell != cell_)
+            {
+                compute_polynomial(cell);
+            }
+            return static_cast<value_type>(evaluate_polynomial(u, derivative_order));
+        }
+
+            /** First derivative along \a axis at \a p.
+            */
+        value_type dx(coordinate_type const & p, index_t axis = 0) const
+        {
+            shape_type derivative_order(dimension(), 0);
+            derivative_order[axis] = 1;
+            return (*this)(p, derivative_order);
+        }
+
+            /** Second derivative along \a axis at \a p.
+            */
+        value_type dxx(coordinate_type const & p, index_t axis = 0) const
+        {
+            shape_type derivative_order(dimension(), 0);
+            derivative_order[axis] = 2;
+            return (*this)(p, derivative_order);
+        }
+
+            /** Mixed second derivative along \a axis1 and \a axis2 at \a p.
+            */
+        value_type dxy(coordinate_type const & p, index_t axis1 = 0, index_t axis2 = 1) const
+        {
+            shape_type derivative_order(dimension(), 0);
+            derivative_order[axis1] += 1;
+            derivative_order[axis2] += 1;
+            return (*this)(p, derivative_order);
+        }
+
+            /** Batched evaluation: \a points has shape <tt>(count, dimension())</tt>,
+                with one coordinate per row, and the results are written to
+                \a out, which must have shape <tt>(count,)</tt>.
+            */
+        template <class C, index_t M1, class R, index_t M2>
+        void operator()(view_nd<C, M1> const & points, view_nd<R, M2> out) const
+        {
+            (*this)(points, std::move(out), shape_type(dimension(), 0));
+        }
+
+            /** Batched evaluation of the partial derivative given by
+                \a derivative_order.
+            */
+        template <class C, index_t M1, class R, index_t M2>
+        void operator()(view_nd<C, M1> const & points, view_nd<R, M2> out,
+                        shape_type const & derivative_order) const
+        {
+            index_t ndim = dimension();
+            vigra_precondition(points.dimension() == 2 && points.shape()[1] == ndim,
+                "spline_view_nd::operator(): points must have shape (count, dimension()).");
+            vigra_precondition(out.dimension() == 1 && out.shape()[0] == points.shape()[0],
+                "spline_view_nd::operator(): out must have shape (count,).");
+            vigra_precondition(derivative_order.size() == ndim,
+                "spline_view_nd::operator(): derivative_order dimension mismatch.");
+
+            static const index_t block_size = 64;
+            index_t count = points.shape()[0];
+
+            std::vector<double>  u(block_size), block_weights(ndim*ksize*block_size),
+                                 point_weights(ndim*ksize), sums(block_size);
+            std::vector<index_t> first(ndim*block_size), offsets(ndim*ksize), base(block_size);
+            std::vector<char>    at_border(block_size);
+            T const * data = coefficients_.raw_data();
+            auto const & strides = coefficients_.strides();
+
+                // the block kernels need static dimension, and all taps of interior points
+                // (and the dummy base 0 of border points) must be inside the array
+            bool use_block_sum = ndim <= 3 && all_greater_equal(shape(), ksize);
+
+            for(index_t j0=0; j0<count; j0+=block_size)
+            {
+                index_t n = std::min(block_size, count - j0);
+                for(index_t d=0; d<ndim; ++d)
+                {
+                    for(index_t j=0; j<n; ++j)
+                    {
+                        first[d*block_size+j] = split_coordinate((double)points(j0+j, d), u[j]);
+                    }
+                    detail::b_spline_weights_impl<ORDER>(u.data(), n, &block_weights[d*ksize*block_size],
+                                                         block_size, (unsigned int)derivative_order[d], true);
+                }
+
+                for(index_t j=0; j<n; ++j)
+                {
+                    index_t offset = 0;
+                    bool inside = true;
+                    for(index_t d=0; d<ndim; ++d)
+                    {
+                        index_t i0 = first[d*block_size+j];
+                        inside = inside && i0 >= 0 && i0 + ksize <= shape()[d];
+                        offset += i0*strides[d];
+                    }
+                    at_border[j] = !inside;
+                    base[j] = inside
+                                  ? offset
+                                  : 0;
+                }
+
+                if(use_block_sum)
+                {
+                    switch(ndim)
+                    {
+                      case 1:
+                        detail::spline_block_sum<ksize>(data, base.data(), n, strides[0],
+                                                        block_weights.data(), block_size, sums.data());
+                        break;
+                      case 2:
+                        detail::spline_block_sum<ksize>(data, base.data(), n, strides[0], strides[1],
+                                                        block_weights.data(), block_size, sums.data());
+                        break;
+                      default:
+                        detail::spline_block_sum<ksize>(data, base.data(), n, strides[0], strides[1], strides[2],
+                                                        block_weights.data(), block_size, sums.data());
+                    }
+                }
+
+                for(index_t j=0; j<n; ++j)
+                {
+                    if(!use_block_sum || at_border[j])
+                    {
+                        for(index_t d=0; d<ndim; ++d)
+                        {
+                            index_t i0 = first[d*block_size+j],
+                                    size = shape()[d],
+                                    stride = strides[d];
+                            for(index_t k=0; k<ksize; ++k)
+                            {
+                                offsets[d*ksize+k] = detail::spline_reflect_index(i0 + k, size)*stride;
+                                point_weights[d*ksize+k] = block_weights[(d*ksize+k)*block_size+j];
+                            }
+                        }
+                        sums[j] = detail::spline_weighted_sum(data, offsets.data(),
+                                                              point_weights.data(), ksize, ndim);
+                    }
+                    out(j0+j) = static_cast<R>(sums[j]);
+                }
+            }
+        }
+
+      private:
+
+            // Split coordinate 'x' into the index of the first kernel tap and the
+            // offset 'u' relative to the cell center (in [0, 1) for odd orders,
+            // in [-0.5, 0.5) for even orders).
+        static index_t split_coordinate(double x, double & u)
+        {
+            double c = (ORDER % 2 == 1)
+                           ? std::floor(x)
+                           : std::floor(x + 0.5);
+            u = x - c;
+            return (index_t)c - ORDER / 2;
+        }
+
+            // Contract the coefficients around 'cell' with the weight matrix along
+            // all axes, giving the coefficients of the cell's N-D polynomial.
+        void compute_polynomial(shape_type const & cell) const
+        {
+            index_t ndim = dimension(),
+                    size = (index_t)polynomial_.size();
+            for(index_t d=0; d<ndim; ++d)
+            {
+                for(index_t k=0; k<ksize; ++k)
+                {
+                    offsets_[d*ksize+k] = detail::spline_reflect_index(cell[d] + k, shape()[d])*
+                                          coefficients_.strides()[d];
+                }
+            }
+
+            // gather the neighborhood, last axis varying fastest
+            T const * data = coefficients_.raw_data();
+            shape_type k(ndim, 0);
+            for(index_t i=0; i<size; ++i)
+            {
+                index_t offset = 0;
+                for(index_t d=0; d<ndim; ++d)
+                {
+                    offset += offsets_[d*ksize+k[d]];
+                }
+                polynomial_[i] = data[offset];
+                for(index_t d=ndim-1; d>=0; --d)
+                {
+                    if(++k[d] < ksize)
+                    {
+                        break;
+                    }
+                    k[d] = 0;
+                }
+            }
+
+            // a[..., i, ...] = sum_k weights[i][k] * g[..., k, ...]
+            index_t inner = size;
+            for(index_t d=0; d<ndim; ++d)
+            {
+                inner /= ksize;
+                index_t outer = size / (inner*ksize);
+                for(index_t o=0; o<outer; ++o)
+                {
+                    double const * src = &polynomial_[o*ksize*inner];
+                    double * dest = &work_[o*ksize*inner];
+                    for(index_t i=0; i<ksize; ++i, dest += inner)
+                    {
+                        for(index_t j=0; j<inner; ++j)
+                        {
+                            double sum = 0.0;
+                            for(index_t kk=0; kk<ksize; ++kk)
+                            {
+                                sum += weights_[i*ksize+kk]*src[kk*inner+j];
+                            }
+                            dest[j] = sum;
+                        }
+                    }
+                }
+                std::swap(polynomial_, work_);
+            }
+
+            cell_ = cell;
+            cache_valid_ = true;
+        }
+
+            // Evaluate (the derivative of) the cached polynomial at offset 'u'.
+        double evaluate_polynomial(coordinate_type const & u, shape_type const & derivative_order) const
+        {
+            index_t ndim = dimension();
+            for(index_t d=0; d<ndim; ++d)
+            {
+                index_t r = derivative_order[d];
+                double p = 1.0;
+                for(index_t i=0; i<ksize; ++i)
+                {
+                    if(i < r)
+                    {
+                        powers_[d*ksize+i] = 0.0;
+                    }
+                    else
+                    {
+                        powers_[d*ksize+i] = detail::spline_falling_factorial(i, r)*p;
+                        p *= u[d];
+                    }
+                }
+            }
+
+            // contract from the last axis down to axis 0
+            index_t size = (index_t)polynomial_.size();
+            double const * src = polynomial_.data();
+            for(index_t d=ndim-1; d>=0; --d)
+            {
+                size /= ksize;
+                for(index_t b=0; b<size; ++b)
+                {
+                    double sum = 0.0;
+                    for(index_t i=0; i<ksize; ++i)
+                    {
+                        sum += src[b*ksize+i]*powers_[d*ksize+i];
+                    }
+                    work_[b] = sum;
+                }
+                src = work_.data();
+            }
+            return src[0];
+        }
+
+        array_type coefficients_;
+        std::vector<double> weights_;
+        mutable std::vector<double> polynomial_, work_, powers_;
+        mutable std::vector<index_t> offsets_;
+        mutable shape_type cell_;
+        mutable bool cache_valid_;
+    };
+
+} // namespace xvigra
+
+#endif // XVIGRA_SPLINE_VIEW_HPP
@@ -35,9 +35,15 @@
 
 #include <cmath>
 #include <vector>
+
+#ifdef XVIGRA_USE_SIMD
+#  include <xsimd/xsimd.hpp>
+#endif
+
 #include "global.hpp"
 #include "error.hpp"
 #include "math.hpp"
+#include "array_nd.hpp"
 
 namespace xvigra
 {
@@ -155,9 +161,9 @@ namespace xvigra
             /** Get the prefilter coefficients required for interpolation.
                 To interpolate with a B-spline, \ref resamplingConvolveImage()
                 can be used. However, the image to be interpolated must be
-                pre-filtered using \ref recursiveFilterX() and \ref recursiveFilterY()
-                with the filter coefficients given by this function. The length of the array
-                corresponds to how many times the above recursive filtering
+                pre-filtered using \ref recursive_filter() with the filter coefficients
+                given by this function (or simply by \ref spline_prefilter()). The length of
+                the array corresponds to how many times the above recursive filtering
                 has to be applied (zero length means no prefiltering necessary).
             */
         std::vector<double> const & prefilter_coefficients() const
@@ -169,8 +175,9 @@ namespace xvigra
 
             /** Get the coefficients to transform spline coefficients into
                 the coefficients of the corresponding polynomial.
-                Currently internally used in SplineImageView; needs more
-                documentation ???
+                <tt>weights()[d][k]</tt> is the coefficient of <tt>u^d</tt> in the
+                weight of kernel tap <tt>k</tt>, where <tt>u</tt> is the offset from the
+                cell center. Used internally by spline_view_nd.
             */
         static weight_matrix_type const & weights()
         {
@@ -1288,6 +1295,147 @@ namespace xvigra
             return 2.0 + x * (-4.0 + x * (2.5 - 0.5 * x));
         }
     }
+
+    /********************/
+    /* b_spline_weights */
+    /********************/
+
+    namespace detail
+    {
+        // i! / (i-r)!
+        inline double spline_falling_factorial(index_t i, index_t r)
+        {
+            double res = 1.0;
+            for(index_t k=0; k<r; ++k)
+            {
+                res *= (double)(i - k);
+            }
+            return res;
+        }
+
+        // Horner scheme for the polynomial of tap 'k', unrolled at compile time:
+        // c[I][k] + u*(c[I+1][k] + u*(... + u*c[DEGREE][k]))
+        template <int I, int DEGREE>
+        struct b_spline_horner
+        {
+            template <class C, class V>
+            static V exec(C const & c, int k, V const & u)
+            {
+                return b_spline_horner<I+1, DEGREE>::exec(c, k, u)*u + V(c[I][k]);
+            }
+        };
+
+        template <int DEGREE>
+        struct b_spline_horner<DEGREE, DEGREE>
+        {
+            template <class C, class V>
+            static V exec(C const & c, int k, V const &)
+            {
+                return V(c[DEGREE][k]);
+            }
+        };
+
+        // Write the weight of tap k for offsets[j] to weights[k*tap_stride + j].
+        template <int ORDER, class T>
+        void b_spline_weights_impl(T const * offsets, index_t size,
+                                   T * weights, index_t tap_stride,
+                                   unsigned int derivative_order, bool use_simd)
+        {
+            static_assert(std::is_floating_point<T>::value,
+                "b_spline_weights(): value type must be a floating point type.");
+
+            // coefficients of the polynomials of the derivative
+            auto const & w = b_spline<ORDER, double>::weights();
+            T c[ORDER+1][ORDER+1];
+            for(int i = 0; i <= ORDER; ++i)
+            {
+                for(int k = 0; k <= ORDER; ++k)
+                {
+                    c[i][k] = i + (int)derivative_order <= ORDER
+                                  ? static_cast<T>(w[i+derivative_order][k] *
+                                                   spline_falling_factorial(i+derivative_order, derivative_order))
+                                  : T();
+                }
+            }
+
+            index_t j = 0;
+#ifdef XVIGRA_USE_SIMD
+            if(use_simd)
+            {
+                using batch_type = decltype(xsimd::set_simd(T()));
+                constexpr index_t simd_size = xsimd::simd_batch_traits<batch_type>::size;
+
+                index_t simd_end = size - size % simd_size;
+                for(; j<simd_end; j += simd_size)
+                {
+                    batch_type u = xsimd::load_unaligned(offsets + j);
+                    for(int k = 0; k <= ORDER; ++k)
+                    {
+                        b_spline_horner<0, ORDER>::exec(c, k, u).store_unaligned(weights + k*tap_stride + j);
+                    }
+                }
+            }
+#endif
+            for(; j<size; ++j)
+            {
+                T u = offsets[j];
+                for(int k = 0; k <= ORDER; ++k)
+                {
+                    weights[k*tap_stride + j] = b_spline_horner<0, ORDER>::exec(c, k, u);
+                }
+            }
+        }
+    } // namespace detail
+
+        /** \brief Evaluate the B-spline weights of all taps for many offsets at once.
+
+            For each offset <tt>u = offsets(j)</tt>, <tt>weights(k, j)</tt> receives the
+            weight of tap <tt>k</tt> (<tt>0 <= k <= ORDER</tt>), i.e. the value of
+            <tt>b_spline<ORDER>(u + ORDER/2 - k)</tt> (or its derivative of the
+            given order). The offset is measured relative to the sample
+            <tt>floor(x)</tt> for odd orders and <tt>round(x)</tt> for even orders, so
+            that <tt>u</tt> is in <tt>[0, 1)</tt> and <tt>[-0.5, 0.5)</tt> respectively,
+            and tap <tt>k</tt> refers to the sample <tt>floor(x) - ORDER/2 + k</tt>
+            (resp. <tt>round(x) - ORDER/2 + k</tt>).
+
+            The weights are computed from the polynomial form given by
+            <tt>b_spline<ORDER>::weights()</tt>, with the Horner scheme unrolled at
+            compile time. When <tt>XVIGRA_USE_SIMD</tt> is defined and both arrays
+            are contiguous along the offset axis, the offsets are processed in SIMD batches.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 1> offsets(shape_t<1>{n});
+            array_nd<float, 2> weights(shape_t<2>{4, n});
+            b_spline_weights<3>(offsets, weights);     // cubic B-spline weights
+            b_spline_weights<3>(offsets, weights, 1);  // first derivative
+            \endcode
+        */
+    template <int ORDER, class T, index_t N1, index_t N2>
+    void b_spline_weights(view_nd<T, N1> const & offsets, view_nd<T, N2> weights,
+                          unsigned int derivative_order = 0, bool use_simd = true)
+    {
+        vigra_precondition(offsets.dimension() == 1 && weights.dimension() == 2,
+            "b_spline_weights(): offsets must be 1-dimensional, weights 2-dimensional.");
+        vigra_precondition(weights.shape(0) == ORDER+1 && weights.shape(1) == offsets.shape(0),
+            "b_spline_weights(): weights must have shape (ORDER+1, offsets.shape(0)).");
+
+        if(offsets.strides(0) == 1 && weights.strides(1) == 1)
+        {
+            detail::b_spline_weights_impl<ORDER>(offsets.raw_data(), offsets.shape(0),
+                                                 weights.raw_data(), weights.strides(0),
+                                                 derivative_order, use_simd);
+        }
+        else
+        {
+            array_nd<T, 1> o(offsets);
+            array_nd<T, 2> w(weights.shape());
+            detail::b_spline_weights_impl<ORDER>(o.raw_data(), o.shape(0),
+                                                 w.raw_data(), w.strides(0),
+                                                 derivative_order, use_simd);
+            weights = w;
+        }
+    }
 } // namespace xvigra
 
 #endif /* XVIGRA_SPLINES_HPP */
@@ -0,0 +1,374 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_STREAMING_STORE_HPP
+#define XVIGRA_STREAMING_STORE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "global.hpp"
+
+#if defined(XVIGRA_USE_SIMD) && defined(__SSE2__)
+#  include <emmintrin.h>
+#  define XVIGRA_HAS_STREAMING_STORE
+#endif
+
+#ifndef XVIGRA_STREAMING_STORE_MIN_BYTES
+#  define XVIGRA_STREAMING_STORE_MIN_BYTES (std::size_t(1) << 23)
+#endif
+
+namespace xvigra
+{
+    /***************************/
+    /* streaming_store_options */
+    /***************************/
+
+        /** \brief Control the assignment path for large arrays.
+
+            When a contiguous view_nd of arithmetic type and at least
+            <tt>min_bytes</tt> bytes is filled with a scalar or assigned from a
+            non-overlapping expression of the same shape, the data are written
+            with non-temporal (streaming) stores that bypass the cache. This
+            avoids the read-for-ownership traffic and cache pollution of ordinary
+            stores when the destination doesn't fit into the cache anyway.
+            Non-temporal stores require <tt>XVIGRA_USE_SIMD</tt> and SSE2. Without
+            them, the special path is only taken when <tt>thread_count > 1</tt>,
+            where it splits the work into <tt>thread_count</tt> parts with ordinary
+            stores. Otherwise, xtensor's assignment is used.
+
+            The default threshold can be changed at compile time by defining
+            <tt>XVIGRA_STREAMING_STORE_MIN_BYTES</tt>, and at runtime via
+            <tt>default_streaming_store_options()</tt>.
+
+            <b>Usage:</b>
+            \code
+            default_streaming_store_options().thread_count = 4;
+            array_nd<float, 3> big(shape_t<3>{1000, 1000, 500});
+            big = 0.0f;                    // streaming stores in 4 threads
+            \endcode
+        */
+    struct streaming_store_options
+    {
+        bool enabled = true;
+        std::size_t min_bytes = XVIGRA_STREAMING_STORE_MIN_BYTES;
+        index_t thread_count = 1;
+    };
+
+    inline streaming_store_options & default_streaming_store_options()
+    {
+        static streaming_store_options options;
+        return options;
+    }
+
+    namespace detail
+    {
+            // without non-temporal stores, the buffered path only pays off when it runs in parallel
+        template <class T>
+        inline bool use_streaming_store(index_t size)
+        {
+            streaming_store_options const & options = default_streaming_store_options();
+#ifdef XVIGRA_HAS_STREAMING_STORE
+            bool worthwhile = true;
+#else
+            bool worthwhile = options.thread_count > 1;
+#endif
+            return std::is_arithmetic<T>::value && options.enabled && worthwhile &&
+                   size*sizeof(T) >= options.min_bytes;
+        }
+
+            // number of leading elements that must be written before 'p' is 16-byte aligned,
+            // or 'size' if this is impossible
+        template <class T>
+        inline index_t streaming_store_head(T * p, index_t size)
+        {
+            index_t head = 0;
+            while(head < size && (reinterpret_cast<std::uintptr_t>(p+head) & 15) != 0)
+            {
+                if(++head*sizeof(T) >= 16)
+                {
+                    return size;
+                }
+            }
+            return head;
+        }
+
+            // copy 'size' elements from the cache-resident, 16-byte aligned 'src'
+            // to the 16-byte aligned 'dest', bypassing the cache
+        template <class T>
+        inline void stream_copy_aligned(T * dest, T const * src, index_t size)
+        {
+#ifdef XVIGRA_HAS_STREAMING_STORE
+            std::size_t bytes = size*sizeof(T),
+                        blocks = bytes / 16;
+            char * d = reinterpret_cast<char *>(dest);
+            char const * s = reinterpret_cast<char const *>(src);
+            for(std::size_t k=0; k<blocks; ++k, d += 16, s += 16)
+            {
+                _mm_stream_si128(reinterpret_cast<__m128i *>(d),
+                                 _mm_load_si128(reinterpret_cast<__m128i const *>(s)));
+            }
+            std::memcpy(d, s, bytes - 16*blocks);
+#else
+            std::copy(src, src+size, dest);
+#endif
+        }
+
+        inline void streaming_store_fence()
+        {
+#ifdef XVIGRA_HAS_STREAMING_STORE
+            _mm_sfence();
+#endif
+        }
+
+        template <class T>
+        void streaming_fill_part(T * dest, index_t size, T value)
+        {
+            index_t head = streaming_store_head(dest, size);
+            std::fill(dest, dest+head, value);
+#ifdef XVIGRA_HAS_STREAMING_STORE
+            if(16 % sizeof(T) == 0)
+            {
+                alignas(16) T pattern[16 / sizeof(T)];
+                std::fill(pattern, pattern + 16 / sizeof(T), value);
+                __m128i p = _mm_load_si128(reinterpret_cast<__m128i const *>(pattern));
+                index_t step = 16 / sizeof(T),
+                        k = head;
+                for(; k + step <= size; k += step)
+                {
+                    _mm_stream_si128(reinterpret_cast<__m128i *>(dest+k), p);
+                }
+                std::fill(dest+k, dest+size, value);
+                _mm_sfence();
+                return;
+            }
+#endif
+            std::fill(dest+head, dest+size, value);
+        }
+
+            // 'reader(buffer, count)' must write the next 'count' source elements to 'buffer'
+        template <class T, class READER>
+        void streaming_assign_part(T * dest, index_t size, READER & reader)
+        {
+            constexpr index_t chunk = 4096 / sizeof(T);
+            alignas(64) T buffer[chunk];
+
+            index_t head = streaming_store_head(dest, size);
+            reader(dest, head);
+            for(index_t k=head; k<size; k+=chunk)
+            {
+                index_t count = std::min(chunk, size-k);
+                reader(buffer, count);
+                stream_copy_aligned(dest+k, buffer, count);
+            }
+            streaming_store_fence();
+        }
+
+            // call 'f(begin, end)' for 'thread_count' contiguous parts of [0, size)
+        template <class F>
+        void streaming_store_parallel(index_t size, F && f)
+        {
+            index_t thread_count = std::max<index_t>(1,
+                                       std::min<index_t>(default_streaming_store_options().thread_count,
+                                                         size / 4096));
+            if(thread_count == 1)
+            {
+                f(index_t(0), size);
+                return;
+            }
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count-1);
+            for(index_t k=1; k<thread_count; ++k)
+            {
+                threads.emplace_back(f, k*size / thread_count, (k+1)*size / thread_count);
+            }
+            f(index_t(0), size / thread_count);
+            for(auto & t: threads)
+            {
+                t.join();
+            }
+        }
+
+        template <class T, class U>
+        struct streaming_pointer_reader
+        {
+            U const * src;
+
+            void operator()(T * dest, index_t count)
+            {
+                for(index_t k=0; k<count; ++k)
+                {
+                    dest[k] = static_cast<T>(src[k]);
+                }
+                src += count;
+            }
+        };
+
+        template <class T, class ITER>
+        struct streaming_iterator_reader
+        {
+            ITER iter;
+
+            void operator()(T * dest, index_t count)
+            {
+                for(index_t k=0; k<count; ++k, ++iter)
+                {
+                    dest[k] = static_cast<T>(*iter);
+                }
+            }
+        };
+
+            // fill contiguous memory with 'value' using non-temporal stores
+        template <class T>
+        void streaming_fill(T * dest, index_t size, T value)
+        {
+            streaming_store_parallel(size,
+                [dest, value](index_t begin, index_t end)
+                {
+                    streaming_fill_part(dest+begin, end-begin, value);
+                });
+        }
+
+            // copy contiguous memory using non-temporal stores
+        template <class T, class U>
+        void streaming_copy(T * dest, U const * src, index_t size)
+        {
+            streaming_store_parallel(size,
+                [dest, src](index_t begin, index_t end)
+                {
+                    streaming_pointer_reader<T, U> reader{src+begin};
+                    streaming_assign_part(dest+begin, end-begin, reader);
+                });
+        }
+
+            // assign an expression of the same shape to contiguous c-order memory
+            // using non-temporal stores
+        template <class T, class E>
+        void streaming_assign(T * dest, index_t size, E const & e)
+        {
+            streaming_store_parallel(size,
+                [dest, &e](index_t begin, index_t end)
+                {
+                    auto iter = e.template cbegin<xt::layout_type::row_major>();
+                    iter += begin;
+                    streaming_iterator_reader<T, decltype(iter)> reader{iter};
+                    streaming_assign_part(dest+begin, end-begin, reader);
+                });
+        }
+
+        template <class S1, class S2>
+        inline bool is_c_order_contiguous(S1 const & shape, S2 const & strides)
+        {
+            index_t stride = 1;
+            for(index_t k=(index_t)shape.size()-1; k>=0; --k)
+            {
+                if(shape[k] != 1 && (index_t)strides[k] != stride)
+                {
+                    return false;
+                }
+                stride *= shape[k];
+            }
+            return true;
+        }
+
+        template <class S1, class S2>
+        inline bool is_same_shape(S1 const & s1, S2 const & s2)
+        {
+            return s1.size() == s2.size() && std::equal(s1.begin(), s1.end(), s2.begin(),
+                [](auto l, auto r) { return (index_t)l == (index_t)r; });
+        }
+
+            // entry points for view_nd: return false when the ordinary path must be used
+        template <class T>
+        inline bool try_streaming_fill(std::false_type, T *, index_t, T const &)
+        {
+            return false;
+        }
+
+        template <class T>
+        inline bool try_streaming_fill(std::true_type, T * dest, index_t size, T const & value)
+        {
+            if(!use_streaming_store<T>(size))
+            {
+                return false;
+            }
+            streaming_fill(dest, size, value);
+            return true;
+        }
+
+        template <class T, class E>
+        inline bool try_streaming_assign(std::false_type, T *, index_t, E const &)
+        {
+            return false;
+        }
+
+            // 'dest' must be contiguous in c-order, and 'e' must not overlap with 'dest'
+        template <class T, class E>
+        inline bool try_streaming_assign(std::true_type, T * dest, index_t size, E const & e)
+        {
+            if(!use_streaming_store<T>(size))
+            {
+                return false;
+            }
+            streaming_assign(dest, size, e);
+            return true;
+        }
+
+        template <class T, class U, index_t N>
+        inline bool try_streaming_assign(std::true_type, T * dest, index_t size, view_nd<U, N> const & v)
+        {
+            if(!use_streaming_store<T>(size))
+            {
+                return false;
+            }
+            if(is_c_order_contiguous(v.shape(), v.strides()))
+            {
+                streaming_copy(dest, v.raw_data(), size);
+            }
+            else
+            {
+                streaming_assign(dest, size, v);
+            }
+            return true;
+        }
+
+        template <class T, class U, index_t N, class A>
+        inline bool try_streaming_assign(std::true_type, T * dest, index_t size, array_nd<U, N, A> const & a)
+        {
+            return try_streaming_assign(std::true_type(), dest, size, static_cast<view_nd<U, N> const &>(a));
+        }
+    } // namespace detail
+
+} // namespace xvigra
+
+#endif // XVIGRA_STREAMING_STORE_HPP
@@ -0,0 +1,722 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_TENSOR_FEATURES_HPP
+#define XVIGRA_TENSOR_FEATURES_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "global.hpp"
+#include "tiny_vector.hpp"
+#include "array_nd.hpp"
+#include "functor_base.hpp"
+#include "kernel.hpp"
+#include "kernel_cache.hpp"
+#include "separable_convolution.hpp"
+
+#ifdef XVIGRA_USE_SIMD
+#include <xsimd/xsimd.hpp>
+#endif
+
+namespace xvigra
+{
+        /** \brief Number of elements per tile in the tensor feature functors.
+
+            The functors process the data in slabs along axis 0 that hold about this
+            many elements (plus an overlap for the filters), so that their temporaries
+            stay small regardless of the array size.
+        */
+    inline index_t & default_tensor_feature_tile_size()
+    {
+        static index_t size = index_t(1) << 18;
+        return size;
+    }
+
+    /*************************/
+    /* symmetric_eigenvalues */
+    /*************************/
+
+        /** \brief Eigenvalues of a symmetric 2x2 matrix in closed form.
+
+            The matrix is given by its upper triangle <tt>(a00, a01, a11)</tt>.
+            The eigenvalues are returned in descending order. <tt>V</tt> may be a
+            scalar type or an <tt>xsimd</tt> batch, so that several matrices are
+            processed at once.
+        */
+    template <class V>
+    inline void
+    symmetric_eigenvalues_2x2(V const & a00, V const & a01, V const & a11,
+                              V & ev0, V & ev1)
+    {
+        using std::sqrt;
+
+        V mean   = (a00 + a11) * V(0.5),
+          diff   = (a00 - a11) * V(0.5),
+          radius = sqrt(diff*diff + a01*a01);
+        ev0 = mean + radius;
+        ev1 = mean - radius;
+    }
+
+        /** \brief Eigenvalues of a symmetric 3x3 matrix in closed form.
+
+            The matrix is given by its upper triangle <tt>(a00, a01, a02, a11, a12, a22)</tt>.
+            The eigenvalues are returned in descending order. The computation uses the
+            trigonometric solution of the characteristic polynomial (Smith, 1961) and
+            contains no branches, so that <tt>V</tt> may be a scalar type or an
+            <tt>xsimd</tt> batch.
+        */
+    template <class V>
+    inline void
+    symmetric_eigenvalues_3x3(V const & a00, V const & a01, V const & a02,
+                              V const & a11, V const & a12, V const & a22,
+                              V & ev0, V & ev1, V & ev2)
+    {
+        using std::sqrt;
+        using std::acos;
+        using std::cos;
+        using std::min;
+        using std::max;
+
+        V q   = (a00 + a11 + a22) * V(1.0 / 3.0),
+          b00 = a00 - q,
+          b11 = a11 - q,
+          b22 = a22 - q,
+          p   = sqrt((b00*b00 + b11*b11 + b22*b22 + V(2.0)*(a01*a01 + a02*a02 + a12*a12)) * V(1.0 / 6.0)),
+          det = b00*(b11*b22 - a12*a12) - a01*(a01*b22 - a12*a02) + a02*(a01*a12 - b11*a02);
+        // r = det((A - q*I) / p) / 2, guarding against p == 0 (multiples of the identity)
+        V r   = det / max(V(2.0)*p*p*p, V(std::numeric_limits<float>::min())),
+          phi = acos(min(max(r, V(-1.0)), V(1.0))) * V(1.0 / 3.0);
+        ev0 = q + V(2.0)*p*cos(phi);
+        ev2 = q + V(2.0)*p*cos(phi + V(2.0943951023931957)); // 2*pi/3
+        ev1 = V(3.0)*q - ev0 - ev2;
+    }
+
+        /** \brief Eigenvalues of a symmetric 2x2 matrix given as <tt>(a00, a01, a11)</tt>,
+            in descending order.
+        */
+    template <class T>
+    inline tiny_vector<T, 2>
+    symmetric_eigenvalues(tiny_vector<T, 3> const & tensor)
+    {
+        tiny_vector<T, 2> res;
+        symmetric_eigenvalues_2x2(tensor[0], tensor[1], tensor[2], res[0], res[1]);
+        return res;
+    }
+
+        /** \brief Eigenvalues of a symmetric 3x3 matrix given as <tt>(a00, a01, a02, a11, a12, a22)</tt>,
+            in descending order.
+        */
+    template <class T>
+    inline tiny_vector<T, 3>
+    symmetric_eigenvalues(tiny_vector<T, 6> const & tensor)
+    {
+        tiny_vector<T, 3> res;
+        symmetric_eigenvalues_3x3(tensor[0], tensor[1], tensor[2], tensor[3], tensor[4], tensor[5],
+                                  res[0], res[1], res[2]);
+        return res;
+    }
+
+    namespace detail
+    {
+        template <class T>
+        struct tensor_use_simd
+#ifdef XVIGRA_USE_SIMD
+        : public std::integral_constant<bool, std::is_same<T, float>::value || std::is_same<T, double>::value>
+#else
+        : public std::false_type
+#endif
+        {};
+
+        // Compute the eigenvalues of as many matrices as fit into complete SIMD batches
+        // and return the number of processed matrices. The upper triangles are stored
+        // component-wise in 'tensor[0...n*(n+1)/2-1]', the eigenvalues go to 'ev[0...n-1]'.
+        template <class T>
+        inline index_t
+        symmetric_eigenvalues_simd_loop(T const * const * tensor, index_t n, index_t size,
+                                        T * const * ev, std::true_type)
+        {
+#ifdef XVIGRA_USE_SIMD
+            using batch_type = decltype(xsimd::set_simd(T()));
+            constexpr index_t simd_size = xsimd::simd_batch_traits<batch_type>::size;
+
+            index_t simd_end = size - size % simd_size;
+            if(n == 2)
+            {
+                for(index_t j=0; j<simd_end; j += simd_size)
+                {
+                    batch_type e0, e1;
+                    symmetric_eigenvalues_2x2(
+                        batch_type(xsimd::load_unaligned(tensor[0] + j)),
+                        batch_type(xsimd::load_unaligned(tensor[1] + j)),
+                        batch_type(xsimd::load_unaligned(tensor[2] + j)),
+                        e0, e1);
+                    e0.store_unaligned(ev[0] + j);
+                    e1.store_unaligned(ev[1] + j);
+                }
+            }
+            else
+            {
+                for(index_t j=0; j<simd_end; j += simd_size)
+                {
+                    batch_type e0, e1, e2;
+                    symmetric_eigenvalues_3x3(
+                        batch_type(xsimd::load_unaligned(tensor[0] + j)),
+                        batch_type(xsimd::load_unaligned(tensor[1] + j)),
+                        batch_type(xsimd::load_unaligned(tensor[2] + j)),
+                        batch_type(xsimd::load_unaligned(tensor[3] + j)),
+                        batch_type(xsimd::load_unaligned(tensor[4] + j)),
+                        batch_type(xsimd::load_unaligned(tensor[5] + j)),
+                        e0, e1, e2);
+                    e0.store_unaligned(ev[0] + j);
+                    e1.store_unaligned(ev[1] + j);
+                    e2.store_unaligned(ev[2] + j);
+                }
+            }
+            return simd_end;
+#else
+            return 0;
+#endif
+        }
+
+        template <class T>
+        inline index_t
+        symmetric_eigenvalues_simd_loop(T const * const *, index_t, index_t, T * const *, std::false_type)
+        {
+            return 0;
+        }
+
+        template <class T>
+        inline void
+        symmetric_eigenvalues_soa(T const * const * tensor, index_t n, index_t size, T * const * ev)
+        {
+            index_t j = symmetric_eigenvalues_simd_loop(tensor, n, size, ev, tensor_use_simd<T>());
+            if(n == 2)
+            {
+                for(; j<size; ++j)
+                {
+                    symmetric_eigenvalues_2x2(tensor[0][j], tensor[1][j], tensor[2][j],
+                                              ev[0][j], ev[1][j]);
+                }
+            }
+            else
+            {
+                for(; j<size; ++j)
+                {
+                    symmetric_eigenvalues_3x3(tensor[0][j], tensor[1][j], tensor[2][j],
+                                              tensor[3][j], tensor[4][j], tensor[5][j],
+                                              ev[0][j], ev[1][j], ev[2][j]);
+                }
+            }
+        }
+
+        // Transpose the contiguous component arrays 'tensor + c*component_stride'
+        // (each of length 'size') into the eigenvalues of 'out', in chunks that stay
+        // in the L1 cache.
+        template <class T, class T2, index_t M, index_t N>
+        inline void
+        tensor_eigenvalues_to_output(T const * tensor, index_t component_stride, index_t n, index_t size,
+                                     view_nd<tiny_vector<T2, M>, N> out)
+        {
+            constexpr index_t chunk_size = 256;
+            T buffer[3][chunk_size];
+            T * ev[3] = { buffer[0], buffer[1], buffer[2] };
+            T const * components[6];
+
+            auto iter = out.begin();
+            for(index_t k=0; k<size; k += chunk_size)
+            {
+                index_t count = std::min(chunk_size, size - k);
+                for(index_t c=0; c<n*(n+1)/2; ++c)
+                {
+                    components[c] = tensor + c*component_stride + k;
+                }
+                symmetric_eigenvalues_soa(components, n, count, ev);
+                for(index_t j=0; j<count; ++j, ++iter)
+                {
+                    for(index_t c=0; c<n; ++c)
+                    {
+                        (*iter)[c] = static_cast<T2>(ev[c][j]);
+                    }
+                }
+            }
+        }
+
+        // Copy a contiguous scalar array into component 'c' of 'out'.
+        template <class T, class T2, index_t M, index_t N>
+        inline void
+        tensor_component_to_output(T const * src, index_t c, view_nd<tiny_vector<T2, M>, N> out)
+        {
+            for(auto & v: out)
+            {
+                v[c] = static_cast<T2>(*src++);
+            }
+        }
+
+        // One kernel per axis: the Gaussian derivative of the given order,
+        // or the smoothing Gaussian when the order is zero.
+        template <class T>
+        inline std::vector<kernel_1d<T>>
+        gaussian_derivative_kernels(double sigma, shape_t<> const & orders)
+        {
+            std::vector<kernel_1d<T>> kernels;
+            for(auto order: orders)
+            {
+                if(order == 0)
+                {
+                    kernels.push_back(*cached_gaussian_kernel_1d<T>(sigma));
+                }
+                else
+                {
+                    kernels.push_back(*cached_gaussian_derivative_kernel_1d<T>(sigma, order));
+                }
+            }
+            return kernels;
+        }
+
+        template <class T2, index_t M, class T1, index_t N1, index_t N2>
+        inline void
+        check_tensor_feature_shapes(std::string const & name,
+                                    view_nd<T1, N1> const & in, view_nd<tiny_vector<T2, M>, N2> const & out,
+                                    index_t components)
+        {
+            index_t n = in.dimension();
+            vigra_precondition(n == 2 || n == 3,
+                name + "(): only implemented for 2D and 3D data.");
+            vigra_precondition(in.shape() == out.shape(),
+                name + "(): shape mismatch between input and output.");
+            vigra_precondition(M == components,
+                name + "(): output value_type has the wrong number of components.");
+        }
+
+        template <class T>
+        inline index_t
+        kernel_radius(kernel_1d<T> const & kernel)
+        {
+            return std::max(kernel.center(), (index_t)kernel.size() - 1 - kernel.center());
+        }
+
+        // rows [b, e) of 'v'
+        template <class T, index_t N>
+        inline view_nd<T, N>
+        axis0_range(view_nd<T, N> const & v, index_t b, index_t e)
+        {
+            shape_t<N> begin(v.dimension(), 0), end(v.shape());
+            begin[0] = b;
+            end[0] = e;
+            return v.subarray(begin, end);
+        }
+
+        // Process 'in' in slabs along axis 0 with about default_tensor_feature_tile_size()
+        // elements. Each slab is enlarged by 'halo' rows on both sides where possible, so
+        // that filters with a total radius up to 'halo' are exact in the slab's core.
+        // Cores have at least 8*halo rows, so that the overlap adds at most 25% to the
+        // work, and arrays that fit into one tile are processed as a whole.
+        // 'f(slab, core_begin, core_end, out_begin)' gets the core rows relative to the
+        // slab and the first core row relative to 'in'.
+        template <class T1, index_t N1, class F>
+        inline void
+        for_each_tensor_feature_tile(view_nd<T1, N1> const & in, index_t halo, F && f)
+        {
+            index_t rows = in.shape(0),
+                    row_size = rows > 0
+                                   ? in.size() / rows
+                                   : 0;
+            if(row_size == 0)
+            {
+                return;
+            }
+            index_t min_core = std::max(std::max(default_tensor_feature_tile_size() / row_size, 8*halo),
+                                        index_t(1));
+            index_t slabs = (index_t)in.size() <= default_tensor_feature_tile_size()
+                                ? 1
+                                : std::max(rows / min_core, index_t(1));
+            // distribute the rows evenly, so that every core has at least 'min_core' rows
+            for(index_t k=0; k<slabs; ++k)
+            {
+                index_t b = k*rows / slabs,
+                        e = (k+1)*rows / slabs,
+                        slab_begin = std::max(b - halo, index_t(0)),
+                        slab_end = std::min(e + halo, rows);
+                f(axis0_range(in, slab_begin, slab_end), b - slab_begin, e - slab_begin, b);
+            }
+        }
+
+        // rows needed on each side of a slab for an exact structure tensor in its core
+        template <class T>
+        inline index_t
+        structure_tensor_halo(double inner_scale, double outer_scale)
+        {
+            return std::max(kernel_radius(*cached_gaussian_kernel_1d<T>(inner_scale)),
+                            kernel_radius(*cached_gaussian_derivative_kernel_1d<T>(inner_scale, 1))) +
+                   kernel_radius(*cached_gaussian_kernel_1d<T>(outer_scale));
+        }
+
+        // rows needed on each side of a slab for an exact Hessian in its core
+        template <class T>
+        inline index_t
+        hessian_halo(double scale)
+        {
+            return std::max(kernel_radius(*cached_gaussian_kernel_1d<T>(scale)),
+                            std::max(kernel_radius(*cached_gaussian_derivative_kernel_1d<T>(scale, 1)),
+                                     kernel_radius(*cached_gaussian_derivative_kernel_1d<T>(scale, 2))));
+        }
+
+        // Compute the Gaussian gradient of 'in' into the contiguous component arrays
+        // 'gradient[d*size...(d+1)*size-1]'.
+        template <class T, class T1, index_t N1>
+        inline void
+        gaussian_gradient_components(view_nd<T1, N1> const & in, T * gradient, double scale,
+                                     convolution_options const & options)
+        {
+            index_t n = in.dimension(), size = in.size();
+            shape_t<> shape(in.shape());
+            for(index_t d=0; d<n; ++d)
+            {
+                shape_t<> orders(n, 0);
+                orders[d] = 1;
+                separable_convolution(in, view_nd<T>(shape, gradient + d*size),
+                                      gaussian_derivative_kernels<T>(scale, orders), options);
+            }
+        }
+
+        // Smooth the outer product of the gradient component by component. Each product
+        // is passed to separable_convolution() as a lazy expression, which is evaluated
+        // line by line in the innermost pass, so that no product array is formed.
+        // Upper triangle component 'c' is written to 'dest + c*dest_stride', and
+        // 'finish(c, ptr)' is called afterwards.
+        template <class T, class F>
+        inline void
+        smoothed_outer_product(T * gradient, shape_t<> const & shape, double scale,
+                               convolution_options const & options,
+                               T * dest, index_t dest_stride, F && finish)
+        {
+            index_t n = shape.size(), size = prod(shape);
+            auto kernel = cached_gaussian_kernel_1d<T>(scale);
+            for(index_t i=0, c=0; i<n; ++i)
+            {
+                for(index_t j=i; j<n; ++j, ++c)
+                {
+                    view_nd<T> gi(shape, gradient + i*size),
+                               gj(shape, gradient + j*size);
+                    T * res = dest + c*dest_stride;
+                    separable_convolution(gi*gj, view_nd<T>(shape, res), *kernel, options);
+                    finish(c, res);
+                }
+            }
+        }
+
+        // Compute the Hessian of Gaussian component by component. Upper triangle
+        // component 'c' is written to 'dest + c*dest_stride', and 'finish(c, ptr)'
+        // is called afterwards.
+        template <class T, class T1, index_t N1, class F>
+        inline void
+        hessian_components(view_nd<T1, N1> const & in, double scale,
+                           convolution_options const & options,
+                           T * dest, index_t dest_stride, F && finish)
+        {
+            index_t n = in.dimension();
+            shape_t<> shape(in.shape());
+            for(index_t i=0, c=0; i<n; ++i)
+            {
+                for(index_t j=i; j<n; ++j, ++c)
+                {
+                    shape_t<> orders(n, 0);
+                    orders[i] += 1;
+                    orders[j] += 1;
+                    T * res = dest + c*dest_stride;
+                    separable_convolution(in, view_nd<T>(shape, res),
+                                          gaussian_derivative_kernels<T>(scale, orders), options);
+                    finish(c, res);
+                }
+            }
+        }
+    } // namespace detail
+
+    /****************************/
+    /* structure_tensor_functor */
+    /****************************/
+
+        /** \brief Structure tensor of a scalar 2D or 3D array.
+
+            The gradient is computed with first derivatives of a Gaussian at
+            <tt>inner_scale</tt>, and the upper triangle of its outer product is
+            smoothed with a Gaussian at <tt>outer_scale</tt>. The output value_type must
+            be <tt>tiny_vector<T, 3></tt> in 2D (order <tt>xx, xy, yy</tt>) and
+            <tt>tiny_vector<T, 6></tt> in 3D (order <tt>xx, xy, xz, yy, yz, zz</tt>),
+            where <tt>x</tt> refers to axis 0.
+
+            The products of gradient components are streamed into the smoothing as lazy
+            expressions. The data are processed in overlapping slabs along axis 0 (see
+            <tt>default_tensor_feature_tile_size()</tt>), so that the gradient and one
+            smoothed component are the only temporaries, each the size of a slab.
+            All kernels are taken from the <tt>default_kernel_cache()</tt>.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 2> image(...);
+            array_nd<tiny_vector<float, 3>, 2> tensor(image.shape());
+            structure_tensor(image, tensor, 1.0, 3.0);
+            \endcode
+        */
+    struct structure_tensor_functor
+    : public functor_base<structure_tensor_functor>
+    {
+        std::string name = "structure_tensor";
+
+        template <class T1, index_t N1, class T2, index_t M, index_t N2>
+        void impl(view_nd<T1, N1> const & in, view_nd<tiny_vector<T2, M>, N2> out,
+                  double inner_scale, double outer_scale,
+                  convolution_options const & options = convolution_options()) const
+        {
+            using real_type = real_promote_type_t<T2>;
+
+            index_t n = in.dimension();
+            detail::check_tensor_feature_shapes(name, in, out, n*(n+1)/2);
+
+            detail::for_each_tensor_feature_tile(in, detail::structure_tensor_halo<real_type>(inner_scale, outer_scale),
+                [&](auto const & slab, index_t core_begin, index_t core_end, index_t out_begin)
+                {
+                    shape_t<> shape(slab.shape());
+                    index_t size = slab.size(),
+                            row_size = size / shape[0];
+                    auto core = detail::axis0_range(out, out_begin, out_begin + core_end - core_begin);
+
+                    std::vector<real_type, XVIGRA_TEMPORARY_ALLOCATOR(real_type)> gradient(n*size), smoothed(size);
+                    detail::gaussian_gradient_components(slab, gradient.data(), inner_scale, options);
+                    detail::smoothed_outer_product(gradient.data(), shape, outer_scale, options,
+                                                   smoothed.data(), 0,
+                        [&](index_t c, real_type const * res)
+                        {
+                            detail::tensor_component_to_output(res + core_begin*row_size, c, core);
+                        });
+                });
+        }
+    };
+
+    namespace
+    {
+        structure_tensor_functor  structure_tensor;
+
+        inline void structure_tensor_dummy()
+        {
+            std::ignore = structure_tensor;
+        }
+    }
+
+    /****************************************/
+    /* structure_tensor_eigenvalues_functor */
+    /****************************************/
+
+        /** \brief Eigenvalues of the structure tensor of a scalar 2D or 3D array.
+
+            Equivalent to <tt>structure_tensor()</tt> followed by <tt>symmetric_eigenvalues()</tt>
+            at every pixel, but the tensor is never stored as an array of <tt>tiny_vector</tt>.
+            Instead, the data are processed in overlapping slabs along axis 0 (see
+            <tt>default_tensor_feature_tile_size()</tt>). The smoothed components of a slab
+            are kept in separate planes, and the closed-form eigenvalue solver runs over
+            these planes in SIMD batches when <tt>XVIGRA_USE_SIMD</tt> is defined.
+            The output value_type must be <tt>tiny_vector<T, N></tt>, and the
+            eigenvalues are sorted in descending order.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> volume(...);
+            array_nd<tiny_vector<float, 3>, 3> ev(volume.shape());
+            structure_tensor_eigenvalues(volume, ev, 1.0, 3.0);
+            \endcode
+        */
+    struct structure_tensor_eigenvalues_functor
+    : public functor_base<structure_tensor_eigenvalues_functor>
+    {
+        std::string name = "structure_tensor_eigenvalues";
+
+        template <class T1, index_t N1, class T2, index_t M, index_t N2>
+        void impl(view_nd<T1, N1> const & in, view_nd<tiny_vector<T2, M>, N2> out,
+                  double inner_scale, double outer_scale,
+                  convolution_options const & options = convolution_options()) const
+        {
+            using real_type = real_promote_type_t<T2>;
+
+            index_t n = in.dimension();
+            detail::check_tensor_feature_shapes(name, in, out, n);
+
+            detail::for_each_tensor_feature_tile(in, detail::structure_tensor_halo<real_type>(inner_scale, outer_scale),
+                [&](auto const & slab, index_t core_begin, index_t core_end, index_t out_begin)
+                {
+                    shape_t<> shape(slab.shape());
+                    index_t size = slab.size(),
+                            row_size = size / shape[0];
+
+                    std::vector<real_type, XVIGRA_TEMPORARY_ALLOCATOR(real_type)> gradient(n*size), tensor(n*(n+1)/2*size);
+                    detail::gaussian_gradient_components(slab, gradient.data(), inner_scale, options);
+                    detail::smoothed_outer_product(gradient.data(), shape, outer_scale, options,
+                                                   tensor.data(), size,
+                        [](index_t, real_type const *) {});
+                    detail::tensor_eigenvalues_to_output(tensor.data() + core_begin*row_size, size, n,
+                                                         (core_end - core_begin)*row_size,
+                                                         detail::axis0_range(out, out_begin, out_begin + core_end - core_begin));
+                });
+        }
+    };
+
+    namespace
+    {
+        structure_tensor_eigenvalues_functor  structure_tensor_eigenvalues;
+
+        inline void structure_tensor_eigenvalues_dummy()
+        {
+            std::ignore = structure_tensor_eigenvalues;
+        }
+    }
+
+    /*******************************/
+    /* hessian_of_gaussian_functor */
+    /*******************************/
+
+        /** \brief Hessian matrix of a scalar 2D or 3D array, computed with second
+            derivatives of a Gaussian at <tt>scale</tt>.
+
+            The output value_type and component order are the same as for
+            <tt>structure_tensor()</tt>. Each component is computed by a single
+            separable convolution into a scalar temporary the size of a slab
+            (see <tt>default_tensor_feature_tile_size()</tt>).
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 2> image(...);
+            array_nd<tiny_vector<float, 3>, 2> hessian(image.shape());
+            hessian_of_gaussian(image, hessian, 2.0);
+            \endcode
+        */
+    struct hessian_of_gaussian_functor
+    : public functor_base<hessian_of_gaussian_functor>
+    {
+        std::string name = "hessian_of_gaussian";
+
+        template <class T1, index_t N1, class T2, index_t M, index_t N2>
+        void impl(view_nd<T1, N1> const & in, view_nd<tiny_vector<T2, M>, N2> out,
+                  double scale,
+                  convolution_options const & options = convolution_options()) const
+        {
+            using real_type = real_promote_type_t<T2>;
+
+            index_t n = in.dimension();
+            detail::check_tensor_feature_shapes(name, in, out, n*(n+1)/2);
+
+            detail::for_each_tensor_feature_tile(in, detail::hessian_halo<real_type>(scale),
+                [&](auto const & slab, index_t core_begin, index_t core_end, index_t out_begin)
+                {
+                    index_t size = slab.size(),
+                            row_size = size / slab.shape(0);
+                    auto core = detail::axis0_range(out, out_begin, out_begin + core_end - core_begin);
+
+                    std::vector<real_type, XVIGRA_TEMPORARY_ALLOCATOR(real_type)> component(size);
+                    detail::hessian_components(slab, scale, options, component.data(), 0,
+                        [&](index_t c, real_type const * res)
+                        {
+                            detail::tensor_component_to_output(res + core_begin*row_size, c, core);
+                        });
+                });
+        }
+    };
+
+    namespace
+    {
+        hessian_of_gaussian_functor  hessian_of_gaussian;
+
+        inline void hessian_of_gaussian_dummy()
+        {
+            std::ignore = hessian_of_gaussian;
+        }
+    }
+
+    /*******************************/
+    /* hessian_eigenvalues_functor */
+    /*******************************/
+
+        /** \brief Eigenvalues of the Hessian of Gaussian of a scalar 2D or 3D array.
+
+            Like <tt>structure_tensor_eigenvalues()</tt>, the data are processed in slabs,
+            whose Hessian components are kept in separate planes and passed to the
+            closed-form eigenvalue solver chunk by chunk. The output value_type must be
+            <tt>tiny_vector<T, N></tt>, and the eigenvalues are sorted in descending order.
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 2> image(...);
+            array_nd<tiny_vector<float, 2>, 2> ev(image.shape());
+            hessian_eigenvalues(image, ev, 2.0);
+            \endcode
+        */
+    struct hessian_eigenvalues_functor
+    : public functor_base<hessian_eigenvalues_functor>
+    {
+        std::string name = "hessian_eigenvalues";
+
+        template <class T1, index_t N1, class T2, index_t M, index_t N2>
+        void impl(view_nd<T1, N1> const & in, view_nd<tiny_vector<T2, M>, N2> out,
+                  double scale,
+                  convolution_options const & options = convolution_options()) const
+        {
+            using real_type = real_promote_type_t<T2>;
+
+            index_t n = in.dimension();
+            detail::check_tensor_feature_shapes(name, in, out, n);
+
+            detail::for_each_tensor_feature_tile(in, detail::hessian_halo<real_type>(scale),
+                [&](auto const & slab, index_t core_begin, index_t core_end, index_t out_begin)
+                {
+                    index_t size = slab.size(),
+                            row_size = size / slab.shape(0);
+
+                    std::vector<real_type, XVIGRA_TEMPORARY_ALLOCATOR(real_type)> tensor(n*(n+1)/2*size);
+                    detail::hessian_components(slab, scale, options, tensor.data(), size,
+                        [](index_t, real_type const *) {});
+                    detail::tensor_eigenvalues_to_output(tensor.data() + core_begin*row_size, size, n,
+                                                         (core_end - core_begin)*row_size,
+                                                         detail::axis0_range(out, out_begin, out_begin + core_end - core_begin));
+                });
+        }
+    };
+
+    namespace
+    {
+        hessian_eigenvalues_functor  hessian_eigenvalues;
+
+        inline void hessian_eigenvalues_dummy()
+        {
+            std::ignore = hessian_eigenvalues;
+        }
+    }
+} // namespace xvigra
+
+#endif // XVIGRA_TENSOR_FEATURES_HPP
@@ -32,9 +32,15 @@
 #define XVIGRA_TINY_VECTOR_HPP
 
 #include <algorithm>
+#include <cstdint>
 #include <xtensor/xbuffer_adaptor.hpp>
 
+#ifdef XVIGRA_USE_SIMD
+#  include <xsimd/xsimd.hpp>
+#endif
+
 #include "global.hpp"
+#include "allocation_counter.hpp"
 #include "error.hpp"
 #include "concepts.hpp"
 #include "math.hpp"
@@ -189,9 +195,9 @@ namespace xvigra
 
     template <class VALUETYPE>
     class tiny_vector_impl<VALUETYPE, runtime_size, void>
-    : public tiny_vector_impl<VALUETYPE, runtime_size, VALUETYPE[4]>
+    : public tiny_vector_impl<VALUETYPE, runtime_size, VALUETYPE[XVIGRA_SHAPE_BUFFER_SIZE]>
     {
-        using base_type = tiny_vector_impl<VALUETYPE, runtime_size, VALUETYPE[4]>;
+        using base_type = tiny_vector_impl<VALUETYPE, runtime_size, VALUETYPE[XVIGRA_SHAPE_BUFFER_SIZE]>;
       public:
         using base_type::base_type;
     };
@@ -1651,6 +1657,7 @@ namespace xvigra
         if(m_size > buffer_size)
         {
             m_data = m_allocator.allocate(m_size);
+            detail::count_tiny_vector_allocation(m_size*sizeof(value_type));
             std::uninitialized_fill(m_data, m_data+m_size, v);
         }
         else
@@ -1666,6 +1673,7 @@ namespace xvigra
         if(m_size > buffer_size)
         {
             m_data = m_allocator.allocate(m_size);
+            detail::count_tiny_vector_allocation(m_size*sizeof(value_type));
             if(!may_use_uninitialized_memory)
             {
                 std::uninitialized_fill(m_data, m_data+m_size, value_type());
@@ -1681,6 +1689,7 @@ namespace xvigra
         if(m_size > buffer_size)
         {
             m_data = m_allocator.allocate(m_size);
+            detail::count_tiny_vector_allocation(m_size*sizeof(value_type));
             for(size_type k=0; k<m_size; ++k, ++begin)
             {
                 m_allocator.construct(m_data+k, static_cast<value_type>(*begin));
@@ -2356,9 +2365,292 @@ namespace xvigra
             static const index_t value  = runtime_size;
             static const bool valid = true;
         };
+
+            // Fixed-size vectors of float, double and int32_t with up to 8 elements
+            // are processed in SIMD registers when XVIGRA_USE_SIMD is defined.
+            // The storage is not padded, so that arrays of tiny_vector remain densely
+            // interleaved. Instead, the largest batch that fits into the vector is
+            // loaded unaligned, and the remaining elements use scalar code.
+        template <class T>
+        struct simd_value_type
+        : public std::integral_constant<bool, std::is_same<T, float>::value ||
+                                              std::is_same<T, double>::value ||
+                                              std::is_same<T, int32_t>::value>
+        {};
+
+            // number of elements per SIMD batch (0 if the vector is too short)
+        template <class T, index_t N, bool SIMD=simd_value_type<T>::value>
+        struct simd_width
+        {
+            static constexpr index_t value = 0;
+        };
+
+    #ifdef XVIGRA_USE_SIMD
+        template <class T, index_t N>
+        struct simd_width<T, N, true>
+        {
+            static constexpr index_t max_width =
+                xsimd::simd_batch_traits<decltype(xsimd::set_simd(T()))>::size;
+            static constexpr index_t min_width = 16 / (index_t)sizeof(T);
+            static constexpr index_t limit = N < max_width ? N : max_width;
+            static constexpr index_t value = limit >= 8 && 8 >= min_width
+                                                 ? 8
+                                                 : limit >= 4 && 4 >= min_width
+                                                      ? 4
+                                                      : limit >= 2 && 2 >= min_width
+                                                           ? 2
+                                                           : 0;
+        };
+    #endif
+
+        template <class T>
+        struct simd_tiny_vector
+        : public std::false_type
+        {};
+
+        template <class V, index_t N, class R>
+        struct simd_tiny_vector<tiny_vector<V, N, R>>
+        : public std::integral_constant<bool,
+                     simd_value_type<V>::value && 2 <= N && N <= 8 &&
+                     (std::is_same<R, void>::value ||
+                      std::is_same<R, std::array<V, (size_t)N>>::value)>
+        {};
+
+            // an operand is either a vector of the same kind as the result, or a scalar
+        template <class T, class RES,
+                  bool IS_VECTOR=tiny_vector_concept<T>::value>
+        struct simd_operand
+        : public std::integral_constant<bool,
+                     simd_tiny_vector<T>::value &&
+                     std::is_same<typename T::value_type, typename RES::value_type>::value &&
+                     T::static_size == RES::static_size>
+        {};
+
+        template <class T, class RES>
+        struct simd_operand<T, RES, false>
+        : public std::is_same<T, typename RES::value_type>
+        {};
+
+        template <class F, class RES, class L, class R>
+        struct simd_elementwise_enabled
+        : public std::integral_constant<bool,
+                     simd_tiny_vector<RES>::value &&
+                     simd_width<typename RES::value_type, RES::static_size>::value > 0 &&
+                     F::template simd<typename RES::value_type>::value &&
+                     simd_operand<L, RES>::value && simd_operand<R, RES>::value>
+        {};
+
+        template <class F, class RES, class L, class R>
+        inline bool
+        simd_elementwise_impl(RES &, L const &, R const &, F, std::false_type)
+        {
+            return false;
+        }
+
+    #ifdef XVIGRA_USE_SIMD
+        template <class B, class V, index_t N, class R>
+        inline B
+        simd_load(tiny_vector<V, N, R> const & v, index_t k)
+        {
+            B res;
+            res.load_unaligned(v.data() + k);
+            return res;
+        }
+
+        template <class B, class T,
+                  VIGRA_REQUIRE<!tiny_vector_concept<T>::value>>
+        inline B
+        simd_load(T const & v, index_t)
+        {
+            return B(v);
+        }
+
+        template <class V, index_t N, class R>
+        inline V const &
+        scalar_element(tiny_vector<V, N, R> const & v, index_t k)
+        {
+            return v[k];
+        }
+
+        template <class T,
+                  VIGRA_REQUIRE<!tiny_vector_concept<T>::value>>
+        inline T const &
+        scalar_element(T const & v, index_t)
+        {
+            return v;
+        }
+
+        template <class F, class RES, class L, class R>
+        inline bool
+        simd_elementwise_impl(RES & res, L const & l, R const & r, F f, std::true_type)
+        {
+            using value_type = typename RES::value_type;
+            constexpr index_t size = RES::static_size;
+            constexpr index_t width = simd_width<value_type, size>::value;
+            using batch_type = xsimd::batch<value_type, width>;
+
+            index_t k = 0;
+            for(; k + width <= size; k += width)
+            {
+                batch_type b = f(simd_load<batch_type>(l, k), simd_load<batch_type>(r, k));
+                b.store_unaligned(res.data() + k);
+            }
+            for(; k < size; ++k)
+            {
+                res[k] = f(scalar_element(l, k), scalar_element(r, k));
+            }
+            return true;
+        }
+
+            // sum of 'f(l[k], r[k])' over all elements
+        template <class F, class V, index_t N, class R1, class R2>
+        inline V
+        simd_sum(tiny_vector<V, N, R1> const & l, tiny_vector<V, N, R2> const & r, F f)
+        {
+            constexpr index_t width = simd_width<V, N>::value;
+            using batch_type = xsimd::batch<V, width>;
+
+            batch_type acc(V(0));
+            index_t k = 0;
+            for(; k + width <= N; k += width)
+            {
+                acc = acc + f(simd_load<batch_type>(l, k), simd_load<batch_type>(r, k));
+            }
+            V res = xsimd::hadd(acc);
+            for(; k < N; ++k)
+            {
+                res += f(l[k], r[k]);
+            }
+            return res;
+        }
+    #endif
+
+            // Compute 'res[k] = f(l[k], r[k])' in SIMD registers, where 'l' and 'r' are
+            // vectors or scalars. Returns false if the types don't support SIMD, so that
+            // the caller can fall back to its scalar loop.
+        template <class F, class RES, class L, class R>
+        inline bool
+        simd_elementwise(RES & res, L const & l, R const & r, F f)
+        {
+            return simd_elementwise_impl(res, l, r, f,
+                                         simd_elementwise_enabled<F, RES, L, R>());
+        }
+
+        template <class T>
+        struct simd_reduction_enabled
+        : public std::integral_constant<bool,
+                     simd_tiny_vector<T>::value &&
+                     simd_width<typename T::value_type, T::static_size>::value > 0>
+        {};
+
+        template <class RESULT, class F, class L, class R>
+        inline bool
+        simd_reduce_impl(RESULT &, L const &, R const &, F, std::false_type)
+        {
+            return false;
+        }
+
+    #ifdef XVIGRA_USE_SIMD
+        template <class RESULT, class F, class L, class R>
+        inline bool
+        simd_reduce_impl(RESULT & res, L const & l, R const & r, F f, std::true_type)
+        {
+            res = simd_sum(l, r, f);
+            return true;
+        }
+    #endif
+
+            // marks reductions without a SIMD implementation
+        struct no_simd_functor
+        {};
+
+            // Compute the sum of 'f(l[k], r[k])' in SIMD registers when 'l' and 'r' have
+            // the same type and 'RESULT' is their value_type. Returns false otherwise.
+        template <class RESULT, class F, class L, class R>
+        inline bool
+        simd_reduce(RESULT & res, L const & l, R const & r, F f)
+        {
+            return simd_reduce_impl(res, l, r, f,
+                       std::integral_constant<bool,
+                           !std::is_same<F, no_simd_functor>::value &&
+                           simd_reduction_enabled<L>::value &&
+                           std::is_same<L, R>::value &&
+                           std::is_same<RESULT, typename L::value_type>::value>());
+        }
+
+    #define XVIGRA_TINY_FUNCTOR(NAME, OP, SIMD)                 \
+        struct NAME                                             \
+        {                                                       \
+            template <class V>                                  \
+            using simd = std::integral_constant<bool, SIMD>;    \
+                                                                \
+            template <class A, class B>                         \
+            auto operator()(A const & a, B const & b) const     \
+            {                                                   \
+                return a OP b;                                  \
+            }                                                   \
+        };
+
+        XVIGRA_TINY_FUNCTOR(plus_functor, +, true)
+        XVIGRA_TINY_FUNCTOR(minus_functor, -, true)
+        XVIGRA_TINY_FUNCTOR(multiplies_functor, *, true)
+        XVIGRA_TINY_FUNCTOR(divides_functor, /, std::is_floating_point<V>::value)
+        XVIGRA_TINY_FUNCTOR(modulus_functor, %, false)
+        XVIGRA_TINY_FUNCTOR(bit_and_functor, &, false)
+        XVIGRA_TINY_FUNCTOR(bit_or_functor, |, false)
+        XVIGRA_TINY_FUNCTOR(bit_xor_functor, ^, false)
+        XVIGRA_TINY_FUNCTOR(left_shift_functor, <<, false)
+        XVIGRA_TINY_FUNCTOR(right_shift_functor, >>, false)
+
+    #undef XVIGRA_TINY_FUNCTOR
+
+        struct min_functor
+        {
+            template <class V>
+            using simd = std::true_type;
+
+            template <class A>
+            A operator()(A const & a, A const & b) const
+            {
+                using std::min;
+                return min(a, b);
+            }
+        };
+
+        struct max_functor
+        {
+            template <class V>
+            using simd = std::true_type;
+
+            template <class A>
+            A operator()(A const & a, A const & b) const
+            {
+                using std::max;
+                return max(a, b);
+            }
+        };
+
+        struct abs_functor
+        {
+            template <class A>
+            A operator()(A const & a, A const &) const
+            {
+                using std::abs;
+                return abs(a);
+            }
+        };
+
+        struct first_functor
+        {
+            template <class A>
+            A operator()(A const & a, A const &) const
+            {
+                return a;
+            }
+        };
     }
 
-    #define XVIGRA_TINYARRAY_OPERATORS(OP)                                                   \
+    #define XVIGRA_TINYARRAY_OPERATORS(OP, FUNCTOR)                                          \
     template <class V1, index_t N1, class R1, class V2,                                      \
               VIGRA_REQUIRE<!tiny_vector_concept<V2>::value &&                               \
                             std::is_convertible<V2, V1>::value> >                            \
@@ -2366,6 +2658,8 @@ namespace xvigra
     operator OP##=(tiny_vector<V1, N1, R1> & l,                                              \
                    V2 r)                                                                     \
     {                                                                                        \
+        if(tiny_detail::simd_elementwise(l, l, r, tiny_detail::FUNCTOR()))                   \
+            return l;                                                                        \
         for(index_t i=0; i<l.size(); ++i)                                                    \
             l[i] OP##= r;                                                                    \
         return l;                                                                            \
@@ -2378,6 +2672,8 @@ namespace xvigra
     {                                                                                        \
         XVIGRA_ASSERT_MSG(l.size() == r.size(),                                              \
             "tiny_vector::operator" #OP "=(): size mismatch.");                              \
+        if(tiny_detail::simd_elementwise(l, l, r, tiny_detail::FUNCTOR()))                   \
+            return l;                                                                        \
         for(index_t i=0; i<l.size(); ++i)                                                    \
             l[i] OP##= r[i];                                                                 \
         return l;                                                                            \
@@ -2395,6 +2691,8 @@ namespace xvigra
             "tiny_vector::operator" #OP "(): size mismatch.");                               \
         tiny_vector<decltype((*(V1*)0) OP (*(V2*)0)),                                        \
                    tiny_detail::size_promote<N1, N2>::value> res(l.size(), dont_init);       \
+        if(tiny_detail::simd_elementwise(res, l, r, tiny_detail::FUNCTOR()))                 \
+            return res;                                                                      \
         for(index_t i=0; i<l.size(); ++i)                                                    \
             res[i] = l[i] OP r[i];                                                           \
         return res;                                                                          \
@@ -2409,6 +2707,8 @@ namespace xvigra
                 V2 r)                                                                        \
     {                                                                                        \
         tiny_vector<decltype((*(V1*)0) OP (*(V2*)0)), N1> res(l.size(), dont_init);          \
+        if(tiny_detail::simd_elementwise(res, l, r, tiny_detail::FUNCTOR()))                 \
+            return res;                                                                      \
         for(index_t i=0; i<l.size(); ++i)                                                    \
             res[i] = l[i] OP r;                                                              \
         return res;                                                                          \
@@ -2423,21 +2723,23 @@ namespace xvigra
                 tiny_vector<V2, N2, R2> const & r)                                           \
     {                                                                                        \
         tiny_vector<decltype((*(V1*)0) OP (*(V2*)0)), N2> res(r.size(), dont_init);          \
+        if(tiny_detail::simd_elementwise(res, l, r, tiny_detail::FUNCTOR()))                 \
+            return res;                                                                      \
         for(index_t i=0; i<r.size(); ++i)                                                    \
             res[i] = l OP r[i];                                                              \
         return res;                                                                          \
     }
 
-    XVIGRA_TINYARRAY_OPERATORS(+)
-    XVIGRA_TINYARRAY_OPERATORS(-)
-    XVIGRA_TINYARRAY_OPERATORS(*)
-    XVIGRA_TINYARRAY_OPERATORS(/)
-    XVIGRA_TINYARRAY_OPERATORS(%)
-    XVIGRA_TINYARRAY_OPERATORS(&)
-    XVIGRA_TINYARRAY_OPERATORS(|)
-    XVIGRA_TINYARRAY_OPERATORS(^)
-    XVIGRA_TINYARRAY_OPERATORS(<<)
-    XVIGRA_TINYARRAY_OPERATORS(>>)
+    XVIGRA_TINYARRAY_OPERATORS(+, plus_functor)
+    XVIGRA_TINYARRAY_OPERATORS(-, minus_functor)
+    XVIGRA_TINYARRAY_OPERATORS(*, multiplies_functor)
+    XVIGRA_TINYARRAY_OPERATORS(/, divides_functor)
+    XVIGRA_TINYARRAY_OPERATORS(%, modulus_functor)
+    XVIGRA_TINYARRAY_OPERATORS(&, bit_and_functor)
+    XVIGRA_TINYARRAY_OPERATORS(|, bit_or_functor)
+    XVIGRA_TINYARRAY_OPERATORS(^, bit_xor_functor)
+    XVIGRA_TINYARRAY_OPERATORS(<<, left_shift_functor)
+    XVIGRA_TINYARRAY_OPERATORS(>>, right_shift_functor)
 
     #undef XVIGRA_TINYARRAY_OPERATORS
 
@@ -2605,6 +2907,8 @@ namespace xvigra
     {
         using result_type = decltype(v[0] + v[0]);
         result_type res = result_type();
+        if(tiny_detail::simd_reduce(res, v, v, tiny_detail::first_functor()))
+            return res;
         for(index_t k=0; k < v.size(); ++k)
             res += v[k];
         return res;
@@ -2674,6 +2978,8 @@ namespace xvigra
         XVIGRA_ASSERT_MSG(l.size() == r.size(),
             "min(tiny_vector, tiny_vector): size mismatch.");
         tiny_vector<promote_type, tiny_detail::size_promote<N1, N2>::value> res(l.size(), dont_init);
+        if(tiny_detail::simd_elementwise(res, l, r, tiny_detail::min_functor()))
+            return res;
         for(index_t k=0; k < l.size(); ++k)
             res[k] = min(static_cast<promote_type>(l[k]), static_cast<promote_type>(r[k]));
         return res;
@@ -2743,6 +3049,8 @@ namespace xvigra
         XVIGRA_ASSERT_MSG(l.size() == r.size(),
             "max(tiny_vector, tiny_vector): size mismatch.");
         tiny_vector<promote_type, tiny_detail::size_promote<N1, N2>::value> res(l.size(), dont_init);
+        if(tiny_detail::simd_elementwise(res, l, r, tiny_detail::max_functor()))
+            return res;
         for(index_t k=0; k < l.size(); ++k)
             res[k] = max(static_cast<promote_type>(l[k]), static_cast<promote_type>(r[k]));
         return res;
@@ -2888,6 +3196,8 @@ namespace xvigra
             "dot(tiny_vector, tiny_vector): size mismatch.");
         using result_type = decltype(l[0] * r[0]);
         result_type res = result_type();
+        if(tiny_detail::simd_reduce(res, l, r, tiny_detail::multiplies_functor()))
+            return res;
         for(index_t k=0; k < l.size(); ++k)
             res += l[k] * r[k];
         return res;
@@ -2910,22 +3220,24 @@ namespace xvigra
     #define XVIGRA_EMPTY
     #define XVIGRA_COMMA ,
     #define XVIGRA_ARGUMENT tiny_vector<V, N, R>
-    #define XVIGRA_NORM_FUNCTION(NAME, RESULT_TYPE, REDUCE_EXPR, REDUCE_OP)     \
+    #define XVIGRA_NORM_FUNCTION(NAME, RESULT_TYPE, REDUCE_EXPR, REDUCE_OP, SIMD_FUNCTOR) \
     template <class V, index_t N, class R>                                      \
     inline auto NAME(tiny_vector<V, N, R> const & t) noexcept                   \
     {                                                                           \
         using result_type = RESULT_TYPE;                                        \
         result_type result = result_type();                                     \
+        if(tiny_detail::simd_reduce(result, t, t, tiny_detail::SIMD_FUNCTOR())) \
+            return result;                                                      \
         for(index_t i=0; i<t.size(); ++i)                                       \
             result = REDUCE_EXPR(result REDUCE_OP NAME(t[i]));                  \
         return result;                                                          \
     }
 
-    XVIGRA_NORM_FUNCTION(norm_l0, unsigned long long, XVIGRA_EMPTY, +)
-    XVIGRA_NORM_FUNCTION(norm_l1, squared_norm_type_t<XVIGRA_ARGUMENT>, XVIGRA_EMPTY, +)
-    XVIGRA_NORM_FUNCTION(norm_sq, squared_norm_type_t<XVIGRA_ARGUMENT>, XVIGRA_EMPTY, +)
+    XVIGRA_NORM_FUNCTION(norm_l0, unsigned long long, XVIGRA_EMPTY, +, no_simd_functor)
+    XVIGRA_NORM_FUNCTION(norm_l1, squared_norm_type_t<XVIGRA_ARGUMENT>, XVIGRA_EMPTY, +, abs_functor)
+    XVIGRA_NORM_FUNCTION(norm_sq, squared_norm_type_t<XVIGRA_ARGUMENT>, XVIGRA_EMPTY, +, multiplies_functor)
     XVIGRA_NORM_FUNCTION(norm_linf, decltype(norm_linf(std::declval<V>())),
-                                    max, XVIGRA_COMMA)
+                                    max, XVIGRA_COMMA, no_simd_functor)
 
     #undef XVIGRA_EMPTY
     #undef XVIGRA_COMMA
@@ -0,0 +1,392 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#ifndef XVIGRA_TRANSPOSE_HPP
+#define XVIGRA_TRANSPOSE_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(XVIGRA_USE_SIMD) && defined(__SSE2__)
+#  include <emmintrin.h>
+#  define XVIGRA_HAS_SSE2_TRANSPOSE
+#endif
+
+#include "global.hpp"
+#include "error.hpp"
+#include "array_nd.hpp"
+#include "line_iterator.hpp"
+
+namespace xvigra
+{
+    /*********************/
+    /* transpose_options */
+    /*********************/
+
+    struct transpose_options
+    {
+        index_t thread_count = std::max<index_t>(1, std::thread::hardware_concurrency());
+        index_t min_elements_per_thread = index_t(1) << 16;
+        bool simd = true;
+
+        transpose_options & threads(index_t n)
+        {
+            vigra_precondition(n > 0,
+                "transpose_options::threads(): thread count must be positive.");
+            thread_count = n;
+            return *this;
+        }
+
+        transpose_options & use_simd(bool v)
+        {
+            simd = v;
+            return *this;
+        }
+    };
+
+    namespace detail
+    {
+        /***************************/
+        /* transpose block kernels */
+        /***************************/
+
+            // Copy a block with dest(i, j) = src(i, j), where 'src' has unit stride along i
+            // and 'dest' has unit stride along j, using in-register transposition.
+            // Returns false when no SIMD kernel exists for the types.
+        template <class T, class U>
+        inline bool transpose_block_simd(T const *, index_t, U *, index_t, index_t, index_t)
+        {
+            return false;
+        }
+
+    #ifdef XVIGRA_HAS_SSE2_TRANSPOSE
+        inline bool transpose_block_simd(float const * src, index_t src_j,
+                                         float * dest, index_t dest_i,
+                                         index_t ni, index_t nj)
+        {
+            index_t i4 = ni - ni % 4,
+                    j4 = nj - nj % 4;
+            for(index_t i=0; i<i4; i+=4)
+            {
+                for(index_t j=0; j<j4; j+=4)
+                {
+                    __m128 r0 = _mm_loadu_ps(src + i + (j+0)*src_j),
+                           r1 = _mm_loadu_ps(src + i + (j+1)*src_j),
+                           r2 = _mm_loadu_ps(src + i + (j+2)*src_j),
+                           r3 = _mm_loadu_ps(src + i + (j+3)*src_j);
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                    _mm_storeu_ps(dest + (i+0)*dest_i + j, r0);
+                    _mm_storeu_ps(dest + (i+1)*dest_i + j, r1);
+                    _mm_storeu_ps(dest + (i+2)*dest_i + j, r2);
+                    _mm_storeu_ps(dest + (i+3)*dest_i + j, r3);
+                }
+            }
+            for(index_t j=0; j<nj; ++j)
+            {
+                for(index_t i=(j < j4 ? i4 : 0); i<ni; ++i)
+                {
+                    dest[i*dest_i + j] = src[i + j*src_j];
+                }
+            }
+            return true;
+        }
+
+        inline bool transpose_block_simd(double const * src, index_t src_j,
+                                         double * dest, index_t dest_i,
+                                         index_t ni, index_t nj)
+        {
+            index_t i2 = ni - ni % 2,
+                    j2 = nj - nj % 2;
+            for(index_t i=0; i<i2; i+=2)
+            {
+                for(index_t j=0; j<j2; j+=2)
+                {
+                    __m128d r0 = _mm_loadu_pd(src + i + j*src_j),
+                            r1 = _mm_loadu_pd(src + i + (j+1)*src_j);
+                    _mm_storeu_pd(dest + i*dest_i + j, _mm_unpacklo_pd(r0, r1));
+                    _mm_storeu_pd(dest + (i+1)*dest_i + j, _mm_unpackhi_pd(r0, r1));
+                }
+            }
+            for(index_t j=0; j<nj; ++j)
+            {
+                for(index_t i=(j < j2 ? i2 : 0); i<ni; ++i)
+                {
+                    dest[i*dest_i + j] = src[i + j*src_j];
+                }
+            }
+            return true;
+        }
+    #endif
+
+            // Cache-oblivious copy of a 2D plane, where 'i' is the axis along which
+            // the source is fastest and 'j' the axis along which the destination is
+            // fastest. The index ranges are halved along the longer side until the
+            // block fits into L1 cache.
+        template <class T, class U>
+        struct transpose_plane
+        {
+            static constexpr index_t block_size = 32;
+
+            T const * src;
+            index_t src_i, src_j;
+            U * dest;
+            index_t dest_i, dest_j;
+            bool simd;
+
+            void operator()(index_t i0, index_t i1, index_t j0, index_t j1) const
+            {
+                index_t ni = i1 - i0,
+                        nj = j1 - j0;
+                if(ni <= block_size && nj <= block_size)
+                {
+                    block(i0, i1, j0, j1);
+                }
+                else if(ni >= nj)
+                {
+                    index_t im = i0 + ni / 2;
+                    (*this)(i0, im, j0, j1);
+                    (*this)(im, i1, j0, j1);
+                }
+                else
+                {
+                    index_t jm = j0 + nj / 2;
+                    (*this)(i0, i1, j0, jm);
+                    (*this)(i0, i1, jm, j1);
+                }
+            }
+
+            void block(index_t i0, index_t i1, index_t j0, index_t j1) const
+            {
+                T const * s = src + i0*src_i + j0*src_j;
+                U * d = dest + i0*dest_i + j0*dest_j;
+                if(simd && src_i == 1 && dest_j == 1 &&
+                   transpose_block_simd(s, src_j, d, dest_i, i1-i0, j1-j0))
+                {
+                    return;
+                }
+                for(index_t j=0; j<j1-j0; ++j)
+                {
+                    for(index_t i=0; i<i1-i0; ++i)
+                    {
+                        d[i*dest_i + j*dest_j] = static_cast<U>(s[i*src_i + j*src_j]);
+                    }
+                }
+            }
+        };
+
+            // execute 'f(k)' for k in [0, count) in up to 'thread_count' threads
+        template <class F>
+        void transpose_parallel(index_t count, index_t thread_count, F const & f)
+        {
+            thread_count = std::max<index_t>(1, std::min(thread_count, count));
+            auto run = [&f, count, thread_count](index_t t)
+            {
+                for(index_t k = t*count / thread_count; k < (t+1)*count / thread_count; ++k)
+                {
+                    f(k);
+                }
+            };
+            std::vector<std::thread> threads;
+            threads.reserve(thread_count-1);
+            for(index_t t=1; t<thread_count; ++t)
+            {
+                threads.emplace_back(run, t);
+            }
+            run(0);
+            for(auto & t: threads)
+            {
+                t.join();
+            }
+        }
+
+        template <class S>
+        inline index_t fastest_axis(S const & shape, S const & strides)
+        {
+            index_t res = (index_t)shape.size()-1;
+            for(index_t d=res-1; d>=0; --d)
+            {
+                if(shape[res] == 1 ||
+                   (shape[d] > 1 && std::abs(strides[d]) < std::abs(strides[res])))
+                {
+                    res = d;
+                }
+            }
+            return res;
+        }
+    } // namespace detail
+
+    /******************/
+    /* transpose_copy */
+    /******************/
+
+        /** \brief Copy 'in' to 'out' when their memory layouts differ.
+
+            Both arrays must have the same shape, but may have arbitrary strides,
+            e.g. when 'in' is a transposed or permuted view. The copy is organized in
+            planes spanned by the axis along which 'in' is fastest and the axis along
+            which 'out' is fastest. Each plane is copied in a cache-oblivious manner,
+            using SIMD in-register transposition for <tt>float</tt> and <tt>double</tt>
+            when <tt>XVIGRA_USE_SIMD</tt> is defined. Planes (or, if there are fewer
+            planes than threads, bands of a plane) are processed concurrently.
+            When both arrays are fastest along the same axis, the data are copied
+            line by line.
+        */
+    template <class T1, index_t N1, class T2, index_t N2>
+    void transpose_copy(view_nd<T1, N1> const & in, view_nd<T2, N2> out,
+                        transpose_options const & options = transpose_options())
+    {
+        using T = std::remove_const_t<T1>;
+        index_t ndim = in.dimension();
+        vigra_precondition(ndim == out.dimension(),
+            "transpose_copy(): dimension mismatch between input and output.");
+        for(index_t d=0; d<ndim; ++d)
+        {
+            vigra_precondition(in.shape(d) == out.shape(d),
+                "transpose_copy(): shape mismatch between input and output.");
+        }
+        if(in.size() == 0)
+        {
+            return;
+        }
+        if(ndim == 0)
+        {
+            *out.raw_data() = static_cast<T2>(*in.raw_data());
+            return;
+        }
+
+        index_t thread_count = std::max<index_t>(1,
+                                   std::min(options.thread_count,
+                                            in.size() / std::max<index_t>(1, options.min_elements_per_thread)));
+
+        index_t a = detail::fastest_axis(in.shape(), in.strides()),
+                b = detail::fastest_axis(out.shape(), out.strides());
+
+        if(a == b)
+        {
+            auto src_lines  = make_line_iterator(in, a);
+            auto dest_lines = make_line_iterator(out, a);
+            index_t count = src_lines.count();
+            thread_count = std::min(thread_count, count);
+            detail::transpose_parallel(thread_count, thread_count, [&](index_t t)
+            {
+                auto s = src_lines;
+                auto d = dest_lines;
+                s.set_range(t*count / thread_count, (t+1)*count / thread_count);
+                d.set_range(s.index(), s.end());
+                for(; s.has_more(); ++s, ++d)
+                {
+                    T const * p = s.data();
+                    T2 * q = d.data();
+                    for(index_t k=0; k<s.size(); ++k, p += s.stride(), q += d.stride())
+                    {
+                        *q = static_cast<T2>(*p);
+                    }
+                }
+            });
+            return;
+        }
+
+        shape_t<2> plane_axes{a, b};
+        auto src_planes  = make_subarray_iterator(in, plane_axes);
+        auto dest_planes = make_subarray_iterator(out, plane_axes);
+        index_t plane_count = src_planes.count(),
+                ni = in.shape(a),
+                nj = in.shape(b);
+
+        auto plane_kernel = [&](index_t plane)
+        {
+            auto s = src_planes;
+            auto d = dest_planes;
+            s.set_range(plane, plane+1);
+            d.set_range(plane, plane+1);
+            return detail::transpose_plane<T, T2>{s.data(), in.strides(a), in.strides(b),
+                                                  d.data(), out.strides(a), out.strides(b),
+                                                  options.simd};
+        };
+
+        if(plane_count >= thread_count)
+        {
+            detail::transpose_parallel(plane_count, thread_count, [&](index_t plane)
+            {
+                plane_kernel(plane)(0, ni, 0, nj);
+            });
+        }
+        else
+        {
+            // split each plane into bands along its longer side
+            for(index_t plane=0; plane<plane_count; ++plane)
+            {
+                auto kernel = plane_kernel(plane);
+                detail::transpose_parallel(thread_count, thread_count, [&](index_t t)
+                {
+                    if(ni >= nj)
+                    {
+                        kernel(t*ni / thread_count, (t+1)*ni / thread_count, 0, nj);
+                    }
+                    else
+                    {
+                        kernel(0, ni, t*nj / thread_count, (t+1)*nj / thread_count);
+                    }
+                });
+            }
+        }
+    }
+
+    /***************/
+    /* materialize */
+    /***************/
+
+        /** \brief Create an array with c-order memory layout that contains the data of 'in'.
+
+            This is the physical counterpart of the lazy <tt>view_nd::transpose()</tt>.
+            The copy uses \ref transpose_copy().
+
+            <b>Usage:</b>
+            \code
+            array_nd<float, 3> rgb_image(shape_t<3>{1080, 1920, 3});
+            // move the channel axis to the front (channel-first memory layout)
+            array_nd<float, 3> planar = materialize(rgb_image.transpose(shape_t<3>{2, 0, 1}));
+            \endcode
+        */
+    template <class T, index_t N>
+    inline array_nd<std::remove_const_t<T>, N>
+    materialize(view_nd<T, N> const & in, transpose_options const & options = transpose_options())
+    {
+        array_nd<std::remove_const_t<T>, N> res(in.shape());
+        transpose_copy(in, res, options);
+        return res;
+    }
+
+} // namespace xvigra
+
+#endif // XVIGRA_TRANSPOSE_HPP
@@ -0,0 +1,84 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include "unittest.hpp"
+#include <xvigra/array_nd.hpp>
+#include <xvigra/allocation_counter.hpp>
+
+namespace xvigra
+{
+#if XVIGRA_COUNT_ALLOCATIONS
+    TEST(allocation_counter, tiny_vector)
+    {
+        using small_vector = tiny_vector<int, runtime_size, int[2]>;
+
+        allocation_counter counter;
+        small_vector a(2, 1);
+        EXPECT_EQ(counter.count().allocations(), 0);
+
+        small_vector b(3, 1), c(b);
+        EXPECT_EQ(counter.count().tiny_vector_allocations, 2);
+        EXPECT_EQ(counter.count().tiny_vector_bytes, 6*(index_t)sizeof(int));
+        EXPECT_EQ(counter.count().array_nd_allocations, 0);
+
+        counter.reset();
+        shape_t<> shape(XVIGRA_SHAPE_BUFFER_SIZE, 1);
+        EXPECT_TRUE(shape.on_stack());
+        EXPECT_EQ(counter.count().allocations(), 0);
+    }
+
+    TEST(allocation_counter, array_nd)
+    {
+        allocation_counter counter;
+        array_nd<float> a(shape_t<>{4, 3, 5, 6, 2}, 1.0f);
+        EXPECT_EQ(counter.count().array_nd_allocations, 1);
+        EXPECT_EQ(counter.count().array_nd_bytes, a.size()*(index_t)sizeof(float));
+
+        array_nd<float> b(a);
+        EXPECT_EQ(counter.count().array_nd_allocations, 2);
+
+        // views of 5-dimensional data don't touch the heap
+        counter.reset();
+        view_nd<float> v = a.transpose();
+        view_nd<float> line = v.bind(0, 1).bind(1, 2);
+        view_nd<float> n = line.newaxis(0);
+        float s = 0.0f;
+        slicer nav(a.shape());
+        nav.set_free_axes(3);
+        for(; nav.has_more(); ++nav)
+        {
+            s += a.view(*nav)(0);
+        }
+        EXPECT_EQ(counter.count().allocations(), 0);
+        EXPECT_EQ(n.dimension(), 4);
+        EXPECT_EQ(s, a.size() / 6.0f);
+    }
+#endif // XVIGRA_COUNT_ALLOCATIONS
+} // namespace xvigra
@@ -1060,4 +1060,58 @@ namespace xvigra
         EXPECT_EQ(vsized.dimension(), 4);
     }
 #endif
+
+    TEST(array_nd, streaming_store)
+    {
+        streaming_store_options saved = default_streaming_store_options();
+        default_streaming_store_options().min_bytes = 0;
+        default_streaming_store_options().thread_count = 3;
+
+        shape_t<3> s{7, 50, 33};
+        array_nd<float, 3> a(s), b(s), c(s);
+        std::iota(a.begin(), a.end(), 0.0f);
+
+        // scalar fill, also with a misaligned start
+        b = 2.0f;
+        EXPECT_TRUE(all(equal(b, 2.0f)));
+        view_nd<float, 1> unaligned(shape_t<1>{b.size()-1}, b.raw_data()+1);
+        unaligned = 3.0f;
+        EXPECT_EQ(b.raw_data()[0], 2.0f);
+        EXPECT_TRUE(all(equal(unaligned, 3.0f)));
+
+        // contiguous copy and type conversion
+        b = a;
+        EXPECT_EQ(a, b);
+        array_nd<double, 3> d(s);
+        d = a;
+        EXPECT_TRUE(all(equal(d, a)));
+
+        // expressions and non-contiguous sources
+        c = xt::where(a > 1000.0f, a, -a);
+        EXPECT_EQ(c, (xt::where(a > 1000.0f, a, -a)));
+        array_nd<float, 3> t(shape_t<3>{33, 50, 7});
+        t = a.transpose();
+        c = t.transpose();
+        EXPECT_EQ(c, a);
+
+        // non-contiguous destinations and broadcasting use the ordinary path
+        auto strided = c.view(slicing::all(), slicing::all(), slicing::range(0, 33, 2));
+        strided = 1.0f;
+        EXPECT_EQ(c(3, 4, 2), 1.0f);
+        EXPECT_EQ(c(3, 4, 1), a(3, 4, 1));
+        array_nd<float, 1> row(shape_t<1>{33});
+        std::iota(row.begin(), row.end(), 0.0f);
+        c = row;
+        EXPECT_EQ(c(6, 49, 32), 32.0f);
+
+        // without non-temporal stores, the single-threaded path is left to xtensor
+        default_streaming_store_options().thread_count = 1;
+#ifdef XVIGRA_HAS_STREAMING_STORE
+        EXPECT_TRUE(detail::use_streaming_store<float>(1000));
+#else
+        EXPECT_FALSE(detail::use_streaming_store<float>(1000));
+#endif
+
+        default_streaming_store_options() = saved;
+    }
 } // namespace xvigra
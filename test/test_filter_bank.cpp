@@ -0,0 +1,120 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <cmath>
+#include "unittest.hpp"
+#include <xvigra/filter_bank.hpp>
+
+namespace xvigra
+{
+    TEST(filter_bank, schedule)
+    {
+        filter_bank<float> bank;
+        for(double s: {0.7, 1.0, 1.6, 3.5, 5.0, 10.0})
+        {
+            bank.add(gaussian_smoothing_feature, s);
+            bank.add(gaussian_gradient_magnitude_feature, s);
+        }
+        bank.add(hessian_eigenvalues_feature, 1.6);
+
+        EXPECT_EQ(bank.size(), 13);
+        EXPECT_EQ(bank.channel_count(2), 14);
+        EXPECT_EQ(bank.channel_offset(12, 2), 12);
+        EXPECT_EQ(bank.channel_count(3), 15);
+
+        auto stats = bank.plan_statistics(shape_t<>{512, 512});
+        EXPECT_EQ(stats.intermediates, 6);
+        EXPECT_EQ(stats.peak_intermediates, 2);
+        EXPECT_EQ(stats.peak_bytes, 2*512*512*sizeof(float));
+        EXPECT_GT(stats.flops_saved(), 0.0);
+
+        // without smoothing requests, only the intermediates used as bases are computed
+        filter_bank<float> derivatives;
+        derivatives.add(laplacian_of_gaussian_feature, 1.0);
+        derivatives.add(laplacian_of_gaussian_feature, 4.0);
+        stats = derivatives.plan_statistics(shape_t<>{100, 100});
+        EXPECT_EQ(stats.intermediates, 1);
+    }
+
+    TEST(filter_bank, apply)
+    {
+        shape_t<2> shape{60, 70};
+        array_nd<float, 2> image(shape);
+        for(index_t i=0; i<shape[0]; ++i)
+        {
+            for(index_t j=0; j<shape[1]; ++j)
+            {
+                image(i, j) = std::sin(0.3f*i) * std::cos(0.2f*j) + 0.01f*i;
+            }
+        }
+
+        filter_bank<float> bank;
+        bank.add(gaussian_smoothing_feature, 1.0);
+        bank.add(gaussian_smoothing_feature, 2.0);
+        bank.add(gaussian_gradient_magnitude_feature, 2.0);
+        bank.add(laplacian_of_gaussian_feature, 1.5);
+        bank.add(hessian_eigenvalues_feature, 2.0);
+
+        array_nd<float, 3> features(shape_t<3>{shape[0], shape[1], bank.channel_count(2)});
+        bank.apply(image, features);
+        EXPECT_EQ(bank.statistics().intermediates, 3);
+        EXPECT_GT(bank.statistics().flops_saved(), 0.0);
+
+        // reference results, computed from the input
+        array_nd<float, 2> smooth1(shape), smooth2(shape), gradient_x(shape), gradient_y(shape),
+                           laplacian_x(shape), laplacian_y(shape);
+        separable_convolution(image, smooth1, gaussian_kernel_1d<float>(1.0));
+        separable_convolution(image, smooth2, gaussian_kernel_1d<float>(2.0));
+        separable_convolution(image, gradient_x, detail::gaussian_derivative_kernels<float>(2.0, shape_t<>{1, 0}));
+        separable_convolution(image, gradient_y, detail::gaussian_derivative_kernels<float>(2.0, shape_t<>{0, 1}));
+        separable_convolution(image, laplacian_x, detail::gaussian_derivative_kernels<float>(1.5, shape_t<>{2, 0}));
+        separable_convolution(image, laplacian_y, detail::gaussian_derivative_kernels<float>(1.5, shape_t<>{0, 2}));
+        array_nd<tiny_vector<float, 2>, 2> hessian_ev(shape);
+        hessian_eigenvalues(image, hessian_ev, 2.0);
+
+        // cascading is exact up to kernel truncation, except near the border where
+        // the padding of the intermediates differs
+        for(index_t i=15; i<shape[0]-15; ++i)
+        {
+            for(index_t j=15; j<shape[1]-15; ++j)
+            {
+                EXPECT_NEAR(features(i, j, 0), smooth1(i, j), 5e-3f);
+                EXPECT_NEAR(features(i, j, 1), smooth2(i, j), 5e-3f);
+                EXPECT_NEAR(features(i, j, 2), std::hypot(gradient_x(i, j), gradient_y(i, j)), 5e-3f);
+                EXPECT_NEAR(features(i, j, 3), laplacian_x(i, j) + laplacian_y(i, j), 5e-3f);
+                EXPECT_NEAR(features(i, j, 4), hessian_ev(i, j)[0], 5e-3f);
+                EXPECT_NEAR(features(i, j, 5), hessian_ev(i, j)[1], 5e-3f);
+            }
+        }
+
+        array_nd<float, 3> wrong(shape_t<3>{shape[0], shape[1], 3});
+        EXPECT_THROW(bank.apply(image, wrong), std::runtime_error);
+    }
+} // namespace xvigra
@@ -30,6 +30,7 @@
 
 #include "unittest.hpp"
 #include <xvigra/gaussian.hpp>
+#include <xvigra/array_nd.hpp>
 
 namespace xvigra
 {
@@ -86,4 +87,49 @@ namespace xvigra
         EXPECT_NEAR(g5(2.711252359948531), 0, epsilon);
         EXPECT_NEAR(g5(5.713940027745611), 0, epsilon);
     }
+
+    TEST(gaussian, evaluate)
+    {
+        index_t size = 1001;
+        array_nd<double, 1> x(shape_t<1>{size}), res(x.shape());
+        for(index_t k=0; k<size; ++k)
+        {
+            x(k) = -8.0 + 16.0 * k / (size - 1.0);
+        }
+
+        for(unsigned int order = 0; order <= 6; ++order)
+        {
+            gaussian<double> g(1.5, order);
+            g.evaluate(x, res);
+            for(index_t k=0; k<size; ++k)
+            {
+                EXPECT_NEAR(res(k), g(x(k)), 1e-14);
+            }
+
+            // expression input
+            g.evaluate(2.0*x, res);
+            for(index_t k=0; k<size; ++k)
+            {
+                EXPECT_NEAR(res(k), g(2.0*x(k)), 1e-14);
+            }
+        }
+
+        // in-place evaluation on a strided view
+        gaussian<float> gf(2.0f, 2);
+        array_nd<float, 2> a(shape_t<2>{20, 30}), ref(a.shape());
+        for(index_t i=0; i<20; ++i)
+        {
+            for(index_t j=0; j<30; ++j)
+            {
+                a(i, j) = 0.1f*(i - j);
+                ref(i, j) = gf(a(i, j));
+            }
+        }
+        auto t = a.transpose();
+        gf.evaluate(t, t);
+        EXPECT_TRUE(allclose(a, ref, 1e-6, 1e-7));
+
+        array_nd<float, 2> wrong(shape_t<2>{30, 20});
+        EXPECT_THROW(gf.evaluate(a, wrong), std::runtime_error);
+    }
 } // namespace xvigra
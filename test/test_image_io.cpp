@@ -0,0 +1,170 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <cstdio>
+#include "unittest.hpp"
+#include <xvigra/image_io.hpp>
+
+namespace xvigra
+{
+    TEST(image_io, read_image_into_view)
+    {
+        auto && ref = read_image("color_image.tif");
+        EXPECT_EQ(ref.dimension(), 3u);
+
+        array_nd<float> image(ref.shape());
+        read_image("color_image.tif", image);
+        EXPECT_EQ(image, ref);
+
+        using namespace slicing;
+
+        // read into a strided view: the channel axis of 'padded' has one extra entry
+        auto s = ref.shape();
+        array_nd<float, 3> padded({s[0], s[1], s[2]+1}, -1.0f);
+        read_image("color_image.tif", padded.view(all(), all(), slice(0, s[2])));
+        EXPECT_EQ(padded.view(all(), all(), slice(0, s[2])), ref);
+        EXPECT_TRUE(all(equal(padded.view(all(), all(), s[2]), -1.0f)));
+
+        array_nd<float> wrong({s[1], s[0], s[2]});
+        EXPECT_THROW(read_image("color_image.tif", wrong), std::runtime_error);
+        EXPECT_THROW(read_image("color_image.tif", image.transpose()), std::runtime_error);
+    }
+
+    TEST(image_io, image_block_reader)
+    {
+        auto && ref = read_image("color_image.tif");
+        shape_t<2> block_shape{37, 50};
+        index_t overlap = 3;
+
+        for(bool prefetch: {false, true})
+        {
+            image_block_reader<float> reader("color_image.tif", block_shape, overlap, prefetch);
+            EXPECT_EQ(reader.shape(), ref.shape());
+            EXPECT_EQ(reader.prefetching(), prefetch);
+
+            array_nd<int, 2> covered({ref.shape(0), ref.shape(1)}, 0);
+            for(; reader.has_more(); ++reader)
+            {
+                auto b = reader.block_begin(),
+                     e = reader.block_end();
+                EXPECT_TRUE(all_less_equal(b, reader.core_begin()));
+                EXPECT_TRUE(all_less_equal(reader.core_end(), e));
+                EXPECT_TRUE(all_less_equal(reader.core_end() - reader.core_begin(), block_shape));
+                EXPECT_EQ(reader->shape(), (shape_t<>{e[0]-b[0], e[1]-b[1], ref.shape(2)}));
+                EXPECT_EQ(*reader, ref.subarray(shape_t<>{b[0], b[1], 0}, shape_t<>{e[0], e[1], ref.shape(2)}));
+
+                covered.subarray(reader.core_begin(), reader.core_end()) += 1;
+            }
+            EXPECT_TRUE(all(equal(covered, 1)));
+        }
+
+        // stopping early must shut down the prefetch thread cleanly
+        {
+            image_block_reader<float> reader("color_image.tif", shape_t<2>{8, 8}, 0, true);
+            ++reader;
+            EXPECT_TRUE(reader.has_more());
+        }
+    }
+
+    TEST(image_io, image_block_reader_tiled)
+    {
+        // tiles are read with tile-aligned bounds, which must be cropped to the blocks
+        shape_t<3> shape{70, 90, 3};
+        array_nd<float, 3> image(shape);
+        index_t k = 0;
+        for(auto & v: image)
+        {
+            v = (float)(k++ % 251);
+        }
+
+        {
+            OIIO::ImageSpec spec((int)shape[1], (int)shape[0], (int)shape[2], OIIO::TypeDesc::FLOAT);
+            spec.tile_width = 16;
+            spec.tile_height = 16;
+            std::unique_ptr<OIIO::ImageOutput, detail::close_image_output> out(
+                OIIO::ImageOutput::create("test_block_reader_tiled.tif"));
+            bool written = out && out->open("test_block_reader_tiled.tif", spec) &&
+                           out->write_image(OIIO::TypeDesc::FLOAT, image.raw_data());
+            EXPECT_TRUE(written);
+        }
+        auto && ref = read_image("test_block_reader_tiled.tif");
+        EXPECT_TRUE(all(equal(ref, image)));
+
+        // block sizes and overlaps that are not multiples of the tile size
+        for(bool prefetch: {false, true})
+        {
+            image_block_reader<float> reader("test_block_reader_tiled.tif", shape_t<2>{20, 27}, 5, prefetch);
+            EXPECT_EQ(reader.spec().tile_width, 16);
+            EXPECT_EQ(reader.spec().tile_height, 16);
+
+            array_nd<int, 2> covered({shape[0], shape[1]}, 0);
+            for(; reader.has_more(); ++reader)
+            {
+                auto b = reader.block_begin(),
+                     e = reader.block_end();
+                EXPECT_EQ(b, max(reader.core_begin() - 5, 0));
+                EXPECT_EQ(e, min(reader.core_end() + 5, shape_t<2>{shape[0], shape[1]}));
+                EXPECT_EQ(*reader, ref.subarray(shape_t<>{b[0], b[1], 0}, shape_t<>{e[0], e[1], shape[2]}));
+
+                covered.subarray(reader.core_begin(), reader.core_end()) += 1;
+            }
+            EXPECT_TRUE(all(equal(covered, 1)));
+        }
+        std::remove("test_block_reader_tiled.tif");
+    }
+
+    TEST(image_io, write_image_strips)
+    {
+        auto && ref = read_image("color_image.tif");
+
+        // float data, no conversion: expression is evaluated strip by strip
+        write_image("test_write_strips.tif", 2.0f*ref + 1.0f,
+                    write_image_options().strip_height(7));
+        auto && res = read_image("test_write_strips.tif");
+        EXPECT_EQ(res.shape(), ref.shape());
+        EXPECT_TRUE(allclose(res, 2.0f*ref + 1.0f));
+
+        // conversion to uint8 with caller-supplied value range
+        array_nd<float> gray({50, 60});
+        for(index_t y = 0; y < 50; ++y)
+            for(index_t x = 0; x < 60; ++x)
+                gray(y, x) = 100.0f + (float)(y + x);
+        write_image("test_write_strips.png", gray,
+                    write_image_options().value_range(100.0, 208.0).strip_height(16));
+        auto && res8 = read_image<uint8_t>("test_write_strips.png");
+        EXPECT_EQ(res8.shape(), gray.shape());
+        EXPECT_EQ(res8(0, 0), 0);
+        EXPECT_EQ(res8(49, 59), 255);
+        EXPECT_NEAR(res8(20, 34), 255.0*54.0/108.0, 1.0);
+
+        std::remove("test_write_strips.tif");
+        std::remove("test_write_strips.png");
+    }
+} // namespace xvigra
@@ -0,0 +1,95 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "unittest.hpp"
+#include <xvigra/image_sequence.hpp>
+
+namespace xvigra
+{
+    TEST(image_sequence, write_and_read)
+    {
+        auto && ref = read_image("color_image.tif");
+        index_t count = 6;
+
+        std::vector<std::string> filenames;
+        for(index_t k = 0; k < count; ++k)
+        {
+            filenames.push_back("test_sequence_" + std::to_string(k) + ".tif");
+        }
+
+        {
+            image_sequence_writer<float> writer(2, 2);
+            for(index_t k = 0; k < count; ++k)
+            {
+                if(k % 2 == 0)
+                {
+                    writer.write(filenames[k], ref + (float)k);
+                }
+                else
+                {
+                    auto image = writer.acquire(ref.shape());
+                    image = ref + (float)k;
+                    writer.write(filenames[k], std::move(image));
+                }
+            }
+            writer.wait();
+        }
+
+        {
+            image_sequence_reader<float> reader(filenames, 3, 2);
+            EXPECT_EQ(reader.size(), count);
+            index_t k = 0;
+            while(reader.has_more())
+            {
+                auto frame = reader.next();
+                EXPECT_EQ(frame.index, k);
+                EXPECT_EQ(frame.filename, filenames[k]);
+                EXPECT_TRUE(allclose(frame.image, ref + (float)k));
+                reader.recycle(std::move(frame.image));
+                ++k;
+            }
+            EXPECT_EQ(k, count);
+            EXPECT_THROW(reader.next(), std::runtime_error);
+        }
+
+        {
+            image_sequence_reader<float> reader({"does_not_exist.tif"});
+            EXPECT_THROW(reader.next(), std::runtime_error);
+        }
+
+        for(auto const & f : filenames)
+        {
+            std::remove(f.c_str());
+        }
+    }
+} // namespace xvigra
@@ -0,0 +1,112 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <thread>
+#include <vector>
+#include "unittest.hpp"
+#include <xvigra/kernel_cache.hpp>
+
+namespace xvigra
+{
+    TEST(kernel_cache, lookup)
+    {
+        kernel_cache cache(3);
+
+        auto k1 = cache.gaussian<float>(2.0);
+        auto k2 = cache.gaussian<float>(2.0);
+        EXPECT_EQ(k1.get(), k2.get());
+        EXPECT_EQ(*k1, gaussian_kernel_1d<float>(2.0));
+        EXPECT_EQ(k1->center(), 6);
+
+        // the value type is part of the key
+        auto k3 = cache.gaussian<double>(2.0);
+        EXPECT_EQ(*k3, gaussian_kernel_1d<double>(2.0));
+
+        auto d1 = cache.gaussian<float>(2.0, 1);
+        EXPECT_EQ(*d1, gaussian_derivative_kernel_1d<float>(2.0, 1));
+        EXPECT_NE((void const *)d1.get(), (void const *)k1.get());
+
+        auto stats = cache.statistics();
+        EXPECT_EQ(stats.hits, 1);
+        EXPECT_EQ(stats.misses, 3);
+        EXPECT_EQ(stats.size, 3);
+        EXPECT_EQ(stats.evictions, 0);
+
+        // explicit radius
+        auto r1 = cache.gaussian<float>(2.0, 0, 4);
+        EXPECT_EQ(r1->size(), 9);
+        EXPECT_EQ(cache.size(), 3);
+        EXPECT_EQ(cache.statistics().evictions, 1);
+
+        // the least recently used kernel (k1) was evicted,
+        // but it stays valid as long as it is referenced
+        EXPECT_EQ(*k1, gaussian_kernel_1d<float>(2.0));
+        cache.gaussian<double>(2.0);
+        EXPECT_EQ(cache.statistics().hits, 2);
+        EXPECT_NE(cache.gaussian<float>(2.0).get(), k1.get());
+        EXPECT_EQ(cache.statistics().misses, 5);
+
+        cache.set_capacity(1);
+        EXPECT_EQ(cache.size(), 1);
+        cache.clear();
+        EXPECT_EQ(cache.size(), 0);
+        cache.reset_statistics();
+        EXPECT_EQ(cache.statistics().hits, 0);
+    }
+
+    TEST(kernel_cache, threads)
+    {
+        kernel_cache cache;
+        std::vector<std::thread> threads;
+        std::vector<std::shared_ptr<kernel_1d<float> const>> kernels(8);
+        for(int t=0; t<8; ++t)
+        {
+            threads.emplace_back([&cache, &kernels, t]()
+            {
+                for(int k=0; k<100; ++k)
+                {
+                    kernels[t] = cache.gaussian<float>(1.0 + k % 4);
+                }
+            });
+        }
+        for(auto & t : threads)
+        {
+            t.join();
+        }
+
+        auto stats = cache.statistics();
+        EXPECT_EQ(stats.hits + stats.misses, 800);
+        EXPECT_EQ(stats.size, 4);
+        for(int t=0; t<8; ++t)
+        {
+            EXPECT_EQ(kernels[t].get(), cache.gaussian<float>(4.0).get());
+        }
+    }
+} // namespace xvigra
@@ -0,0 +1,208 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include "unittest.hpp"
+#include <xvigra/line_iterator.hpp>
+
+namespace xvigra
+{
+    TEST(line_iterator, lines)
+    {
+        using namespace slicing;
+        shape_t<3> shape{2,3,4};
+        array_nd<int, 3> a(shape);
+        for(index_t k=0; k<a.size(); ++k)
+        {
+            a.raw_data()[k] = k;
+        }
+
+        for(index_t d=0; d<3; ++d)
+        {
+            slicer nav(a.shape());
+            nav.set_free_axes(d);
+            auto line = make_line_iterator(a, d);
+            EXPECT_EQ(line.count(), prod(shape) / shape[d]);
+            EXPECT_EQ(line.size(), shape[d]);
+            EXPECT_EQ(line.stride(), a.strides(d));
+            index_t count = 0;
+            for(; line.has_more(); ++line, ++nav, ++count)
+            {
+                EXPECT_TRUE(nav.has_more());
+                EXPECT_EQ(line.index(), count);
+                EXPECT_EQ(*line, a.view(*nav));
+                EXPECT_EQ(line.data(), &a.view(*nav)(0));
+            }
+            EXPECT_FALSE(nav.has_more());
+            EXPECT_EQ(count, line.count());
+        }
+
+        // const views yield read-only lines
+        view_nd<int, 3> const & ca = a;
+        auto cline = make_line_iterator(ca, 2);
+        EXPECT_TRUE((std::is_same<decltype(cline.data()), int const *>::value));
+
+        // write through lines
+        for(auto line = make_line_iterator(a, 1); line.has_more(); ++line)
+        {
+            int * p = line.data();
+            for(index_t k=0; k<line.size(); ++k, p += line.stride())
+            {
+                *p = (int)k;
+            }
+        }
+        for(index_t k=0; k<a.size(); ++k)
+        {
+            EXPECT_EQ(a.raw_data()[k], (k / 4) % 3);
+        }
+
+        // a view covering all axes is a single subarray
+        auto all_axes = make_subarray_iterator(a, shape_t<3>{2,0,1});
+        EXPECT_EQ(all_axes.count(), 1);
+        EXPECT_EQ(*all_axes, a);
+        ++all_axes;
+        EXPECT_FALSE(all_axes.has_more());
+    }
+
+    TEST(line_iterator, planes)
+    {
+        shape_t<4> shape{2,3,4,5};
+        array_nd<int, 4> a(shape);
+        for(index_t k=0; k<a.size(); ++k)
+        {
+            a.raw_data()[k] = k;
+        }
+
+        slicer nav(a.shape());
+        nav.set_free_axes(0, 3);
+        auto plane = make_subarray_iterator(a, shape_t<2>{3, 0});
+        EXPECT_EQ(plane.count(), 12);
+        EXPECT_EQ(plane.shape(), (shape_t<2>{2, 5}));
+        for(; plane.has_more(); ++plane, ++nav)
+        {
+            EXPECT_TRUE(nav.has_more());
+            EXPECT_EQ(*plane, a.view(*nav));
+        }
+        EXPECT_FALSE(nav.has_more());
+    }
+
+    TEST(line_iterator, split)
+    {
+        array_nd<int, 3> a(shape_t<3>{3,5,2}, 0);
+        auto lines = make_line_iterator(a, 2);
+        EXPECT_EQ(lines.count(), 15);
+
+        for(index_t parts: {1, 2, 4, 15, 20})
+        {
+            auto ranges = lines.split(parts);
+            EXPECT_EQ((index_t)ranges.size(), std::min<index_t>(parts, 15));
+            EXPECT_EQ(ranges.front().index(), 0);
+            EXPECT_EQ(ranges.back().end(), 15);
+
+            auto reference = lines;
+            for(index_t k=0; k<(index_t)ranges.size(); ++k)
+            {
+                if(k > 0)
+                {
+                    EXPECT_EQ(ranges[k].index(), ranges[k-1].end());
+                }
+                for(auto & part = ranges[k]; part.has_more(); ++part, ++reference)
+                {
+                    EXPECT_EQ(part.index(), reference.index());
+                    EXPECT_EQ(part.data(), reference.data());
+                    EXPECT_EQ(part.position(), reference.position());
+                    *part += 1;
+                }
+            }
+            EXPECT_FALSE(reference.has_more());
+        }
+        EXPECT_TRUE(all(equal(a, 5)));
+    }
+
+    TEST(line_iterator, empty)
+    {
+        array_nd<int, 2> a(shape_t<2>{0, 5});
+        for(index_t axis: {0, 1})
+        {
+            auto lines = make_line_iterator(a, axis);
+            EXPECT_EQ(lines.count(), 0);
+            EXPECT_FALSE(lines.has_more());
+
+            auto ranges = lines.split(4);
+            EXPECT_EQ(ranges.size(), 1u);
+            EXPECT_FALSE(ranges[0].has_more());
+        }
+
+        array_nd<int, 3> b(shape_t<3>{3, 0, 2});
+        EXPECT_FALSE(make_line_iterator(b, 2).has_more());
+        EXPECT_FALSE(make_subarray_iterator(b, shape_t<2>{0, 2}).has_more());
+    }
+
+    TEST(line_iterator, static_dimension)
+    {
+        array_nd<int> a(shape_t<>{2,3,4}), b(shape_t<>{2,3,4});
+        for(index_t k=0; k<a.size(); ++k)
+        {
+            a.raw_data()[k] = k;
+        }
+
+        index_t called = 0;
+        dispatch_static_dimension(a, b, [&](auto & sa, auto & sb)
+        {
+            EXPECT_EQ((std::decay_t<decltype(sa)>::ndim), 3);
+            EXPECT_EQ((std::decay_t<decltype(sb)>::ndim), 3);
+            auto line = make_line_iterator(sa, 1);
+            EXPECT_EQ((decltype(line)::outer_dimension), 2);
+            for(auto out = make_line_iterator(sb, 1); line.has_more(); ++line, ++out)
+            {
+                *out = *line;
+            }
+            ++called;
+        });
+        EXPECT_EQ(called, 1);
+        EXPECT_EQ(a, b);
+
+        // static lines visit the same elements as runtime lines
+        auto dynamic_line = make_line_iterator(a, 0);
+        auto static_line  = make_line_iterator(a.view<3>(), 0);
+        EXPECT_EQ((decltype(dynamic_line)::outer_dimension), runtime_size);
+        for(; dynamic_line.has_more(); ++dynamic_line, ++static_line)
+        {
+            EXPECT_EQ(dynamic_line.data(), static_line.data());
+        }
+        EXPECT_FALSE(static_line.has_more());
+
+        // other dimensions keep the runtime path
+        array_nd<int> c(shape_t<>{2,3,4,5}), d(c.shape());
+        dispatch_static_dimension(c, d, [&](auto & sc, auto &)
+        {
+            EXPECT_EQ((std::decay_t<decltype(sc)>::ndim), runtime_size);
+        });
+    }
+} // namespace xvigra
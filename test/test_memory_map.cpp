@@ -0,0 +1,110 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include "unittest.hpp"
+#include <xvigra/memory_map.hpp>
+
+namespace xvigra
+{
+    TEST(memory_map, raw)
+    {
+        std::string filename = "test_memory_map.raw";
+        std::vector<float> data(2*3*4);
+        std::iota(data.begin(), data.end(), 0.0f);
+        {
+            std::ofstream f(filename, std::ios::binary);
+            f.write("head", 4);
+            f.write(reinterpret_cast<char const *>(data.data()), data.size()*sizeof(float));
+        }
+
+        {
+            auto a = map_raw<const float, 3>(filename, {2, 3, 4}, map_read_only, 4);
+            EXPECT_EQ(a.shape(), (shape_t<3>{2, 3, 4}));
+            EXPECT_EQ(a.strides(), (shape_t<3>{12, 4, 1}));
+            EXPECT_TRUE(a.is_contiguous());
+            EXPECT_TRUE(a.owns_memory());
+            EXPECT_EQ(a(1, 2, 3), 23.0f);
+
+            view_nd<const float, 2> v = a.bind(0, 1);
+            EXPECT_FALSE(v.owns_memory());
+            EXPECT_EQ(v(0, 0), 12.0f);
+
+            auto f = map_raw<const float>(filename, shape_t<>{4, 6}, map_read_only, 4, f_order);
+            EXPECT_EQ(f.strides(), (shape_t<>{1, 4}));
+            EXPECT_EQ(f(1, 2), 9.0f);
+
+            auto c = map_raw<float, 1>(filename, {24}, map_copy_on_write, 4);
+            c(0) = 42.0f;
+            EXPECT_EQ(c(0), 42.0f);
+            EXPECT_EQ(a(0, 0, 0), 0.0f);
+
+            EXPECT_THROW((map_raw<float, 1>(filename, {24})), std::runtime_error);
+            EXPECT_THROW((map_raw<const float, 1>(filename, {25}, map_read_only, 4)), std::runtime_error);
+        }
+        std::remove(filename.c_str());
+    }
+
+    TEST(memory_map, npy)
+    {
+        std::string filename = "test_memory_map.npy";
+        std::vector<int16_t> data(3*5);
+        std::iota(data.begin(), data.end(), 0);
+        {
+            std::string header = "{'descr': '<i2', 'fortran_order': False, 'shape': (3, 5), }";
+            header.append(64 - 10 - header.size() - 1, ' ');
+            header += '\n';
+            char preamble[10] = { '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                                  static_cast<char>(header.size()), 0 };
+            std::ofstream f(filename, std::ios::binary);
+            f.write(preamble, 10);
+            f.write(header.data(), header.size());
+            f.write(reinterpret_cast<char const *>(data.data()), data.size()*sizeof(int16_t));
+        }
+
+        if(detail::is_little_endian())
+        {
+            auto a = map_npy<const int16_t>(filename);
+            EXPECT_EQ(a.dimension(), 2u);
+            EXPECT_EQ(a.shape(), (shape_t<>{3, 5}));
+            EXPECT_EQ(a(2, 4), 14);
+
+            auto b = map_npy<const int16_t, 2>(filename);
+            EXPECT_EQ(b(1, 0), 5);
+
+            EXPECT_THROW(map_npy<const float>(filename), std::runtime_error);
+            EXPECT_THROW((map_npy<const int16_t, 3>(filename)), std::runtime_error);
+        }
+        std::remove(filename.c_str());
+    }
+} // namespace xvigra
@@ -94,6 +94,15 @@ namespace xvigra
             copy_with_padding(in, out, reflect_padding, 3, periodic_padding, 2);
             EXPECT_EQ(out, ref);
         }
+        {
+            // padding in place, when the data are already in the middle
+            xt::xtensor<int, 1> ref{4, 3, 2, 1, 2, 3, 4, 5, 1, 2},
+                                out{0, 0, 0, 1, 2, 3, 4, 5, 0, 0};
+
+            apply_padding(out, reflect_padding, 3, periodic_padding, 2);
+            EXPECT_EQ(out, ref);
+            EXPECT_THROW(apply_padding(out, reflect_padding, 6, no_padding, 0), std::runtime_error);
+        }
     }
 
 } // namespace xvigra
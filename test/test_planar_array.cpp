@@ -0,0 +1,126 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include "unittest.hpp"
+#include <xvigra/planar_array.hpp>
+#include <xvigra/separable_convolution.hpp>
+
+namespace xvigra
+{
+    TEST(planar_array, access)
+    {
+        using V = tiny_vector<float, 3>;
+        array_nd<V, 2> rgb(shape_t<2>{4, 5});
+        for(index_t y=0; y<4; ++y)
+        {
+            for(index_t x=0; x<5; ++x)
+            {
+                rgb(y, x) = V{float(x), float(y), float(x + 10*y)};
+            }
+        }
+
+        planar_array_nd<float, 3, 2> planar(rgb);
+        EXPECT_EQ(planar.shape(), (shape_t<2>{4, 5}));
+        EXPECT_EQ(planar.channel_stride(), 20);
+        EXPECT_EQ(planar.view().shape(), (shape_t<3>{3, 4, 5}));
+        EXPECT_EQ(planar.view().channel_axis(), 0);
+        for(index_t y=0; y<4; ++y)
+        {
+            for(index_t x=0; x<5; ++x)
+            {
+                EXPECT_EQ(planar(y, x).get(), rgb(y, x));
+                EXPECT_EQ(planar[(shape_t<2>{y, x})][2], float(x + 10*y));
+                EXPECT_EQ(planar.channel(1)(y, x), float(y));
+            }
+        }
+
+        // element assignment writes all planes
+        planar(1, 2) = V{-1.0f, -2.0f, -3.0f};
+        EXPECT_EQ(planar.channel(0)(1, 2), -1.0f);
+        EXPECT_EQ(planar.channel(2)(1, 2), -3.0f);
+        planar(0, 0) = planar(1, 2);
+        EXPECT_EQ(planar(0, 0).get(), (V{-1.0f, -2.0f, -3.0f}));
+
+        // expanding the channel axis doesn't copy
+        auto channel_last = planar.expand_elements(2);
+        EXPECT_EQ(channel_last.shape(), (shape_t<3>{4, 5, 3}));
+        EXPECT_EQ(&channel_last(1, 2, 1), &planar.channel(1)(1, 2));
+
+        // round trip to interleaved layout
+        array_nd<V, 2> back = planar.interleaved();
+        rgb(1, 2) = V{-1.0f, -2.0f, -3.0f};
+        rgb(0, 0) = rgb(1, 2);
+        EXPECT_EQ(back, rgb);
+
+        // copies own their data
+        planar_array_nd<float, 3, 2> copy(planar), moved(std::move(copy));
+        moved(3, 4) = V(3, 0.0f);
+        EXPECT_EQ(planar(3, 4).get(), rgb(3, 4));
+        EXPECT_EQ(moved(3, 4).get(), V(3, 0.0f));
+
+        // wrap an existing channel-first array
+        array_nd<float, 3> data(shape_t<3>{3, 4, 5}, 1.0f);
+        planar_view_nd<float, 3, 2> wrapped(data);
+        wrapped(2, 3) = V{1.0f, 2.0f, 3.0f};
+        EXPECT_EQ(data(2, 2, 3), 3.0f);
+    }
+
+    TEST(planar_array, planes)
+    {
+        using V = tiny_vector<float, 3>;
+        array_nd<V, 2> rgb(shape_t<2>{20, 30});
+        for(index_t k=0; k<rgb.size(); ++k)
+        {
+            rgb.raw_data()[k] = V{float(k % 7), float(k % 11), float(k % 13)};
+        }
+
+        planar_array_nd<float, 3, 2> planar(rgb), smoothed(planar.shape());
+        auto kernel = gaussian_kernel_1d<float>(1.5);
+        for_each_plane(planar, smoothed, [&](auto const & in, auto out)
+        {
+            separable_convolution(in, out, kernel);
+        });
+
+        for(index_t c=0; c<3; ++c)
+        {
+            array_nd<float, 2> reference(rgb.shape());
+            separable_convolution(rgb.bind_channel(c), reference, kernel);
+            EXPECT_TRUE(allclose(smoothed.channel(c), reference, 1e-5, 1e-5));
+        }
+
+        index_t count = 0;
+        for_each_plane(smoothed, [&](auto plane)
+        {
+            EXPECT_EQ(plane.shape(), planar.shape());
+            ++count;
+        });
+        EXPECT_EQ(count, 3);
+    }
+} // namespace xvigra
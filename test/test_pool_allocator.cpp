@@ -0,0 +1,124 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <thread>
+#include "unittest.hpp"
+#include <xvigra/array_nd.hpp>
+#include <xvigra/pool_allocator.hpp>
+#include <xvigra/separable_convolution.hpp>
+
+namespace xvigra
+{
+    TEST(pool_allocator, size_classes)
+    {
+        std::size_t block_size = 0;
+        EXPECT_EQ(detail::memory_pool::size_class(1, block_size), 0u);
+        EXPECT_EQ(block_size, 64u);
+        EXPECT_EQ(detail::memory_pool::size_class(65, block_size), 1u);
+        EXPECT_EQ(block_size, 80u);
+        EXPECT_EQ(detail::memory_pool::size_class(112, block_size), 3u);
+        EXPECT_EQ(block_size, 112u);
+        EXPECT_EQ(detail::memory_pool::size_class(113, block_size), 4u);
+        EXPECT_EQ(block_size, 128u);
+
+        for(std::size_t bytes: {100u, 1000u, 12345u, 1000000u})
+        {
+            detail::memory_pool::size_class(bytes, block_size);
+            EXPECT_TRUE(block_size >= bytes && block_size < bytes + bytes / 4 + 64);
+        }
+    }
+
+    TEST(pool_allocator, reuse)
+    {
+        release_pool_memory();
+        reset_pool_allocator_statistics();
+        pool_statistics start = pool_allocator_statistics();
+
+        using array_t = array_nd<float, 2, pool_allocator<float>>;
+        float * first = 0;
+        {
+            array_t a(shape_t<2>{100, 200}, 1.0f);
+            first = a.raw_data();
+            EXPECT_EQ((std::uintptr_t)first % detail::memory_pool::alignment, 0u);
+        }
+        pool_statistics stats = pool_allocator_statistics();
+        EXPECT_EQ(stats.allocations - start.allocations, 1);
+        EXPECT_EQ(stats.pool_hits - start.pool_hits, 0);
+        EXPECT_EQ(stats.current_bytes, start.current_bytes);
+        EXPECT_TRUE(stats.peak_bytes >= start.current_bytes + 100*200*(index_t)sizeof(float));
+        EXPECT_TRUE(stats.retained_bytes >= 100*200*(index_t)sizeof(float));
+
+        {
+            // same size class => same block
+            array_t b(shape_t<2>{200, 100});
+            EXPECT_EQ(b.raw_data(), first);
+        }
+        stats = pool_allocator_statistics();
+        EXPECT_EQ(stats.allocations - start.allocations, 2);
+        EXPECT_EQ(stats.pool_hits - start.pool_hits, 1);
+
+        // other threads have their own pool
+        std::thread t([first]()
+        {
+            array_t c(shape_t<2>{100, 200});
+            EXPECT_NE(c.raw_data(), first);
+            EXPECT_EQ(pool_allocator_statistics().pool_hits, 0);
+        });
+        t.join();
+
+        release_pool_memory();
+        EXPECT_EQ(pool_allocator_statistics().retained_bytes, 0);
+    }
+
+    TEST(pool_allocator, temporaries)
+    {
+        array_nd<float, 3> in(shape_t<3>{20, 30, 40}, 1.0f), out(in.shape());
+        auto kernel = gaussian_kernel_1d<float>(1.0);
+
+        // the first call fills the pool, repeated calls reuse its blocks
+        separable_convolution(in, out, kernel);
+        reset_pool_allocator_statistics();
+        separable_convolution(in, out, kernel);
+        pool_statistics stats = pool_allocator_statistics();
+        EXPECT_TRUE(stats.allocations > 0);
+        EXPECT_EQ(stats.pool_hits, stats.allocations);
+        EXPECT_TRUE(allclose(out, 1.0f));
+
+        // without retention, every temporary goes back to the system
+        pool_allocator_options saved = default_pool_allocator_options();
+        default_pool_allocator_options().enabled = false;
+        release_pool_memory();
+        reset_pool_allocator_statistics();
+        separable_convolution(in, out, kernel);
+        EXPECT_EQ(pool_allocator_statistics().pool_hits, 0);
+        EXPECT_EQ(pool_allocator_statistics().retained_bytes, 0);
+        default_pool_allocator_options() = saved;
+    }
+} // namespace xvigra
@@ -0,0 +1,133 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <random>
+#include "unittest.hpp"
+#include <xvigra/pyramid.hpp>
+#include <xvigra/separable_convolution.hpp>
+
+namespace xvigra
+{
+    TEST(pyramid, gaussian)
+    {
+        using namespace slicing;
+
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+        array_nd<float, 2> image(shape_t<2>{37, 20});
+        for(auto & v : image)
+        {
+            v = uniform(rng);
+        }
+
+        gaussian_pyramid<float, 2> pyramid(image, 4);
+        EXPECT_EQ(pyramid.size(), 4);
+        EXPECT_EQ(pyramid.shape(1), (shape_t<2>{19, 10}));
+        EXPECT_EQ(pyramid.shape(2), (shape_t<2>{10, 5}));
+        EXPECT_EQ(pyramid.shape(3), (shape_t<2>{5, 3}));
+        EXPECT_EQ(pyramid.arena_size(), 37*20 + 19*10 + 10*5 + 5*3);
+        EXPECT_EQ(pyramid[0], image);
+
+        // same result as smoothing followed by subsampling
+        kernel_1d<float> kernel(5, 2);
+        kernel(0) = kernel(4) = 1.0f / 16.0f;
+        kernel(1) = kernel(3) = 4.0f / 16.0f;
+        kernel(2) = 6.0f / 16.0f;
+        array_nd<float, 2> smoothed(image.shape());
+        separable_convolution(image, smoothed, kernel);
+        EXPECT_TRUE(allclose(pyramid[1], smoothed.view(slice(_,_,2), slice(_,_,2)), 1e-5, 1e-6));
+
+        // the number of levels is limited by the input size
+        array_nd<double, 1> line(shape_t<1>{9});
+        line = 2.0;
+        gaussian_pyramid<double> line_pyramid(line);
+        EXPECT_EQ(line_pyramid.size(), 5);
+        EXPECT_EQ(line_pyramid.shape(4), (shape_t<>{1}));
+        for(index_t l=0; l<line_pyramid.size(); ++l)
+        {
+            for(auto v : line_pyramid[l])
+            {
+                EXPECT_NEAR(v, 2.0, 1e-12);
+            }
+        }
+    }
+
+    TEST(pyramid, laplacian)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        array_nd<double, 3> volume(shape_t<3>{13, 16, 21});
+        for(auto & v : volume)
+        {
+            v = uniform(rng);
+        }
+
+        laplacian_pyramid<double, 3> pyramid(volume, 3);
+        gaussian_pyramid<double, 3> gaussian(volume, 3);
+        EXPECT_EQ(pyramid.size(), 3);
+        EXPECT_EQ(pyramid[2], gaussian[2]);
+        EXPECT_TRUE(allclose(pyramid.reconstruct(), volume, 1e-12, 1e-12));
+    }
+
+    TEST(pyramid, multi_channel)
+    {
+        using namespace slicing;
+
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+        array_nd<float, 3> rgb(shape_t<3>{16, 11, 3});
+        for(auto & v : rgb)
+        {
+            v = uniform(rng);
+        }
+
+        gaussian_pyramid<float, 3> pyramid(2_d, rgb, 3);
+        EXPECT_EQ(pyramid.spatial_dimension(), 2);
+        EXPECT_EQ(pyramid.shape(1), (shape_t<3>{8, 6, 3}));
+        EXPECT_EQ(pyramid.shape(2), (shape_t<3>{4, 3, 3}));
+        for(index_t c=0; c<3; ++c)
+        {
+            array_nd<float, 2> channel(rgb.view(all(), all(), c));
+            gaussian_pyramid<float, 2> single(channel, 3);
+            for(index_t l=0; l<3; ++l)
+            {
+                EXPECT_TRUE(allclose(pyramid[l].view(all(), all(), c), single[l], 1e-6, 1e-7));
+            }
+        }
+
+        laplacian_pyramid<float, 3> laplacian(2_d, rgb);
+        EXPECT_TRUE(allclose(laplacian.reconstruct(), rgb, 1e-5, 1e-6));
+
+        EXPECT_THROW(gaussian_pyramid<float>(1_d, rgb), std::runtime_error);
+    }
+} // namespace xvigra
@@ -0,0 +1,128 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <random>
+#include "unittest.hpp"
+#include <xvigra/recursive_filter.hpp>
+#include <xvigra/splines.hpp>
+
+namespace xvigra
+{
+    template <int ORDER>
+    kernel_1d<double> sampled_b_spline_kernel()
+    {
+        b_spline<ORDER, double> spline;
+        index_t radius = (index_t)spline.radius();
+        kernel_1d<double> kernel(2*radius+1, radius);
+        for(index_t k=-radius; k<=radius; ++k)
+        {
+            kernel(k+radius) = spline(k);
+        }
+        return kernel;
+    }
+
+    TEST(recursive_filter, spline_prefilter_1d)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        for(index_t size : {2, 3, 7, 100})
+        {
+            array_nd<double, 1> data(shape_t<1>{size}), coeffs(data.shape()), res(data.shape());
+            for(auto & v : data)
+            {
+                v = uniform(rng);
+            }
+
+            spline_prefilter(data, coeffs, b_spline<3, double>());
+            separable_convolution(coeffs, res, sampled_b_spline_kernel<3>());
+            EXPECT_TRUE(allclose(res, data, 1e-10, 1e-12));
+
+            if(size > 3)
+            {
+                spline_prefilter(data, coeffs, b_spline<5, double>());
+                separable_convolution(coeffs, res, sampled_b_spline_kernel<5>());
+                EXPECT_TRUE(allclose(res, data, 1e-10, 1e-12));
+            }
+        }
+    }
+
+    TEST(recursive_filter, spline_prefilter_3d)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+        array_nd<float, 3> data(shape_t<3>{20, 9, 33}), res(data.shape());
+        for(auto & v : data)
+        {
+            v = uniform(rng);
+        }
+
+        // in-place
+        array_nd<float, 3> coeffs(data);
+        spline_prefilter(coeffs, coeffs, b_spline<3, float>());
+        kernel_1d<float> kernel(3);
+        kernel(0) = kernel(2) = 1.0f / 6.0f;
+        kernel(1) = 2.0f / 3.0f;
+        separable_convolution(coeffs, res, kernel);
+        EXPECT_TRUE(allclose(res, data, 1e-4, 1e-5));
+
+        // constant signals pass unchanged, regardless of the border treatment
+        array_nd<float, 3> constant(data.shape(), 2.0f);
+        for(auto border : {reflect_padding, repeat_padding})
+        {
+            recursive_filter(constant, res, std::vector<double>{-0.43, -0.043}, border);
+            EXPECT_TRUE(allclose(res, constant, 1e-5, 1e-5));
+        }
+    }
+
+    TEST(recursive_filter, line_and_column_paths)
+    {
+        // the innermost axis is filtered line by line, the others row-wise;
+        // filtering the transposed array swaps the code paths of the two axes
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        for(index_t size : {5, 80})
+        {
+            array_nd<double, 2> data(shape_t<2>{size, 7}), res1(data.shape()), res2(data.shape());
+            for(auto & v : data)
+            {
+                v = uniform(rng);
+            }
+            for(auto border : {reflect_padding, repeat_padding, zero_padding})
+            {
+                recursive_filter(data, res1, std::vector<double>{-0.27, -0.01}, border);
+                recursive_filter(data.transpose(), res2.transpose(), std::vector<double>{-0.27, -0.01}, border);
+                EXPECT_TRUE(allclose(res1, res2, 1e-12, 1e-14));
+            }
+        }
+    }
+} // namespace xvigra
@@ -0,0 +1,145 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <numeric>
+#include "unittest.hpp"
+#include <xtensor/xmath.hpp>
+#include <xvigra/reduction.hpp>
+
+namespace xvigra
+{
+    TEST(reduction, sum_and_norms)
+    {
+        using namespace slicing;
+        array_nd<float, 3> a(shape_t<3>{9, 40, 70});
+        std::iota(a.begin(), a.end(), -5000.0f);
+        a /= 100.0f;
+
+        xt::xarray<double> ad = xt::cast<double>(a);
+        double s = xt::sum(ad)(),
+               l1 = xt::sum(xt::abs(ad))(),
+               l2 = std::sqrt(xt::sum(ad*ad)());
+
+        for(index_t threads: {1, 3, 8})
+        {
+            reduction_options options;
+            options.threads(threads).min_elements_per_thread = 100;
+
+            EXPECT_NEAR(reduce::sum(a, options), s, 1e-5*std::abs(s));
+            EXPECT_NEAR(reduce::mean(a, options), s / a.size(), 1e-5*std::abs(s / a.size()));
+            EXPECT_NEAR(reduce::norm_l1(a, options), l1, 1e-5*l1);
+            EXPECT_NEAR(reduce::norm_l2(a, options), l2, 1e-5*l2);
+            EXPECT_EQ(reduce::norm_linf(a, options), std::max(std::abs(a(0,0,0)), std::abs(a(8,39,69))));
+
+            // strided and transposed views
+            auto v = a.view(range(1, 8, 2), all(), range(69, _, -3));
+            xt::xarray<double> vd = xt::cast<double>(v);
+            EXPECT_NEAR(reduce::sum(v, options), xt::sum(vd)(), 1e-5*std::abs(xt::sum(vd)()));
+            EXPECT_NEAR(reduce::sum(a.transpose(), options), s, 1e-5*std::abs(s));
+            EXPECT_NEAR(reduce::norm_l1(v, options), xt::sum(xt::abs(vd))(), 1e-5*xt::sum(xt::abs(vd))());
+
+            options.use_simd(false);
+            EXPECT_NEAR(reduce::sum(a, options), s, 1e-5*std::abs(s));
+        }
+
+        array_nd<uint8_t, 2> b(shape_t<2>{300, 300}, uint8_t(255));
+        EXPECT_EQ(reduce::sum(b), 255ull*300*300);
+        EXPECT_EQ(reduce::norm_linf(b), 255ull);
+    }
+
+    TEST(reduction, minmax)
+    {
+        using namespace slicing;
+        array_nd<int, 3> a(shape_t<3>{6, 50, 30});
+        for(index_t k=0; k<a.size(); ++k)
+        {
+            a.raw_data()[k] = int((k * 7919) % 10007) - 5000;
+        }
+        a(2, 10, 5)  = -7000;
+        a(4, 30, 11) = 9000;
+        a(5, 31, 12) = 9000;  // tie, later in c-order
+
+        for(index_t threads: {1, 4})
+        {
+            reduction_options options;
+            options.threads(threads).min_elements_per_thread = 64;
+
+            auto mM = reduce::minmax(a, options);
+            EXPECT_EQ(mM[0], -7000);
+            EXPECT_EQ(mM[1], 9000);
+            EXPECT_EQ(reduce::argmin(a, options), (shape_t<>{2, 10, 5}));
+            EXPECT_EQ(reduce::argmax(a, options), (shape_t<>{4, 30, 11}));
+
+            // non-contiguous views report coordinates in the view
+            auto t = a.transpose();
+            EXPECT_EQ(reduce::argmax(t, options), (shape_t<>{11, 30, 4}));
+            auto v = a.view(range(1, _), range(49, _, -1), all());
+            EXPECT_EQ(reduce::argmin(v, options), (shape_t<>{1, 39, 5}));
+        }
+
+        array_nd<float, 2> c(shape_t<2>{100, 100}, 3.0f);
+        EXPECT_EQ(reduce::argmin(c), (shape_t<>{0, 0}));
+        EXPECT_EQ(reduce::argmax(c.transpose()), (shape_t<>{0, 0}));
+        auto cM = reduce::minmax(c);
+        EXPECT_EQ(cM[0], 3.0f);
+        EXPECT_EQ(cM[1], 3.0f);
+    }
+
+    TEST(reduction, histogram)
+    {
+        array_nd<double, 2> a(shape_t<2>{256, 300});
+        for(index_t k=0; k<a.size(); ++k)
+        {
+            a.raw_data()[k] = (k % 64) / 8.0;  // 0.0 ... 7.875
+        }
+        std::size_t count = a.size() / 64;   // occurrences of each value
+
+        reduction_options options;
+        options.threads(4).min_elements_per_thread = 1000;
+
+        auto h = reduce::histogram(a, 8, 0.0, 8.0, options);
+        EXPECT_EQ(h.size(), 8u);
+        for(auto c: h)
+        {
+            EXPECT_EQ(c, 8*count);
+        }
+
+        // values outside the range are ignored, upper goes into the last bin
+        auto h2 = reduce::histogram(a.transpose(), 4, 2.0, 4.0, options);
+        EXPECT_EQ(h2[0], 4*count);
+        EXPECT_EQ(h2[3], 5*count);
+        EXPECT_EQ(std::accumulate(h2.begin(), h2.end(), std::size_t(0)), 17*count);
+
+        // range from the data
+        auto h3 = reduce::histogram(a, 2);
+        EXPECT_EQ(h3[0], 32*count);
+        EXPECT_EQ(h3[1], 32*count);
+    }
+} // namespace xvigra
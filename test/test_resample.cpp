@@ -0,0 +1,159 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <random>
+#include "unittest.hpp"
+#include <xvigra/resample.hpp>
+
+namespace xvigra
+{
+    TEST(resample, weights)
+    {
+        // 10 -> 4 with aligned corners: x_j = 3*j
+        auto w1 = detail::make_resample_weights(b_spline<1, double>(), 10, 4, true, 0.0);
+        EXPECT_EQ(w1.period, 1);
+        EXPECT_EQ(w1.ksize, 3);
+        EXPECT_EQ(w1.first, (std::vector<index_t>{-1, 2, 5, 8}));
+        EXPECT_EQ(w1[0][1], 1.0);
+
+        // 10 -> 4 with aligned centers: x_j = (10*j + 3) / 4, period 2
+        auto w2 = detail::make_resample_weights(b_spline<1, double>(), 10, 4, false, 0.0);
+        EXPECT_EQ(w2.period, 2);
+        EXPECT_EQ(w2.first, (std::vector<index_t>{-1, 2, 4, 7}));
+        EXPECT_NEAR(w2[0][1], 0.25, 1e-15);
+        EXPECT_NEAR(w2[0][2], 0.75, 1e-15);
+        EXPECT_NEAR(w2[1][1], 0.75, 1e-15);
+        EXPECT_NEAR(w2[1][2], 0.25, 1e-15);
+        EXPECT_EQ(w2[2], w2[0]);
+
+        // all weights sum to one, also with anti-aliasing
+        auto w3 = detail::make_resample_weights(b_spline<3, double>(), 100, 30, false, 1.5);
+        for(index_t p=0; p<w3.period; ++p)
+        {
+            double sum = 0.0;
+            for(index_t k=0; k<w3.ksize; ++k)
+            {
+                sum += w3[p][k];
+            }
+            EXPECT_NEAR(sum, 1.0, 1e-12);
+        }
+    }
+
+    TEST(resample, interpolation)
+    {
+        array_nd<double, 1> line(shape_t<1>{5}), res(shape_t<1>{9});
+        for(index_t k=0; k<5; ++k)
+        {
+            line(k) = 2.0*k + 1.0;
+        }
+
+        resize(line, res, 1);
+        for(index_t k=0; k<9; ++k)
+        {
+            EXPECT_NEAR(res(k), k + 1.0, 1e-12);
+        }
+
+        // the original samples are reproduced exactly
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        array_nd<double, 2> data(shape_t<2>{10, 12}), large(shape_t<2>{19, 34});
+        for(auto & v : data)
+        {
+            v = uniform(rng);
+        }
+        resize(data, large);
+        for(index_t y=0; y<10; ++y)
+        {
+            for(index_t x=0; x<12; ++x)
+            {
+                EXPECT_NEAR(large(2*y, 3*x), data(y, x), 1e-10);
+            }
+        }
+
+        array_nd<double, 2> same(data.shape());
+        resample(data, same, catmull_rom_spline<double>());
+        EXPECT_EQ(same, data);
+    }
+
+    TEST(resample, spline_view)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        array_nd<float, 3> data(shape_t<3>{8, 12, 15});
+        for(auto & v : data)
+        {
+            v = (float)uniform(rng);
+        }
+
+        // without anti-aliasing, the result must be identical to point-wise evaluation
+        spline_view_nd<3, float, 3> spline(data);
+        array_nd<float, 3> res(shape_t<3>{11, 7, 20});
+        resample(data, res, b_spline<3, double>(), resample_options().anti_alias(false).align_corners(false));
+        for(index_t z=0; z<res.shape(0); ++z)
+        {
+            for(index_t y=0; y<res.shape(1); ++y)
+            {
+                for(index_t x=0; x<res.shape(2); ++x)
+                {
+                    tiny_vector<double, 3> p{(z + 0.5)*8.0/11.0 - 0.5,
+                                             (y + 0.5)*12.0/7.0 - 0.5,
+                                             (x + 0.5)*15.0/20.0 - 0.5};
+                    EXPECT_NEAR(res(z, y, x), spline(p), 1e-5);
+                }
+            }
+        }
+    }
+
+    TEST(resample, anti_aliasing)
+    {
+        array_nd<uint8_t, 2> data(shape_t<2>{40, 60}), res(shape_t<2>{13, 20});
+        data = 200;
+        resample(data, res, b_spline<3, double>());
+        EXPECT_TRUE(all(equal(res, 200)));
+
+        // a checkerboard is smoothed to a nearly constant image
+        array_nd<float, 2> board(shape_t<2>{64, 64}), small(shape_t<2>{16, 16});
+        for(index_t y=0; y<64; ++y)
+        {
+            for(index_t x=0; x<64; ++x)
+            {
+                board(y, x) = (x + y) % 2 ? 1.0f : 0.0f;
+            }
+        }
+        resample(board, small, b_spline<1, double>(), resample_options().align_corners(false));
+        for(auto v : small)
+        {
+            EXPECT_NEAR(v, 0.5f, 1e-2);
+        }
+
+        EXPECT_THROW(resize(board, small, 7), std::runtime_error);
+    }
+} // namespace xvigra
@@ -98,4 +98,131 @@ namespace xvigra
         separable_convolution(2_d, in, out, kernel);
         write_image("smooth.png", out);
     }
+
+    TEST(separable_convolution, algorithms)
+    {
+        array_nd<float, 2> in(shape_t<2>{40, 48});
+        for(index_t i=0; i<in.shape(0); ++i)
+        {
+            for(index_t j=0; j<in.shape(1); ++j)
+            {
+                in(i, j) = std::sin(0.7f*i) + std::cos(1.3f*j) + 0.1f*(i*j % 7);
+            }
+        }
+
+        kernel_1d<float> skewed(9, 2);
+        for(index_t k=0; k<9; ++k)
+        {
+            skewed(k) = 1.0f + 0.1f*k;
+        }
+
+        std::vector<kernel_1d<float>> kernels{
+            gaussian_kernel_1d<float>(2.0),
+            gaussian_derivative_kernel_1d<float>(2.0, 1),
+            gaussian_derivative_kernel_1d<float>(2.0, 2),
+            skewed
+        };
+        EXPECT_EQ(detail::kernel_symmetry(kernels[0]), 1);
+        EXPECT_EQ(detail::kernel_symmetry(kernels[1]), -1);
+        EXPECT_EQ(detail::kernel_symmetry(kernels[2]), 1);
+        EXPECT_EQ(detail::kernel_symmetry(kernels[3]), 0);
+
+        for(auto padding: {reflect_padding, reflect0_padding, repeat_padding, periodic_padding, zero_padding})
+        {
+            for(auto const & kernel: kernels)
+            {
+                array_nd<float, 2> direct(in.shape(), 0.0f), symmetric(in.shape(), 0.0f), fft(in.shape(), 0.0f);
+                separable_convolution(in, direct, kernel,
+                                      convolution_options().padding(padding).use_algorithm(direct_convolution));
+                separable_convolution(in, symmetric, kernel,
+                                      convolution_options().padding(padding).use_algorithm(symmetric_convolution));
+                separable_convolution(in, fft, kernel,
+                                      convolution_options().padding(padding).use_algorithm(fft_convolution));
+                EXPECT_TRUE(allclose(direct, symmetric, 1e-4, 1e-4));
+                EXPECT_TRUE(allclose(direct, fft, 1e-4, 1e-4));
+            }
+        }
+
+        // different algorithms per axis
+        array_nd<float, 2> direct(in.shape(), 0.0f), mixed(in.shape(), 0.0f);
+        separable_convolution(in, direct, kernels[0], convolution_options().use_algorithm(direct_convolution));
+        separable_convolution(in, mixed, kernels[0],
+            convolution_options().use_algorithm(tiny_vector<convolution_algorithm, 2>{fft_convolution, symmetric_convolution}));
+        EXPECT_TRUE(allclose(direct, mixed, 1e-4, 1e-4));
+    }
+
+    TEST(separable_convolution, expression_input)
+    {
+        array_nd<float, 3> a(shape_t<3>{6, 20, 30}), b(a.shape()), c(a.shape()),
+                           expected(a.shape()), out(a.shape());
+        index_t k = 0;
+        for(auto & v: a)
+        {
+            v = std::sin(0.1f*k++);
+        }
+        k = 0;
+        for(auto & v: b)
+        {
+            v = 1.0f + (k++ % 5);
+        }
+        for(index_t i=0; i<a.shape(0); ++i)
+        {
+            for(index_t j=0; j<a.shape(1); ++j)
+            {
+                for(index_t l=0; l<a.shape(2); ++l)
+                {
+                    c(i, j, l) = a(i, j, l)*b(i, j, l) + 1.0f;
+                }
+            }
+        }
+
+        auto kernel = gaussian_kernel_1d<float>(1.5);
+        for(auto algorithm: {direct_convolution, symmetric_convolution, fft_convolution})
+        {
+            auto options = convolution_options().use_algorithm(algorithm);
+            separable_convolution(c, expected, kernel, options);
+            separable_convolution(a*b + 1.0f, out, kernel, options);
+            EXPECT_TRUE(allclose(out, expected, 1e-5, 1e-5));
+        }
+
+        // the expression may refer to the output
+        separable_convolution(a*b + 1.0f, a, kernel);
+        EXPECT_TRUE(allclose(a, expected, 1e-5, 1e-5));
+    }
+
+    TEST(separable_convolution, plan)
+    {
+        shape_t<> shape{512, 512};
+        auto p = separable_convolution.plan(shape, gaussian_kernel_1d<float>(1.0));
+        EXPECT_EQ(p.size(), 2);
+        EXPECT_EQ(p[0].axis, 0);
+        EXPECT_EQ(p[1].axis, 1);
+        EXPECT_EQ(p[0].kernel_size, 7);
+        EXPECT_EQ(p[0].line_length, 512);
+        EXPECT_EQ(p[0].algorithm, direct_convolution);
+
+        p = separable_convolution.plan(shape, gaussian_kernel_1d<float>(5.0));
+        EXPECT_EQ(p[0].algorithm, symmetric_convolution);
+
+        p = separable_convolution.plan(shape, gaussian_kernel_1d<float>(40.0));
+        EXPECT_EQ(p[0].algorithm, fft_convolution);
+        EXPECT_EQ(to_string(p[0]).substr(0, 11), "axis 0: fft");
+
+        // symmetric convolution is not applicable to a skewed kernel
+        kernel_1d<float> skewed(31, 10);
+        for(index_t k=0; k<31; ++k)
+        {
+            skewed(k) = 1.0f;
+        }
+        p = separable_convolution.plan(shape, skewed);
+        EXPECT_EQ(p[0].algorithm, direct_convolution);
+        p = separable_convolution.plan(shape, skewed, convolution_options().use_algorithm(symmetric_convolution));
+        EXPECT_EQ(p[0].algorithm, direct_convolution);
+
+        // the cost model can be overridden
+        convolution_cost_model model;
+        model.fft_per_stage = 0.0;
+        p = separable_convolution.plan(shape, gaussian_kernel_1d<float>(1.0), convolution_options().use_cost_model(model));
+        EXPECT_EQ(p[0].algorithm, fft_convolution);
+    }
 } // namespace xvigra
@@ -0,0 +1,175 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <random>
+#include "unittest.hpp"
+#include <xvigra/spline_view.hpp>
+
+namespace xvigra
+{
+    template <int ORDER>
+    void test_spline_view_interpolation(array_nd<double, 2> const & data)
+    {
+        spline_view_nd<ORDER, double, 2> spline(data);
+        for(index_t y=0; y<data.shape()[0]; ++y)
+        {
+            for(index_t x=0; x<data.shape()[1]; ++x)
+            {
+                EXPECT_NEAR(spline({(double)y, (double)x}), data(y, x), 1e-10);
+            }
+        }
+    }
+
+    TEST(spline_view, interpolation)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        array_nd<double, 2> data(shape_t<2>{7, 9});
+        for(auto & v : data)
+        {
+            v = uniform(rng);
+        }
+
+        test_spline_view_interpolation<0>(data);
+        test_spline_view_interpolation<1>(data);
+        test_spline_view_interpolation<2>(data);
+        test_spline_view_interpolation<3>(data);
+        test_spline_view_interpolation<5>(data);
+
+        // already prefiltered data are used as is
+        spline_view_nd<3, double, 2> prefiltered(data, true);
+        EXPECT_TRUE(allclose(prefiltered.coefficients(), data));
+
+        // coordinates outside the array are mirrored at the borders
+        spline_view_nd<3, double, 2> spline(data);
+        EXPECT_NEAR(spline({-1.25, 2.5}), spline({1.25, 2.5}), 1e-12);
+        EXPECT_NEAR(spline({3.5, 9.75}), spline({3.5, 6.25}), 1e-12);
+        EXPECT_TRUE(spline.is_inside({0.0, 8.0}));
+        EXPECT_FALSE(spline.is_inside({-0.5, 8.0}));
+    }
+
+    TEST(spline_view, derivatives)
+    {
+        // a quadratic polynomial is reproduced exactly away from the borders
+        array_nd<double, 2> data(shape_t<2>{40, 40});
+        for(index_t y=0; y<40; ++y)
+        {
+            for(index_t x=0; x<40; ++x)
+            {
+                data(y, x) = 0.5*y*y + y*x - 0.25*x*x + 3.0;
+            }
+        }
+
+        spline_view_nd<3, double, 2> spline(data);
+        for(double y=15.0; y<25.0; y+=0.7)
+        {
+            for(double x=15.0; x<25.0; x+=0.45)
+            {
+                EXPECT_NEAR(spline({y, x}), 0.5*y*y + y*x - 0.25*x*x + 3.0, 1e-4);
+                EXPECT_NEAR(spline.dx({y, x}, 0), y + x, 1e-4);
+                EXPECT_NEAR(spline.dx({y, x}, 1), y - 0.5*x, 1e-4);
+                EXPECT_NEAR(spline.dxx({y, x}, 0), 1.0, 1e-4);
+                EXPECT_NEAR(spline.dxx({y, x}, 1), -0.5, 1e-4);
+                EXPECT_NEAR(spline.dxy({y, x}, 0, 1), 1.0, 1e-4);
+            }
+        }
+    }
+
+    TEST(spline_view, batch)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        array_nd<float, 3> data(shape_t<3>{6, 8, 10});
+        for(auto & v : data)
+        {
+            v = (float)uniform(rng);
+        }
+
+        spline_view_nd<3, float> spline(data);
+        EXPECT_EQ(spline.dimension(), 3);
+
+        index_t count = 200;
+        array_nd<double, 2> points(shape_t<2>{count, 3});
+        for(index_t j=0; j<count; ++j)
+        {
+            for(index_t d=0; d<3; ++d)
+            {
+                points(j, d) = -1.0 + uniform(rng)*(data.shape()[d] + 1.0);
+            }
+        }
+
+        array_nd<float, 1> values(shape_t<1>{count}), gradient(shape_t<1>{count});
+        spline(points, values);
+        spline(points, gradient, shape_t<>{0, 0, 1});
+        for(index_t j=0; j<count; ++j)
+        {
+            tiny_vector<double> p{points(j, 0), points(j, 1), points(j, 2)};
+            EXPECT_NEAR(values(j), spline(p), 1e-5);
+            EXPECT_NEAR(gradient(j), spline.dx(p, 2), 1e-5);
+        }
+
+        array_nd<float, 1> too_short(shape_t<1>{10});
+        EXPECT_THROW(spline(points, too_short), std::runtime_error);
+    }
+
+    TEST(spline_view, batch_2d)
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+        // the second shape is smaller than the kernel and uses the mirrored path throughout
+        for(auto shape : {shape_t<2>{30, 40}, shape_t<2>{2, 40}})
+        {
+            array_nd<float, 2> data(shape);
+            for(auto & v : data)
+            {
+                v = (float)uniform(rng);
+            }
+            spline_view_nd<2, float, 2> spline(data);
+
+            index_t count = 300;
+            array_nd<double, 2> points(shape_t<2>{count, 2});
+            for(index_t j=0; j<count; ++j)
+            {
+                points(j, 0) = -2.0 + uniform(rng)*(shape[0] + 3.0);
+                points(j, 1) = -2.0 + uniform(rng)*(shape[1] + 3.0);
+            }
+
+            array_nd<float, 1> values(shape_t<1>{count});
+            spline(points, values, shape_t<2>{1, 0});
+            for(index_t j=0; j<count; ++j)
+            {
+                EXPECT_NEAR(values(j), spline.dx({points(j, 0), points(j, 1)}, 0), 1e-5);
+            }
+        }
+    }
+} // namespace xvigra
@@ -119,4 +119,45 @@ namespace xvigra
             }
         }
     }
+
+    TYPED_TEST(spline_test, batch_weights)
+    {
+        using BS = TypeParam;
+        static constexpr int ORDER = BS::static_order;
+
+        BS spline;
+
+        index_t n = 37;
+        double lower = (ORDER % 2 == 1) ? 0.0 : -0.5;
+        array_nd<double, 1> offsets(shape_t<1>{n});
+        for(index_t j = 0; j < n; ++j)
+        {
+            offsets(j) = lower + j / (double)n;
+        }
+
+        // derivatives up to ORDER-1 are continuous at the knots
+        array_nd<double, 2> weights(shape_t<2>{ORDER+1, n});
+        for(int d = 0; d <= std::min(2, ORDER-1) || d == 0; ++d)
+        {
+            b_spline_weights<ORDER>(offsets, weights, d);
+            for(index_t j = 0; j < n; ++j)
+            {
+                for(int k = 0; k <= ORDER; ++k)
+                {
+                    EXPECT_NEAR(weights(k, j), spline(offsets(j) + ORDER / 2 - k, d), 1e-12);
+                }
+            }
+        }
+
+        // non-contiguous arguments
+        array_nd<double, 2> transposed(shape_t<2>{n, ORDER+1});
+        b_spline_weights<ORDER>(offsets, transposed.transpose());
+        for(index_t j = 0; j < n; ++j)
+        {
+            for(int k = 0; k <= ORDER; ++k)
+            {
+                EXPECT_NEAR(transposed(j, k), spline(offsets(j) + ORDER / 2 - k), 1e-12);
+            }
+        }
+    }
 } // namespace xvigra
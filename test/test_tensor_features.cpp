@@ -0,0 +1,260 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include <cmath>
+#include "unittest.hpp"
+#include <xvigra/tensor_features.hpp>
+
+namespace xvigra
+{
+    TEST(tensor_features, eigenvalues)
+    {
+        // rotated diag(3, 1)
+        double c = std::cos(0.3), s = std::sin(0.3);
+        tiny_vector<double, 3> t2{3.0*c*c + s*s, 2.0*c*s, 3.0*s*s + c*c};
+        auto ev2 = symmetric_eigenvalues(t2);
+        EXPECT_NEAR(ev2[0], 3.0, 1e-14);
+        EXPECT_NEAR(ev2[1], 1.0, 1e-14);
+
+        tiny_vector<double, 6> t3{2.0, 1.0, 0.0, 2.0, 0.0, 5.0};
+        auto ev3 = symmetric_eigenvalues(t3);
+        EXPECT_NEAR(ev3[0], 5.0, 1e-12);
+        EXPECT_NEAR(ev3[1], 3.0, 1e-12);
+        EXPECT_NEAR(ev3[2], 1.0, 1e-12);
+
+        tiny_vector<double, 6> diag{1.0, 0.0, 0.0, 3.0, 0.0, 2.0};
+        ev3 = symmetric_eigenvalues(diag);
+        EXPECT_NEAR(ev3[0], 3.0, 1e-12);
+        EXPECT_NEAR(ev3[1], 2.0, 1e-12);
+        EXPECT_NEAR(ev3[2], 1.0, 1e-12);
+
+        // multiple of the identity must not produce NaNs
+        tiny_vector<float, 6> identity{2.0f, 0.0f, 0.0f, 2.0f, 0.0f, 2.0f};
+        auto evi = symmetric_eigenvalues(identity);
+        for(index_t k=0; k<3; ++k)
+        {
+            EXPECT_NEAR(evi[k], 2.0f, 1e-6f);
+        }
+
+        // SoA evaluation, long enough for SIMD batches and scalar remainder
+        index_t size = 37;
+        std::vector<float> a00(size), a01(size), a11(size), e0(size), e1(size);
+        for(index_t k=0; k<size; ++k)
+        {
+            a00[k] = 1.0f + 0.1f*k;
+            a01[k] = std::sin(0.2f*k);
+            a11[k] = 2.0f - 0.05f*k;
+        }
+        float const * tensor[3] = { a00.data(), a01.data(), a11.data() };
+        float * ev[2] = { e0.data(), e1.data() };
+        detail::symmetric_eigenvalues_soa(tensor, 2, size, ev);
+        for(index_t k=0; k<size; ++k)
+        {
+            auto expected = symmetric_eigenvalues(tiny_vector<float, 3>{a00[k], a01[k], a11[k]});
+            EXPECT_NEAR(e0[k], expected[0], 1e-5f);
+            EXPECT_NEAR(e1[k], expected[1], 1e-5f);
+        }
+    }
+
+    TEST(tensor_features, structure_tensor)
+    {
+        shape_t<2> shape{40, 50};
+        array_nd<float, 2> image(shape);
+        for(index_t i=0; i<shape[0]; ++i)
+        {
+            for(index_t j=0; j<shape[1]; ++j)
+            {
+                image(i, j) = 2.0f*i + 1.0f*j;
+            }
+        }
+
+        array_nd<tiny_vector<float, 3>, 2> tensor(shape);
+        structure_tensor(image, tensor, 1.0, 2.0);
+        array_nd<tiny_vector<float, 2>, 2> ev(shape);
+        structure_tensor_eigenvalues(image, ev, 1.0, 2.0);
+
+        // the gradient of a ramp is exact away from the border
+        for(index_t i=15; i<shape[0]-15; ++i)
+        {
+            for(index_t j=15; j<shape[1]-15; ++j)
+            {
+                EXPECT_NEAR(tensor(i, j)[0], 4.0f, 1e-4f);
+                EXPECT_NEAR(tensor(i, j)[1], 2.0f, 1e-4f);
+                EXPECT_NEAR(tensor(i, j)[2], 1.0f, 1e-4f);
+                EXPECT_NEAR(ev(i, j)[0], 5.0f, 1e-4f);
+                EXPECT_NEAR(ev(i, j)[1], 0.0f, 1e-4f);
+            }
+        }
+
+        // the fused eigenvalue computation agrees with the two-step one everywhere
+        for(index_t i=0; i<shape[0]; ++i)
+        {
+            for(index_t j=0; j<shape[1]; ++j)
+            {
+                image(i, j) = std::sin(0.3f*i) * std::cos(0.2f*j);
+            }
+        }
+        structure_tensor(image, tensor, 1.0, 2.0);
+        structure_tensor_eigenvalues(image, ev, 1.0, 2.0);
+        for(index_t i=0; i<shape[0]; ++i)
+        {
+            for(index_t j=0; j<shape[1]; ++j)
+            {
+                auto expected = symmetric_eigenvalues(tensor(i, j));
+                EXPECT_NEAR(ev(i, j)[0], expected[0], 1e-5f);
+                EXPECT_NEAR(ev(i, j)[1], expected[1], 1e-5f);
+                EXPECT_GE(ev(i, j)[0], ev(i, j)[1]);
+            }
+        }
+    }
+
+    TEST(tensor_features, hessian)
+    {
+        shape_t<3> shape{20, 24, 28};
+        array_nd<double, 3> volume(shape);
+        for(index_t i=0; i<shape[0]; ++i)
+        {
+            for(index_t j=0; j<shape[1]; ++j)
+            {
+                for(index_t k=0; k<shape[2]; ++k)
+                {
+                    // Hessian: [[2, 1, 0], [1, 2, 0], [0, 0, 5]]
+                    volume(i, j, k) = i*i + i*j + j*j + 2.5*k*k;
+                }
+            }
+        }
+
+        array_nd<tiny_vector<double, 6>, 3> hessian(shape);
+        hessian_of_gaussian(volume, hessian, 1.0);
+        array_nd<tiny_vector<double, 3>, 3> ev(shape);
+        hessian_eigenvalues(volume, ev, 1.0);
+
+        tiny_vector<double, 6> expected{2.0, 1.0, 0.0, 2.0, 0.0, 5.0};
+        for(index_t i=6; i<shape[0]-6; ++i)
+        {
+            for(index_t j=6; j<shape[1]-6; ++j)
+            {
+                for(index_t k=6; k<shape[2]-6; ++k)
+                {
+                    for(index_t c=0; c<6; ++c)
+                    {
+                        EXPECT_NEAR(hessian(i, j, k)[c], expected[c], 1e-8);
+                    }
+                    EXPECT_NEAR(ev(i, j, k)[0], 5.0, 1e-8);
+                    EXPECT_NEAR(ev(i, j, k)[1], 3.0, 1e-8);
+                    EXPECT_NEAR(ev(i, j, k)[2], 1.0, 1e-8);
+                }
+            }
+        }
+
+        array_nd<tiny_vector<double, 3>, 3> wrong(shape);
+        EXPECT_THROW(hessian_of_gaussian(volume, wrong, 1.0), std::runtime_error);
+    }
+
+    TEST(tensor_features, tile_overhead)
+    {
+        // the slab overlap must add at most 25% to the processed rows
+        index_t tile_size = default_tensor_feature_tile_size();
+        for(index_t budget: {1, 100, 1 << 18})
+        {
+            default_tensor_feature_tile_size() = budget;
+            for(index_t halo: {0, 3, 17})
+            {
+                for(index_t rows: {1, 50, 137, 1000, 5000})
+                {
+                    array_nd<float, 2> a(shape_t<2>{rows, 16});
+                    index_t processed = 0, next = 0;
+                    detail::for_each_tensor_feature_tile(a, halo,
+                        [&](auto const & slab, index_t core_begin, index_t core_end, index_t out_begin)
+                        {
+                            EXPECT_EQ(out_begin, next);
+                            EXPECT_TRUE(0 <= core_begin && core_begin <= halo);
+                            EXPECT_TRUE(core_end <= slab.shape(0) && slab.shape(0) - core_end <= halo);
+                            processed += slab.shape(0);
+                            next += core_end - core_begin;
+                        });
+                    EXPECT_EQ(next, rows);
+                    EXPECT_LE(4*processed, 5*rows);
+                }
+            }
+        }
+        default_tensor_feature_tile_size() = tile_size;
+    }
+
+    TEST(tensor_features, tiles)
+    {
+        // results must not depend on the slab decomposition
+        shape_t<3> shape{200, 6, 7};
+        array_nd<double, 3> volume(shape);
+        index_t k = 0;
+        for(auto & v: volume)
+        {
+            v = std::sin(0.37*k) + std::cos(0.011*k*k);
+            ++k;
+        }
+
+        array_nd<tiny_vector<double, 6>, 3> tensor(shape), tensor_tiled(shape),
+                                            hessian(shape), hessian_tiled(shape);
+        array_nd<tiny_vector<double, 3>, 3> ev(shape), ev_tiled(shape),
+                                            hev(shape), hev_tiled(shape);
+        structure_tensor(volume, tensor, 1.0, 2.0);
+        structure_tensor_eigenvalues(volume, ev, 1.0, 2.0);
+        hessian_of_gaussian(volume, hessian, 1.0);
+        hessian_eigenvalues(volume, hev, 1.0);
+
+        index_t tile_size = default_tensor_feature_tile_size();
+        default_tensor_feature_tile_size() = 1; // slabs of the minimal thickness
+        structure_tensor(volume, tensor_tiled, 1.0, 2.0);
+        structure_tensor_eigenvalues(volume, ev_tiled, 1.0, 2.0);
+        hessian_of_gaussian(volume, hessian_tiled, 1.0);
+        hessian_eigenvalues(volume, hev_tiled, 1.0);
+        default_tensor_feature_tile_size() = tile_size;
+
+        for(index_t i=0; i<shape[0]; ++i)
+        {
+            for(index_t j=0; j<shape[1]; ++j)
+            {
+                for(index_t l=0; l<shape[2]; ++l)
+                {
+                    for(index_t c=0; c<6; ++c)
+                    {
+                        EXPECT_NEAR(tensor(i, j, l)[c], tensor_tiled(i, j, l)[c], 1e-8);
+                        EXPECT_NEAR(hessian(i, j, l)[c], hessian_tiled(i, j, l)[c], 1e-8);
+                    }
+                    for(index_t c=0; c<3; ++c)
+                    {
+                        EXPECT_NEAR(ev(i, j, l)[c], ev_tiled(i, j, l)[c], 1e-8);
+                        EXPECT_NEAR(hev(i, j, l)[c], hev_tiled(i, j, l)[c], 1e-8);
+                    }
+                }
+            }
+        }
+    }
+} // namespace xvigra
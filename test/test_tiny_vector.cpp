@@ -656,6 +656,69 @@ namespace xvigra
         EXPECT_NEAR(norm_l2(ivv), sqrt(3.0*norm_sq(iv3)), 1e-14);
     }
 
+    template <class T, index_t N>
+    void check_simd_arithmetic()
+    {
+        using V = tiny_vector<T, N>;
+        V a(dont_init), b(dont_init);
+        for(index_t k=0; k<N; ++k)
+        {
+            a[k] = T(k + 1);
+            b[k] = T(2*N - 3*k);
+        }
+
+        V sum_ab = a + b, diff = a - b, product = a * b, scaled = a * T(3),
+          lower = min(a, b), upper = max(a, b);
+        T d = T(), s = T(), n1 = T(), n2 = T();
+        for(index_t k=0; k<N; ++k)
+        {
+            EXPECT_EQ(sum_ab[k], T(a[k] + b[k]));
+            EXPECT_EQ(diff[k], T(a[k] - b[k]));
+            EXPECT_EQ(product[k], T(a[k] * b[k]));
+            EXPECT_EQ(scaled[k], T(a[k] * 3));
+            EXPECT_EQ(lower[k], std::min(a[k], b[k]));
+            EXPECT_EQ(upper[k], std::max(a[k], b[k]));
+            d  += a[k] * b[k];
+            s  += b[k];
+            n1 += b[k] < 0 ? T(-b[k]) : b[k];
+            n2 += b[k] * b[k];
+        }
+        EXPECT_EQ(dot(a, b), d);
+        EXPECT_EQ(sum(b), s);
+        EXPECT_EQ(norm_l1(b), (decltype(norm_l1(b)))n1);
+        EXPECT_EQ(norm_sq(b), (decltype(norm_sq(b)))n2);
+
+        V c = a;
+        c += b;
+        c -= T(1);
+        c *= a;
+        for(index_t k=0; k<N; ++k)
+        {
+            EXPECT_EQ(c[k], T((a[k] + b[k] - 1) * a[k]));
+        }
+    }
+
+    TEST(tiny_vector, simd_arithmetic)
+    {
+        // widths 2-8 cover whole SIMD batches as well as scalar remainders
+        check_simd_arithmetic<float, 2>();
+        check_simd_arithmetic<float, 3>();
+        check_simd_arithmetic<float, 4>();
+        check_simd_arithmetic<float, 5>();
+        check_simd_arithmetic<float, 8>();
+        check_simd_arithmetic<double, 2>();
+        check_simd_arithmetic<double, 3>();
+        check_simd_arithmetic<double, 4>();
+        check_simd_arithmetic<double, 7>();
+        check_simd_arithmetic<int32_t, 4>();
+        check_simd_arithmetic<int32_t, 6>();
+        check_simd_arithmetic<int32_t, 8>();
+
+        tiny_vector<float, 4> a{1.0f, 2.0f, 4.0f, 8.0f};
+        EXPECT_EQ(a / 2.0f, (tiny_vector<float, 4>{0.5f, 1.0f, 2.0f, 4.0f}));
+        EXPECT_EQ(a / a, (tiny_vector<float, 4>(4, 1.0f)));
+    }
+
     TEST(tiny_vector, traits)
     {
         static const bool um1 = tiny_vector<int, runtime_size>::may_use_uninitialized_memory;
@@ -0,0 +1,118 @@
+/************************************************************************/
+/*                                                                      */
+/*     Copyright 2017-2018 by Ullrich Koethe                            */
+/*                                                                      */
+/*    This file is part of the XVIGRA image analysis library.           */
+/*                                                                      */
+/*    Permission is hereby granted, free of charge, to any person       */
+/*    obtaining a copy of this software and associated documentation    */
+/*    files (the "Software"), to deal in the Software without           */
+/*    restriction, including without limitation the rights to use,      */
+/*    copy, modify, merge, publish, distribute, sublicense, and/or      */
+/*    sell copies of the Software, and to permit persons to whom the    */
+/*    Software is furnished to do so, subject to the following          */
+/*    conditions:                                                       */
+/*                                                                      */
+/*    The above copyright notice and this permission notice shall be    */
+/*    included in all copies or substantial portions of the             */
+/*    Software.                                                         */
+/*                                                                      */
+/*    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND    */
+/*    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES   */
+/*    OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND          */
+/*    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT       */
+/*    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,      */
+/*    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING      */
+/*    FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR     */
+/*    OTHER DEALINGS IN THE SOFTWARE.                                   */
+/*                                                                      */
+/************************************************************************/
+
+#include "unittest.hpp"
+#include <xvigra/transpose.hpp>
+
+namespace xvigra
+{
+    template <class T, index_t N>
+    void fill_linear(array_nd<T, N> & a)
+    {
+        for(index_t k=0; k<a.size(); ++k)
+        {
+            a.raw_data()[k] = T(k);
+        }
+    }
+
+    TEST(transpose, matrix)
+    {
+        // odd sizes exercise the SIMD remainders and the recursive splitting
+        for(auto shape: {shape_t<2>{1, 1}, shape_t<2>{3, 5}, shape_t<2>{67, 131}, shape_t<2>{200, 3}})
+        {
+            array_nd<float, 2> a(shape);
+            fill_linear(a);
+            array_nd<float, 2> ref(a.transpose());
+
+            for(bool simd: {false, true})
+            {
+                for(index_t threads: {1, 3})
+                {
+                    auto options = transpose_options().threads(threads).use_simd(simd);
+                    options.min_elements_per_thread = 1;
+
+                    array_nd<float, 2> res = materialize(a.transpose(), options);
+                    EXPECT_EQ(res.shape(), ref.shape());
+                    EXPECT_EQ(res.strides(), shape_to_strides(res.shape()));
+                    EXPECT_EQ(res, ref);
+
+                    array_nd<double, 2> dres(ref.shape());
+                    transpose_copy(a.transpose(), dres, options);
+                    EXPECT_TRUE(all(equal(dres, ref)));
+
+                    array_nd<double, 2> dd(a.transpose()), dd_res(shape);
+                    transpose_copy(dd.transpose(), dd_res, options);
+                    EXPECT_TRUE(all(equal(dd_res, a)));
+                }
+            }
+        }
+    }
+
+    TEST(transpose, permutation)
+    {
+        array_nd<int, 3> a(shape_t<3>{17, 9, 5});
+        fill_linear(a);
+
+        shape_t<3> permutations[] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+        for(auto const & p: permutations)
+        {
+            auto options = transpose_options().threads(4);
+            options.min_elements_per_thread = 16;
+
+            auto v = a.transpose(p);
+            array_nd<int, 3> res = materialize(v, options);
+            EXPECT_EQ(res.shape(), v.shape());
+            EXPECT_EQ(res.strides(), shape_to_strides(res.shape()));
+            EXPECT_EQ(res, v);
+
+            // runtime dimension and strided input
+            view_nd<int> dynamic_view(a);
+            array_nd<int> dynamic_res(shape_t<>(v.shape().begin(), v.shape().end()));
+            transpose_copy(dynamic_view.transpose(p), dynamic_res, options);
+            EXPECT_TRUE(all(equal(dynamic_res, v)));
+        }
+
+        // channel-last to channel-first
+        array_nd<float, 3> rgb(shape_t<3>{6, 7, 3});
+        fill_linear(rgb);
+        array_nd<float, 3> planar = materialize(rgb.transpose(shape_t<3>{2, 0, 1}));
+        EXPECT_EQ(planar.shape(), (shape_t<3>{3, 6, 7}));
+        for(index_t c=0; c<3; ++c)
+        {
+            for(index_t y=0; y<6; ++y)
+            {
+                for(index_t x=0; x<7; ++x)
+                {
+                    EXPECT_EQ(planar(c, y, x), rgb(y, x, c));
+                }
+            }
+        }
+    }
+} // namespace xvigra